@@ -67,7 +67,7 @@ enum ProxyType
 #define DEFINE_SETTING_ADVANCED(funcName, cfgEntryName, typeName, defVal) \
 	virtual typeName Get ## funcName() const { return GetSetting<typeName>(cfgEntryName, defVal); } \
 	virtual void Set ## funcName(typeName value) { SetSetting<typeName>(cfgEntryName, value); } \
-	virtual void Reset ## funcName() { config->DeleteEntry(cfgEntryName); }
+	virtual void Reset ## funcName() { GetConfig()->DeleteEntry(cfgEntryName); }
 
 #define DEFINE_SETTING(settingName, typeName, defVal) \
 	DEFINE_SETTING_ADVANCED(settingName, STR_VALUE(settingName), typeName, defVal)
@@ -75,7 +75,7 @@ enum ProxyType
 #define DEFINE_FN_SETTING_ADVANCED(funcName, cfgEntryName, defVal) \
 	virtual wxFileName Get ## funcName() const { return GetSetting(cfgEntryName, defVal); } \
 	virtual void Set ## funcName(wxFileName value) { SetSetting(cfgEntryName, value); } \
-	virtual void Reset ## funcName() { config->DeleteEntry(cfgEntryName); }
+	virtual void Reset ## funcName() { GetConfig()->DeleteEntry(cfgEntryName); }
 
 #define DEFINE_FN_SETTING(settingName, defVal) \
 	DEFINE_FN_SETTING_ADVANCED(settingName, STR_VALUE(settingName), defVal)
@@ -83,7 +83,7 @@ enum ProxyType
 #define DEFINE_ENUM_SETTING_ADVANCED(funcName, cfgEntryName, typeName, defVal) \
 	virtual typeName Get ## funcName() const { return (typeName)GetSetting<int>(cfgEntryName, defVal); } \
 	virtual void Set ## funcName(typeName value) { SetSetting<int>(cfgEntryName, value); } \
-	virtual void Reset ## funcName() { config->DeleteEntry(cfgEntryName); };
+	virtual void Reset ## funcName() { GetConfig()->DeleteEntry(cfgEntryName); };
 
 #define DEFINE_ENUM_SETTING(settingName, typeName, defVal) \
 	DEFINE_ENUM_SETTING_ADVANCED(settingName, STR_VALUE(settingName), typeName, defVal)
@@ -102,7 +102,7 @@ public:
 	virtual long GetLanguageID() const;
 	virtual wxString GetLanguage() const;
 	virtual void SetLanguage(wxString value) { SetSetting<wxString>("Language", value); }
-	virtual void ResetLanguage() { config->DeleteEntry("Language"); }
+	virtual void ResetLanguage() { GetConfig()->DeleteEntry("Language"); }
 
 	DEFINE_SETTING(UseSystemLang, bool, true);
 
@@ -133,13 +133,17 @@ public:
 	DEFINE_SETTING(ProxyPassword, wxString, wxEmptyString);
 	DEFINE_SETTING(ProxyDNS, bool, true);
 
+	DEFINE_SETTING(MaxDownloadConnections, int, 4);
+
 	DEFINE_FN_SETTING_ADVANCED(InstDir, "InstanceDir", wxFileName::DirName("instances"));
 	DEFINE_FN_SETTING(ModsDir, wxFileName::DirName("mods"));
 	DEFINE_FN_SETTING(IconsDir, wxFileName::DirName("icons"));
 	DEFINE_FN_SETTING(LwjglDir, wxFileName::DirName("lwjgl"));
+	DEFINE_FN_SETTING(LibCacheDir, wxFileName::DirName("libcache"));
 
 	DEFINE_SETTING(AutoCloseConsole, bool, true);
 	DEFINE_SETTING(ShowConsole, bool, true);
+	DEFINE_SETTING(ConsoleMaxLines, int, 10000);
 
 	DEFINE_SETTING(AutoUpdate, bool, true);
 	DEFINE_SETTING(UseDevBuilds, bool, false);
@@ -163,12 +167,15 @@ public:
 		return true;
 	}
 protected:
-	wxFileConfig *config;
+	// Instances override this to open their config on first use.
+	virtual wxFileConfig *GetConfig() const { return config; }
+
+	mutable wxFileConfig *config;
 	template <typename T>
 	T GetSetting(const wxString &key, T defValue) const
 	{
 		T val;
-		if (config->Read(key, &val))
+		if (GetConfig()->Read(key, &val))
 			return val;
 		else
 			return defValue;
@@ -177,15 +184,15 @@ protected:
 	template <typename T>
 	void SetSetting(const wxString &key, T value, bool suppressErrors = false)
 	{
-		if (!config->Write(key, value) && !suppressErrors)
+		if (!GetConfig()->Write(key, value) && !suppressErrors)
 			wxLogError(_("Failed to write config setting %s"), key.c_str());
-		config->Flush();
+		GetConfig()->Flush();
 	};
 	
 	wxFileName GetSetting(const wxString &key, wxFileName defValue) const
 	{
 		wxString val;
-		if (config->Read(key, &val))
+		if (GetConfig()->Read(key, &val))
 		{
 			if (defValue.IsDir())
 				return wxFileName::DirName(val);
@@ -198,9 +205,9 @@ protected:
 	void SetSetting(const wxString &key, wxFileName value, bool suppressErrors = false)
 	{
 		// Always use Unix paths when saving settings.
-		if (!config->Write(key, value.GetFullPath(wxPATH_UNIX)) && !suppressErrors)
+		if (!GetConfig()->Write(key, value.GetFullPath(wxPATH_UNIX)) && !suppressErrors)
 			wxLogError(_("Failed to write config setting %s"), key.c_str());
-		config->Flush();
+		GetConfig()->Flush();
 	};
 };
 
@@ -16,17 +16,14 @@
 
 #include "configpack.h"
 
-#include <boost/property_tree/json_parser.hpp>
-#include <boost/foreach.hpp>
-
 #include <wx/wfstream.h>
 #include <wx/zipstrm.h>
 #include <wx/sstream.h>
 
 #include <string>
-#include <sstream>
 
 #include "utils/apputils.h"
+#include "utils/feedparser.h"
 
 #include <memory>
 
@@ -48,74 +45,98 @@ ConfigPack::ConfigPack(const wxString& fileName)
 		entry.reset(zipIn.GetNextEntry());
 	} while (entry.get() != nullptr && entry->GetInternalName() != "modpack.json");
 	
-	// Read the file into a stringstream so boost can parse it
-	auto e = entry.get();
-	if(!e)
+	if(!entry.get())
 		return;
-	char * raw_buf = new char[e->GetSize()+1];
-	zipIn.Read(raw_buf,e->GetSize());
-	raw_buf[e->GetSize()] = 0;
-	std::stringstream jsonIn(raw_buf);
-	delete[] raw_buf;
-	
-	using namespace boost::property_tree;
-	try
-	{
-		ptree pt;
-		read_json(jsonIn, pt);
 
-		m_packName = wxStr(pt.get<std::string>("name"));
-		if(pt.count("MCversion"))
+	// Parse modpack.json straight out of the zip.
+	JsonStreamParser parser;
+	bool haveName = false;
+	bool haveNotes = false;
+	bool haveJarMods = false;
+	bool haveMLMods = false;
+	bool badMod = false;
+	wxString modID;
+	wxString modVersion;
+	int modFields = 0;
+	m_minecraftVersion = MCVer_Unknown;
+
+	parser.onStartArray = [&] (const std::string &path)
+	{
+		if (path == "jarmods")
+			haveJarMods = true;
+		else if (path == "mlmods")
+			haveMLMods = true;
+	};
+	parser.onStartObject = [&] (const std::string &path)
+	{
+		if (path == "jarmods/[]" || path == "mlmods/[]" || path == "coremods/[]")
+			modFields = 0;
+	};
+	parser.onValue = [&] (const std::string &path, const std::string &value)
+	{
+		if (path == "name")
 		{
-			m_minecraftVersion = wxStr(pt.get<std::string>("MCversion"));
+			m_packName = wxStr(value);
+			haveName = true;
 		}
-		else
+		else if (path == "notes")
 		{
-			m_minecraftVersion = MCVer_Unknown;
+			m_packNotes = wxStr(value);
+			haveNotes = true;
 		}
-		m_packNotes = wxStr(pt.get<std::string>("notes"));
-
-		// Load the jar mod list.
-		BOOST_FOREACH(const ptree::value_type& v, pt.get_child("jarmods"))
+		else if (path == "MCversion")
 		{
-			wxString id = wxStr(v.second.get<std::string>("id"));
-			wxString version = wxStr(v.second.get<std::string>("version"));
-
-			jarModInfoList.push_back(CPModInfo(id, version));
+			m_minecraftVersion = wxStr(value);
 		}
-		
-		// Load the ML mod list.
-		BOOST_FOREACH(const ptree::value_type& v, pt.get_child("mlmods"))
+		else if (path.size() > 6 && path.compare(path.size() - 6, 6, "/[]/id") == 0)
 		{
-			std::string idstr =v.second.get<std::string>("id");
-			std::string vstr =v.second.get<std::string>("version");
-			wxString id = wxStr(idstr);
-			wxString version = wxStr(vstr);
-
-			mlModInfoList.push_back(CPModInfo(id, version));
+			modID = wxStr(value);
+			modFields |= 1;
 		}
+		else if (path.size() > 11 && path.compare(path.size() - 11, 11, "/[]/version") == 0)
+		{
+			modVersion = wxStr(value);
+			modFields |= 2;
+		}
+	};
+	parser.onEndObject = [&] (const std::string &path)
+	{
+		std::vector<CPModInfo> *list = nullptr;
+		if (path == "jarmods/[]")
+			list = &jarModInfoList;
+		else if (path == "mlmods/[]")
+			list = &mlModInfoList;
 		// older config packs don't have to have core mods...
-		try
+		else if (path == "coremods/[]")
+			list = &coreModInfoList;
+		else
+		{
+			return;
+		}
+
+		if (modFields != 3)
 		{
-			auto coremods = pt.get_child("coremods");
-			// Load the core mod list.
-			BOOST_FOREACH(const ptree::value_type& v, coremods)
-			{
-				wxString id = wxStr(v.second.get<std::string>("id"));
-				wxString version = wxStr(v.second.get<std::string>("version"));
-
-				coreModInfoList.push_back(CPModInfo(id, version));
-			}
+			badMod = true;
+			parser.Stop();
+			return;
 		}
-		catch(ptree_bad_path e){};
+		list->push_back(CPModInfo(modID, modVersion));
+	};
+
+	char buf[16 * 1024];
+	while (zipIn.Read(buf, sizeof(buf)).LastRead() > 0)
+	{
+		if (!parser.Feed(buf, zipIn.LastRead()))
+			break;
 	}
-	catch (json_parser_error e)
+	
+	if (!parser.Finish())
 	{
 		wxLogError(_("Invalid config pack. Failed to parse JSON. At line %i: %s"),
-			e.line(), wxStr(e.message()).c_str());
+			parser.GetLine(), wxStr(parser.GetError()).c_str());
 		return;
 	}
-	catch (ptree_error)
+	if (badMod || !haveName || !haveNotes || !haveJarMods || !haveMLMods)
 	{
 		wxLogError(_("Invalid config pack."));
 		return;
@@ -32,6 +32,7 @@
 #include "insticonlist.h"
 #include "java/javautils.h"
 #include "instancemodel.h"
+#include "instanceindex.h"
 #include "mcprocess.h"
 #include "mcversionlist.h"
 
@@ -42,8 +43,18 @@ bool IsValidInstance(wxFileName rootDir)
 	return rootDir.DirExists() && wxFileExists(Path::Combine(rootDir, cfgFileName));
 }
 
-Instance *Instance::LoadInstance(wxString rootDir)
+Instance *Instance::LoadInstance(wxString rootDir, const InstanceMetadata *cached)
 {
+	if (cached)
+	{
+		switch (cached->type)
+		{
+		case INST_TYPE_STANDARD:
+		default:
+			return new StdInstance(rootDir, cached);
+		}
+	}
+
 	if (IsValidInstance(wxFileName::DirName(rootDir)))
 	{
 		wxFileConfig fcfg(wxEmptyString, wxEmptyString, 
@@ -68,21 +79,27 @@ Instance *Instance::LoadInstance(wxString rootDir)
 		return NULL;
 }
 
-Instance::Instance(const wxString &rootDir)
-	: modList(this), m_running(false)
+Instance::Instance(const wxString &rootDir, const InstanceMetadata *cached)
+	: modList(this), modInfoCache(std::make_shared<ModInfoCache>(Path::Combine(rootDir, "modcache"), rootDir)), m_running(false)
 {
 	if (!rootDir.EndsWith("/"))
 		this->rootDir = wxFileName::DirName(rootDir + "/");
 	else
 		this->rootDir = wxFileName::DirName(rootDir);
-	config = new wxFileConfig(wxEmptyString, wxEmptyString, GetConfigPath().GetFullPath(), wxEmptyString,
-		wxCONFIG_USE_LOCAL_FILE | wxCONFIG_USE_RELATIVE_PATH);
-	MkDirs();
+
+	config = nullptr;
+	if (cached)
+		m_cached.reset(new InstanceMetadata(cached->Clone()));
+	else
+		GetConfig();
 
 	// initialize empty mod lists - they are filled later and only if requested (see apropriate Get* methods)
 	modList.SetDir(GetInstModsDir().GetFullPath());
 	mlModList.SetDir(GetMLModsDir().GetFullPath());
 	coreModList.SetDir(GetCoreModsDir().GetFullPath());
+	modList.SetInfoCache(modInfoCache.get());
+	mlModList.SetInfoCache(modInfoCache.get());
+	coreModList.SetInfoCache(modInfoCache.get());
 	worldList.SetDir(GetSavesDir().GetFullPath());
 	tpList.SetDir(GetTexturePacksDir().GetFullPath());
 	modloader_list_inited = false;
@@ -90,13 +107,48 @@ Instance::Instance(const wxString &rootDir)
 	jar_list_inited = false;
 	world_list_initialized = false;
 	tp_list_initialized = false;
+	// the index has the mod IDs as of its mods folder times, which matched
+	m_modIDsRead = cached != nullptr;
+	if (cached)
+		m_modIDs = cached->modIDs;
 	parentModel = nullptr;
-	UpdateVersion();
+
+	// The index only matches if the jar didn't change, so the version is up to date.
+	if (!cached)
+		UpdateVersion();
+}
+
+wxFileConfig *Instance::GetConfig() const
+{
+	if (!config)
+	{
+		config = new wxFileConfig(wxEmptyString, wxEmptyString, GetConfigPath().GetFullPath(), wxEmptyString,
+			wxCONFIG_USE_LOCAL_FILE | wxCONFIG_USE_RELATIVE_PATH);
+		MkDirs();
+	}
+	return config;
+}
+
+InstanceMetadata Instance::GetMetadata()
+{
+	InstanceMetadata meta;
+	meta.Stat(rootDir.GetFullPath());
+	meta.type = GetType();
+	meta.name = GetName();
+	meta.iconKey = GetSetting<wxString>("iconKey", "default");
+	meta.jarVersion = GetJarVersion();
+	meta.lastLaunch = GetLastLaunch();
+	meta.notes = GetNotes();
+	if (!ModIDsKnown())
+		SetModIDs(ReadModIDs(GetModDirs(), modInfoCache.get()));
+	meta.modIDs = GetModIDs();
+	return meta;
 }
 
 Instance::~Instance(void)
 {
 	delete config;
+	modInfoCache->Save();
 	Save();
 }
 
@@ -135,7 +187,7 @@ void Instance::UpdateVersion ( bool keep_current )
 
 
 // Makes ALL the directories! \o/
-void Instance::MkDirs()
+void Instance::MkDirs() const
 {
 	if (!GetRootDir().DirExists())
 		GetRootDir().Mkdir();
@@ -241,6 +293,11 @@ wxFileName Instance::GetInstModsDir() const
 	return wxFileName::DirName(Path::Combine(GetRootDir().GetFullPath(), "instMods"));
 }
 
+wxFileName Instance::GetLaunchLogDir() const
+{
+	return wxFileName::DirName(Path::Combine(GetRootDir().GetFullPath(), "logs"));
+}
+
 wxFileName Instance::GetVersionFile() const
 {
 	return wxFileName::FileName(GetBinDir().GetFullPath() + "/version");
@@ -256,6 +313,11 @@ wxFileName Instance::GetMCJar() const
 	return wxFileName::FileName(GetBinDir().GetFullPath() + "/minecraft.jar");
 }
 
+wxFileName Instance::GetMCJarManifest() const
+{
+	return wxFileName::FileName(GetBinDir().GetFullPath() + "/minecraft.jar.manifest");
+}
+
 wxFileName Instance::GetModListFile() const
 {
 	return wxFileName::FileName(Path::Combine(GetRootDir(), "modlist"));
@@ -299,6 +361,8 @@ void Instance::WriteVersionFile(int64_t number)
 
 wxString Instance::GetName() const
 {
+	if (!config && m_cached)
+		return m_cached->name;
 	return GetSetting<wxString>("name", _("Unnamed Instance"));
 }
 
@@ -311,7 +375,11 @@ void Instance::SetName(wxString name)
 
 wxString Instance::GetIconKey() const
 {
-	wxString iconKey = GetSetting<wxString>("iconKey", "default");
+	wxString iconKey;
+	if (!config && m_cached)
+		iconKey = m_cached->iconKey;
+	else
+		iconKey = GetSetting<wxString>("iconKey", "default");
 	return InstIconList::getRealIconKeyForEasterEgg(iconKey,GetName());
 }
 
@@ -322,12 +390,16 @@ void Instance::SetIconKey(wxString iconKey)
 
 wxString Instance::GetNotes() const
 {
+	if (!config && m_cached)
+		return m_cached->notes;
 	return GetSetting<wxString>("notes", wxEmptyString);
 }
 
 void Instance::SetNotes(wxString notes)
 {
 	SetSetting<wxString>("notes", notes);
+	if(parentModel)
+		parentModel->InstanceInfoChanged(this);
 }
 
 bool Instance::ShouldRebuild() const
@@ -388,6 +460,91 @@ ModList *Instance::GetCoreModList()
 	return &coreModList;
 }
 
+static void AppendModID(const Mod &mod, wxString &ids)
+{
+	wxString id = mod.GetModID();
+	if (id.IsEmpty())
+		id = mod.GetName();
+	if (!ids.IsEmpty())
+		ids << " ";
+	ids << id;
+}
+
+// Goes through subfolders like the folder mod lists do.
+static void AddModIDs(const wxString &dir, ModInfoCache *cache, wxString &ids)
+{
+	if (!wxDirExists(dir))
+		return;
+	wxDir modDir(dir);
+	if (!modDir.IsOpened())
+		return;
+
+	wxString name;
+	bool cont = modDir.GetFirst(&name);
+	while (cont)
+	{
+		wxString path = Path::Combine(dir, name);
+		if (wxDirExists(path))
+			AddModIDs(path, cache, ids);
+		else
+			AppendModID(Mod(wxFileName(path), cache), ids);
+		cont = modDir.GetNext(&name);
+	}
+}
+
+wxArrayString Instance::GetModDirs() const
+{
+	wxArrayString dirs;
+	dirs.Add(GetInstModsDir().GetFullPath());
+	dirs.Add(GetMLModsDir().GetFullPath());
+	dirs.Add(GetCoreModsDir().GetFullPath());
+	return dirs;
+}
+
+wxString Instance::ReadModIDs(const wxArrayString &modDirs, ModInfoCache *cache)
+{
+	wxString ids;
+	for (size_t i = 0; i < modDirs.size(); i++)
+		AddModIDs(modDirs[i], cache, ids);
+	return ids;
+}
+
+wxString Instance::GetModIDs()
+{
+	// loaded mod lists are the most up to date
+	if (jar_list_inited && modloader_list_inited && coremod_list_inited)
+	{
+		wxString ids;
+		ModList *lists[] = { &modList, &mlModList, &coreModList };
+		for (int i = 0; i < 3; i++)
+		{
+			for (auto iter = lists[i]->begin(); iter != lists[i]->end(); iter++)
+				AppendModID(*iter, ids);
+		}
+		return ids;
+	}
+	return m_modIDs;
+}
+
+bool Instance::ModIDsKnown() const
+{
+	return m_modIDsRead || (jar_list_inited && modloader_list_inited && coremod_list_inited);
+}
+
+void Instance::SetModIDs(const wxString &ids)
+{
+	m_modIDs = ids;
+	m_modIDsRead = true;
+}
+
+void Instance::ModsChanged()
+{
+	// The old IDs stay until the model has read the new ones.
+	m_modIDsRead = false;
+	if(parentModel)
+		parentModel->InstanceModsChanged(this);
+}
+
 WorldList *Instance::GetWorldList()
 {
 	if (!world_list_initialized)
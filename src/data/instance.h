@@ -17,6 +17,7 @@
 #pragma once
 #include <vector>
 #include <sstream>
+#include <memory>
 #include <stdint.h>
 #include <wx/wx.h>
 #include <wx/filesys.h>
@@ -31,6 +32,7 @@
 #include "worldlist.h"
 #include "texturepack.h"
 #include "texturepacklist.h"
+#include "instanceindex.h"
 
 
 class InstanceModel;
@@ -60,8 +62,9 @@ public:
 		INST_TYPE_STANDARD,
 	};
 
-	static Instance *LoadInstance(wxString rootDir);
-	Instance(const wxString &rootDir);
+	// If cached metadata is given, the config isn't read until something needs it.
+	static Instance *LoadInstance(wxString rootDir, const InstanceMetadata *cached = nullptr);
+	Instance(const wxString &rootDir, const InstanceMetadata *cached = nullptr);
 	~Instance(void);
 	
 	bool Save() const;
@@ -73,6 +76,7 @@ public:
 	// Directories
 	wxFileName GetRootDir() const;
 	wxFileName GetInstModsDir() const;
+	wxFileName GetLaunchLogDir() const;
 	
 	// Minecraft dir subfolders
 	wxFileName GetMCDir() const;
@@ -89,6 +93,7 @@ public:
 	wxFileName GetVersionFile() const;
 	wxFileName GetMCJar() const;
 	wxFileName GetMCBackup() const;
+	wxFileName GetMCJarManifest() const;
 	wxFileName GetModListFile() const;
 	
 	int64_t ReadVersionFile();
@@ -115,6 +120,27 @@ public:
 	ModList *GetMLModList();
 	ModList *GetCoreModList();
 
+	/// IDs of all jar mods, ModLoader mods and core mods, separated by spaces.
+	/// Never touches the disk. Comes from the loaded mod lists, the instance index 
+	/// or SetModIDs, and is empty if none of them has it (see ModIDsKnown).
+	wxString GetModIDs();
+	bool ModIDsKnown() const;
+	void SetModIDs(const wxString &ids);
+
+	/// Jar mod, ModLoader mod and core mod folders
+	wxArrayString GetModDirs() const;
+	/// Reads the mod IDs from the mod folders. Opens every mod the cache doesn't know,
+	/// so call this on a worker thread. Doesn't touch any instance.
+	static wxString ReadModIDs(const wxArrayString &modDirs, ModInfoCache *cache);
+	/// The cache ReadModIDs should use. Shared, so workers can keep it past the instance.
+	std::shared_ptr<ModInfoCache> GetModInfoCache() const
+	{
+		return modInfoCache;
+	}
+
+	/// Call after changing the mods, so the model can update its search index
+	void ModsChanged();
+
 	WorldList *GetWorldList();
 
 	TexturePackList *GetTexturePackList();
@@ -164,7 +190,12 @@ public:
 	}
 	
 	// and these are specific to instances only
-	wxString GetJarVersion() const { return GetSetting<wxString>("JarVersion","Unknown"); };
+	wxString GetJarVersion() const
+	{
+		if (!config && m_cached)
+			return m_cached->jarVersion;
+		return GetSetting<wxString>("JarVersion","Unknown");
+	};
 	void SetJarVersion( wxString value ) {  SetSetting<wxString>("JarVersion", value); };
 
 	wxString GetLwjglVersion() const { return GetSetting<wxString>("LwjglVersion","Mojang"); };
@@ -178,6 +209,9 @@ public:
 	
 	uint64_t GetLastLaunch() const
 	{
+		if (!config && m_cached)
+			return m_cached->lastLaunch;
+
 		// no 64bit type support in wxConfig. This code is very 'meh', but works
 		wxString str = GetSetting<wxString>("lastLaunch", "0").Trim(true).Trim(false);
 		auto buf = str.ToAscii();
@@ -253,6 +287,10 @@ public:
 	
 	/// Make this instance report relevant changes to the model
 	void SetParentModel ( InstanceModel* parent );
+
+	/// Get the metadata to store in the instance index. Reads the config and the mod folders,
+	/// so only the instance loader threads call this.
+	InstanceMetadata GetMetadata();
 	
 protected:
 	JarModList modList;
@@ -260,6 +298,7 @@ protected:
 	InstanceModel * parentModel;
 	FolderModList mlModList;
 	FolderModList coreModList;
+	std::shared_ptr<ModInfoCache> modInfoCache;
 
 	WorldList worldList;
 
@@ -275,6 +314,15 @@ protected:
 	bool jar_list_inited;
 	bool world_list_initialized;
 	bool tp_list_initialized;
+
+	// metadata from the instance index, used until the config is loaded
+	std::unique_ptr<InstanceMetadata> m_cached;
+
+	// mod IDs for GetModIDs
+	wxString m_modIDs;
+	bool m_modIDsRead;
+
+	virtual wxFileConfig *GetConfig() const;
 	
-	void MkDirs();
+	void MkDirs() const;
 };
@@ -0,0 +1,214 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "instanceindex.h"
+#include "instance.h"
+
+#include <wx/filefn.h>
+#include <wx/wfstream.h>
+
+#include "utils/apputils.h"
+#include "utils/datautils.h"
+
+const wxString indexHeader = "MultiMC instance index 2";
+
+// Modification time of a file or folder, or -1 if it doesn't exist.
+static int64_t GetMTime(const wxString &path)
+{
+	if (!wxFileExists(path) && !wxDirExists(path))
+		return -1;
+	return wxFileModificationTime(path);
+}
+
+static bool ParseS64(const wxString &str, int64_t &out)
+{
+	wxLongLong_t value;
+	if (!str.ToLongLong(&value))
+		return false;
+	out = value;
+	return true;
+}
+
+static bool ParseU64(const wxString &str, uint64_t &out)
+{
+	wxULongLong_t value;
+	if (!str.ToULongLong(&value))
+		return false;
+	out = value;
+	return true;
+}
+
+InstanceMetadata::InstanceMetadata()
+	: type(0), dirMTime(-1), cfgMTime(-1), jarMTime(-1), modsMTime(-1), lastLaunch(0)
+{
+	
+}
+
+InstanceMetadata InstanceMetadata::Clone() const
+{
+	InstanceMetadata meta(*this);
+	meta.id = id.Clone();
+	meta.name = name.Clone();
+	meta.iconKey = iconKey.Clone();
+	meta.jarVersion = jarVersion.Clone();
+	meta.group = group.Clone();
+	meta.notes = notes.Clone();
+	meta.modIDs = modIDs.Clone();
+	return meta;
+}
+
+void InstanceMetadata::Stat(const wxString &rootDir)
+{
+	id = wxFileName::DirName(rootDir).GetDirs().Last();
+	dirMTime = GetMTime(rootDir);
+	cfgMTime = GetMTime(Path::Combine(rootDir, "instance.cfg"));
+
+	// same lookup as Instance::GetMCDir and Instance::GetMCJar
+	wxString dotMCDir = Path::Combine(rootDir, ".minecraft");
+	wxString mcDir = Path::Combine(rootDir, "minecraft");
+	if (wxDirExists(dotMCDir) && !wxDirExists(mcDir))
+		mcDir = dotMCDir;
+	jarMTime = GetMTime(Path::Combine(Path::Combine(mcDir, "bin"), "minecraft.jar"));
+
+	// same as Instance::GetInstModsDir, GetMLModsDir and GetCoreModsDir
+	modsMTime = wxMax(GetMTime(Path::Combine(rootDir, "instMods")), 
+		wxMax(GetMTime(Path::Combine(mcDir, "mods")), GetMTime(Path::Combine(mcDir, "coremods"))));
+}
+
+bool InstanceMetadata::SameFiles(const InstanceMetadata &other) const
+{
+	return id == other.id && dirMTime == other.dirMTime && 
+		cfgMTime == other.cfgMTime && jarMTime == other.jarMTime && modsMTime == other.modsMTime && 
+		cfgMTime != -1;
+}
+
+InstanceIndex::InstanceIndex()
+	: m_groupFileMTime(-1)
+{
+	
+}
+
+bool InstanceIndex::Load(const wxString &path)
+{
+	m_instances.clear();
+	m_groupInfo = InstanceGroupInfo();
+	m_groupFileMTime = -1;
+
+	if (!wxFileExists(path))
+		return false;
+
+	wxFFileInputStream inStream(path);
+	if (!inStream.IsOk())
+		return false;
+	wxArrayString lines = ReadAllLines(inStream);
+	if (lines.IsEmpty() || lines[0] != indexHeader)
+		return false;
+
+	for (size_t i = 1; i < lines.size(); i++)
+	{
+		wxArrayString fields = wxSplit(lines[i], '\t', '\0');
+		if (fields.IsEmpty())
+			continue;
+
+		if (fields[0] == "groupfile" && fields.size() == 2)
+		{
+			ParseS64(fields[1], m_groupFileMTime);
+		}
+		else if (fields[0] == "group" && fields.size() == 3)
+		{
+			m_groupInfo.groups.push_back(std::make_pair(UnescapeField(fields[2]), fields[1] == "1"));
+		}
+		else if (fields[0] == "inst" && fields.size() == 14)
+		{
+			InstanceMetadata meta;
+			long type = 0;
+			if (!fields[1].ToLong(&type) ||
+				!ParseS64(fields[2], meta.dirMTime) || !ParseS64(fields[3], meta.cfgMTime) ||
+				!ParseS64(fields[4], meta.jarMTime) || !ParseS64(fields[5], meta.modsMTime) ||
+				!ParseU64(fields[6], meta.lastLaunch))
+			{
+				continue;
+			}
+			meta.type = type;
+			meta.id = UnescapeField(fields[7]);
+			meta.name = UnescapeField(fields[8]);
+			meta.iconKey = UnescapeField(fields[9]);
+			meta.jarVersion = UnescapeField(fields[10]);
+			meta.group = UnescapeField(fields[11]);
+			meta.notes = UnescapeField(fields[12]);
+			meta.modIDs = UnescapeField(fields[13]);
+			m_instances[meta.id] = meta;
+
+			if (!meta.group.IsEmpty())
+				m_groupInfo.instGroups[meta.id] = meta.group;
+		}
+	}
+	return true;
+}
+
+bool InstanceIndex::Save(const wxString &path) const
+{
+	wxString text;
+	text << indexHeader << "\n";
+	text << "groupfile\t" << wxString::Format("%" wxLongLongFmtSpec "d", (wxLongLong_t)m_groupFileMTime) << "\n";
+
+	for (auto iter = m_groupInfo.groups.begin(); iter != m_groupInfo.groups.end(); iter++)
+	{
+		text << "group\t" << (iter->second ? "1" : "0") << "\t" << EscapeField(iter->first) << "\n";
+	}
+
+	for (auto iter = m_instances.begin(); iter != m_instances.end(); iter++)
+	{
+		const InstanceMetadata &meta = iter->second;
+
+		// The group file is the authority on groups.
+		wxString group;
+		auto found = m_groupInfo.instGroups.find(meta.id);
+		if (found != m_groupInfo.instGroups.end())
+			group = found->second;
+
+		text << wxString::Format("inst\t%i\t%" wxLongLongFmtSpec "d\t%" wxLongLongFmtSpec "d\t%" 
+			wxLongLongFmtSpec "d\t%" wxLongLongFmtSpec "d\t%" wxLongLongFmtSpec "u\t", meta.type, 
+			(wxLongLong_t)meta.dirMTime, (wxLongLong_t)meta.cfgMTime, (wxLongLong_t)meta.jarMTime, 
+			(wxLongLong_t)meta.modsMTime, (wxULongLong_t)meta.lastLaunch);
+		text << EscapeField(meta.id) << "\t" << EscapeField(meta.name) << "\t" << EscapeField(meta.iconKey) << "\t"
+			<< EscapeField(meta.jarVersion) << "\t" << EscapeField(group) << "\t" 
+			<< EscapeField(meta.notes) << "\t" << EscapeField(meta.modIDs) << "\n";
+	}
+
+	wxTempFileOutputStream outStream(path);
+	WriteAllText(outStream, text);
+	return outStream.Commit();
+}
+
+const InstanceMetadata *InstanceIndex::Find(const wxString &id) const
+{
+	auto found = m_instances.find(id);
+	if (found == m_instances.end())
+		return nullptr;
+	return &found->second;
+}
+
+void InstanceIndex::Set(const InstanceMetadata &meta)
+{
+	m_instances[meta.id] = meta;
+}
+
+void InstanceIndex::SetGroupInfo(const InstanceGroupInfo &info, int64_t groupFileMTime)
+{
+	m_groupInfo = info;
+	m_groupFileMTime = groupFileMTime;
+}
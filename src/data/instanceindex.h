@@ -0,0 +1,82 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#pragma once
+#include <map>
+#include <stdint.h>
+
+#include <wx/string.h>
+
+#include "instancemodel.h"
+
+// What the instance list needs to know about an instance without reading its config.
+struct InstanceMetadata
+{
+	InstanceMetadata();
+
+	// Reads the modification times of the instance folder, its config, its jar and its mod folders.
+	void Stat(const wxString &rootDir);
+
+	// True if the files were not touched since the metadata was recorded.
+	bool SameFiles(const InstanceMetadata &other) const;
+
+	// A deep copy that can be handed to another thread.
+	InstanceMetadata Clone() const;
+
+	wxString id;
+	int type;
+
+	int64_t dirMTime;
+	int64_t cfgMTime;
+	int64_t jarMTime;
+	// newest of the jar mod, ModLoader mod and core mod folders
+	int64_t modsMTime;
+
+	wxString name;
+	wxString iconKey;
+	wxString jarVersion;
+	wxString group;
+	uint64_t lastLaunch;
+	wxString notes;
+	// IDs of all jar mods, ModLoader mods and core mods, separated by spaces
+	wxString modIDs;
+};
+
+// A single file in the instance folder that holds the metadata of every instance 
+// and the parsed group file, so startup doesn't have to read each instance.cfg.
+class InstanceIndex
+{
+public:
+	InstanceIndex();
+
+	bool Load(const wxString &path);
+	bool Save(const wxString &path) const;
+
+	// Returns the cached metadata for the instance with the given ID or nullptr.
+	const InstanceMetadata *Find(const wxString &id) const;
+	void Set(const InstanceMetadata &meta);
+	size_t GetInstanceCount() const { return m_instances.size(); }
+
+	// The group file info is valid as long as the group file has this mtime.
+	int64_t GetGroupFileMTime() const { return m_groupFileMTime; }
+	const InstanceGroupInfo &GetGroupInfo() const { return m_groupInfo; }
+	void SetGroupInfo(const InstanceGroupInfo &info, int64_t groupFileMTime);
+
+protected:
+	std::map<wxString, InstanceMetadata> m_instances;
+	InstanceGroupInfo m_groupInfo;
+	int64_t m_groupFileMTime;
+};
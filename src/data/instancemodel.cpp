@@ -18,23 +18,111 @@
 
 #include "data/instance.h"
 #include "instancectrl.h"
+#include "trash.h"
+#include "utils/apputils.h"
 #include "utils/fsutils.h"
 
+#include <algorithm>
+
+#include <wx/thread.h>
+
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/foreach.hpp>
 
 #define GROUP_FILE_FORMAT_VERSION 1
 
+DEFINE_EVENT_TYPE(wxEVT_MODIDS_READ)
+
+struct ModIDRequest
+{
+	int id;
+	// only used as a key, the worker never touches the instance
+	Instance *inst;
+	std::shared_ptr<ModInfoCache> cache;
+	wxArrayString modDirs;
+	wxString modIDs;
+};
+
+// Shared by the model and the worker threads, which may outlive it.
+struct ModIDReadState
+{
+	wxMutex lock;
+	// nullptr once the model is gone
+	wxEvtHandler *handler;
+	std::vector<ModIDRequest> results;
+};
+
+// Gets the results to the model on the main thread.
+class ModIDResultHandler : public wxEvtHandler
+{
+public:
+	ModIDResultHandler(InstanceModel *model) : m_model(model) {}
+
+	virtual bool ProcessEvent(wxEvent &event)
+	{
+		if (event.GetEventType() != wxEVT_MODIDS_READ)
+			return wxEvtHandler::ProcessEvent(event);
+		m_model->ModIDsRead();
+		return true;
+	}
+
+protected:
+	InstanceModel *m_model;
+};
+
+class ModIDReadThread : public wxThread
+{
+public:
+	ModIDReadThread(const ModIDRequest &request, std::shared_ptr<ModIDReadState> state)
+		: wxThread(wxTHREAD_DETACHED), m_request(request), m_state(state)
+	{
+		// The thread gets its own copies of the strings.
+		m_request.modDirs.Clear();
+		for (size_t i = 0; i < request.modDirs.size(); i++)
+			m_request.modDirs.Add(request.modDirs[i].Clone());
+	}
+
+protected:
+	virtual ExitCode Entry()
+	{
+		// The instance's own cache. Saved here too, the instance may be gone by now.
+		m_request.modIDs = Instance::ReadModIDs(m_request.modDirs, m_request.cache.get());
+		m_request.cache->Save();
+		m_request.cache.reset();
+
+		wxMutexLocker lock(m_state->lock);
+		m_state->results.push_back(m_request);
+		if (m_state->handler)
+		{
+			wxCommandEvent event(wxEVT_MODIDS_READ);
+			m_state->handler->AddPendingEvent(event);
+		}
+		return (ExitCode)0;
+	}
+
+	ModIDRequest m_request;
+	std::shared_ptr<ModIDReadState> m_state;
+};
+
 InstanceModel::InstanceModel()
 {
 	m_control = nullptr;
 	m_selectedIndex = -1;
 	m_previousIndex = -1;
 	m_freeze_level = 0;
+	m_nextModIDRequest = 0;
+	m_modIDHandler = new ModIDResultHandler(this);
+	m_modIDState = std::make_shared<ModIDReadState>();
+	m_modIDState->handler = m_modIDHandler;
 }
 
 InstanceModel::~InstanceModel()
 {
+	{
+		wxMutexLocker lock(m_modIDState->lock);
+		m_modIDState->handler = nullptr;
+	}
+	delete m_modIDHandler;
 	Clear();
 }
 
@@ -52,6 +140,14 @@ Instance * InstanceModel::operator[](const std::size_t index) const
 	return at(index);
 }
 
+int InstanceModel::IndexOf ( Instance* inst ) const
+{
+	auto found = std::find(m_instances.begin(), m_instances.end(), inst);
+	if (found == m_instances.end())
+		return -1;
+	return found - m_instances.begin();
+}
+
 bool InstanceModel::SelectInstanceByID ( wxString select )
 {
 	for(unsigned i = 0; i < m_instances.size(); i++)
@@ -72,12 +168,16 @@ void InstanceModel::Clear()
 	for(unsigned i = 0; i < size(); i++)
 		delete m_instances[i];
 	m_instances.clear();
+	m_search.Clear();
+	m_modIDRequests.clear();
 	m_previousIndex = -1;
 	m_selectedIndex = -1;
 
 	for (unsigned i = 0; i < m_groups.size(); i++)
 		delete m_groups[i];
 	m_groups.clear();
+	m_groupMap.clear();
+	m_pendingGroups.clear();
 	
 	if(!m_freeze_level && m_control)
 		m_control->ReloadAll();
@@ -88,9 +188,19 @@ std::size_t InstanceModel::Add (Instance * inst, bool do_select)
 {
 	auto idx = size();
 	m_instances.push_back(inst);
+
+	// put it in the group the group file says it belongs to
+	auto found = m_pendingGroups.find(inst->GetInstID());
+	if (found != m_pendingGroups.end())
+	{
+		InstanceGroup *group = GetGroupByName(found->second);
+		if (group != nullptr)
+			m_groupMap[inst] = group;
+	}
+	UpdateSearchIndex(inst);
 	
 	if(!m_freeze_level && m_control)
-		m_control->ReloadAll();
+		m_control->InstanceAdded(idx);
 	
 	inst->SetParentModel(this);
 	return idx;
@@ -99,6 +209,9 @@ std::size_t InstanceModel::Add (Instance * inst, bool do_select)
 void InstanceModel::Remove (std::size_t index)
 {
 	auto inst = m_instances[index];
+	m_search.Remove(inst);
+	m_groupMap.erase(inst);
+	m_modIDRequests.erase(inst);
 	delete inst;
 	
 	if(index == m_selectedIndex)
@@ -109,32 +222,139 @@ void InstanceModel::Remove (std::size_t index)
 		else
 			m_selectedIndex = -1;
 	}
+	// indexes after the removed instance move down
+	else if((int)index < m_selectedIndex)
+	{
+		m_selectedIndex--;
+	}
+	if((int)index == m_previousIndex)
+		m_previousIndex = -1;
+	else if((int)index < m_previousIndex)
+		m_previousIndex--;
 	
 	m_instances.erase(m_instances.begin() + index);
 	
 	if(!m_freeze_level && m_control)
-		m_control->ReloadAll();
+		m_control->InstanceRemoved(index);
 }
 
-void InstanceModel::Delete ( std::size_t index )
+void InstanceModel::Delete ( std::size_t index, wxString *trashID )
 {
 	auto inst = m_instances[index];
-	fsutils::RecursiveDelete(inst->GetRootDir().GetFullPath());
+	Trash::Instance().Delete(inst->GetRootDir().GetFullPath(), trashID);
 	Remove(index);
 }
 
-void InstanceModel::DeleteCurrent()
+void InstanceModel::DeleteCurrent(wxString *trashID)
 {
 	if(m_selectedIndex != -1)
-		Delete(m_selectedIndex);
+		Delete(m_selectedIndex, trashID);
 }
 
 void InstanceModel::InstanceRenamed ( Instance* renamedInstance )
 {
+	UpdateSearchIndex(renamedInstance);
 	if(m_freeze_level == 0 && m_control)
+		m_control->InstanceRenamed(IndexOf(renamedInstance));
+}
+
+void InstanceModel::InstanceInfoChanged ( Instance* changedInstance )
+{
+	UpdateSearchIndex(changedInstance);
+	// only a filtered list can change because of this
+	if(m_freeze_level == 0 && m_control && !m_control->GetFilter().IsEmpty())
 		m_control->ReloadAll();
 }
 
+void InstanceModel::InstanceModsChanged ( Instance* changedInstance )
+{
+	// an older read may have missed the change
+	m_modIDRequests.erase(changedInstance);
+	InstanceInfoChanged(changedInstance);
+}
+
+void InstanceModel::GroupRenamed ( InstanceGroup* group )
+{
+	for (auto iter = m_groupMap.begin(); iter != m_groupMap.end(); iter++)
+	{
+		if (iter->second == group)
+			UpdateSearchIndex(iter->first);
+	}
+}
+
+void InstanceModel::UpdateSearchIndex ( Instance* inst )
+{
+	wxString text = inst->GetName();
+	text << "\n" << inst->GetNotes() << "\n" << inst->GetJarVersion();
+	InstanceGroup *group = GetInstanceGroup(inst);
+	if (group != nullptr)
+		text << "\n" << group->GetName();
+	text << "\n" << inst->GetModIDs();
+	m_search.Set(inst, std::string(text.Lower().ToUTF8()));
+
+	// The rest is indexed right away, the mod IDs once they are read.
+	if (!inst->ModIDsKnown())
+		RequestModIDs(inst);
+}
+
+void InstanceModel::RequestModIDs ( Instance* inst )
+{
+	if (m_modIDRequests.count(inst))
+		return;
+
+	ModIDRequest request;
+	request.id = m_nextModIDRequest++;
+	request.inst = inst;
+	request.cache = inst->GetModInfoCache();
+	request.modDirs = inst->GetModDirs();
+
+	ModIDReadThread *thread = new ModIDReadThread(request, m_modIDState);
+	if (thread->Create() != wxTHREAD_NO_ERROR)
+	{
+		delete thread;
+		return;
+	}
+	thread->SetPriority(WXTHREAD_MIN_PRIORITY);
+	if (thread->Run() == wxTHREAD_NO_ERROR)
+		m_modIDRequests[inst] = request.id;
+}
+
+void InstanceModel::ModIDsRead()
+{
+	std::vector<ModIDRequest> results;
+	{
+		wxMutexLocker lock(m_modIDState->lock);
+		results.swap(m_modIDState->results);
+	}
+
+	bool changed = false;
+	for (auto iter = results.begin(); iter != results.end(); iter++)
+	{
+		// Removed instances and outdated reads are dropped.
+		auto found = m_modIDRequests.find(iter->inst);
+		if (found == m_modIDRequests.end() || found->second != iter->id)
+			continue;
+		m_modIDRequests.erase(found);
+
+		iter->inst->SetModIDs(iter->modIDs);
+		UpdateSearchIndex(iter->inst);
+		changed = true;
+	}
+
+	if(changed && m_freeze_level == 0 && m_control && !m_control->GetFilter().IsEmpty())
+		m_control->ReloadAll();
+}
+
+void InstanceModel::Search ( const wxString& query, std::vector<bool>& matches ) const
+{
+	std::vector<Instance *> found;
+	m_search.Search(std::string(query.Lower().ToUTF8()), found);
+
+	matches.resize(m_instances.size());
+	for (std::size_t i = 0; i < m_instances.size(); i++)
+		matches[i] = std::binary_search(found.begin(), found.end(), m_instances[i]);
+}
+
 void InstanceModel::SetLinkedControl ( InstanceCtrl* ctrl )
 {
 	m_control = ctrl;
@@ -160,8 +380,25 @@ bool InstanceModel::LoadGroupInfo(wxString file)
 	if (file.IsEmpty())
 		file = m_groupFile;
 
-	m_groupMap.clear();
+	InstanceGroupInfo info;
+	if (!ReadGroupInfo(file, info))
+		return false;
+	SetGroupInfo(info);
+	return true;
+}
 
+InstanceGroupInfo InstanceGroupInfo::Clone() const
+{
+	InstanceGroupInfo info;
+	for (auto iter = groups.begin(); iter != groups.end(); ++iter)
+		info.groups.push_back(std::make_pair(iter->first.Clone(), iter->second));
+	for (auto iter = instGroups.begin(); iter != instGroups.end(); ++iter)
+		info.instGroups[iter->first.Clone()] = iter->second.Clone();
+	return info;
+}
+
+bool InstanceModel::ReadGroupInfo(const wxString &file, InstanceGroupInfo &info)
+{
 	using namespace boost::property_tree;
 	ptree pt;
 
@@ -180,28 +417,19 @@ bool InstanceModel::LoadGroupInfo(wxString file)
 			ptree gPt = vp.second;
 			wxString groupName = wxStr(vp.first);
 
-			InstanceGroup *group = new InstanceGroup(groupName, this);
-			m_groups.push_back(group);
-
+			bool hidden = false;
 			if (gPt.get_child_optional("hidden"))
-				group->SetHidden(gPt.get<bool>("hidden"));
+				hidden = gPt.get<bool>("hidden");
+			info.groups.push_back(std::make_pair(groupName, hidden));
 
-			wxArrayString groupInstances;
 			BOOST_FOREACH(const ptree::value_type& v, gPt.get_child("instances"))
 			{
-				groupInstances.Add(wxStr(v.second.data()));
-			}
-
-			for (InstVector::iterator iter = m_instances.begin(); iter < m_instances.end(); iter++)
-			{
-				if (groupInstances.Index((*iter)->GetInstID()) != wxNOT_FOUND)
-					SetInstanceGroup(*iter, groupName);
+				info.instGroups[wxStr(v.second.data())] = groupName;
 			}
 		}
 	}
 	catch (json_parser_error e)
 	{
-		//FIXME: control is left in weird state/desynchronized
 		wxLogError(_("Failed to read group list.\nJSON parser error at line %i: %s"), 
 			e.line(), wxStr(e.message()).c_str());
 		return false;
@@ -214,6 +442,34 @@ bool InstanceModel::LoadGroupInfo(wxString file)
 	return true;
 }
 
+void InstanceModel::SetGroupInfo(const InstanceGroupInfo &info)
+{
+	m_groupMap.clear();
+
+	for (auto iter = info.groups.begin(); iter != info.groups.end(); iter++)
+	{
+		InstanceGroup *group = GetGroupByName(iter->first);
+		if (group == nullptr)
+		{
+			group = new InstanceGroup(iter->first, this);
+			m_groups.push_back(group);
+		}
+		group->SetHidden(iter->second);
+	}
+
+	m_pendingGroups = info.instGroups;
+	for (InstVector::iterator iter = m_instances.begin(); iter < m_instances.end(); iter++)
+	{
+		auto found = m_pendingGroups.find((*iter)->GetInstID());
+		if (found != m_pendingGroups.end())
+			m_groupMap[*iter] = GetGroupByName(found->second);
+		UpdateSearchIndex(*iter);
+	}
+
+	if(!m_freeze_level && m_control)
+		m_control->ReloadAll();
+}
+
 bool InstanceModel::SaveGroupInfo(wxString file) const
 {
 	if (file.IsEmpty())
@@ -278,8 +534,9 @@ bool InstanceModel::SaveGroupInfo(wxString file) const
 void InstanceModel::InstanceGroupChanged ( Instance* changedInstance )
 {
 	SaveGroupInfo();
+	UpdateSearchIndex(changedInstance);
 	if(m_freeze_level == 0 && m_control)
-		m_control->ReloadAll();
+		m_control->InstanceGroupChanged(IndexOf(changedInstance));
 }
 
 void InstanceModel::SetGroupFile(const wxString& groupFile)
@@ -290,6 +547,7 @@ void InstanceModel::SetGroupFile(const wxString& groupFile)
 void InstanceModel::SetInstanceGroup(Instance *inst, wxString groupName)
 {
 	InstanceGroup *prevGroup = GetInstanceGroup(inst);
+	m_pendingGroups.erase(inst->GetInstID());
 
 	if (prevGroup != nullptr)
 	{
@@ -375,6 +633,7 @@ void InstanceModel::DeleteGroup(InstanceGroup* group)
 		if (GetInstanceGroup(*iter) == group)
 		{
 			m_groupMap[*iter] = nullptr;
+			UpdateSearchIndex(*iter);
 		}
 	}
 
@@ -399,6 +658,7 @@ wxString InstanceGroup::GetName() const
 void InstanceGroup::SetName(const wxString& name)
 {
 	m_name = name;
+	m_parent->GroupRenamed(this);
 }
 
 InstanceModel* InstanceGroup::GetParent() const
@@ -20,9 +20,14 @@
 #include <map>
 #include <set>
 #include <vector>
+#include <memory>
+
+#include "instancesearch.h"
 
 class Instance;
 class InstanceCtrl;
+struct ModIDReadState;
+class ModIDResultHandler;
 
 class InstanceModel;
 class InstanceGroup;
@@ -51,6 +56,18 @@ protected:
 
 typedef std::vector<InstanceGroup*> GroupVector;
 
+/// Contents of the group file, before it is applied to any instances
+struct InstanceGroupInfo
+{
+	/// group names and whether they are hidden, in file order
+	std::vector<std::pair<wxString, bool> > groups;
+	/// instance ID -> group name
+	std::map<wxString, wxString> instGroups;
+
+	/// A deep copy that can be handed to another thread
+	InstanceGroupInfo Clone() const;
+};
+
 class InstanceModel
 {
 public:
@@ -67,6 +84,9 @@ public:
 	Instance *at(const std::size_t index) const;
 	Instance * operator[](const std::size_t index) const;
 	
+	/// get the index of an instance, -1 if it's not in the model
+	int IndexOf(Instance *inst) const;
+	
 	/// Link an instance control with this model
 	void SetLinkedControl( InstanceCtrl * ctrl );
 	
@@ -80,10 +100,11 @@ public:
 	void Remove (std::size_t index);
 	
 	/// Delete instance by index (this includes all its files)
-	void Delete (std::size_t index);
+	/// The files go to the trash, trashID is set if they can be restored from there.
+	void Delete (std::size_t index, wxString *trashID = nullptr);
 	
 	/// delete the currently selected instance and all its files
-	void DeleteCurrent ();
+	void DeleteCurrent (wxString *trashID = nullptr);
 	
 	/// Prevent the model from updating the control until thawed again (for batching changes)
 	void Freeze();
@@ -93,6 +114,11 @@ public:
 	bool LoadGroupInfo(wxString file = wxEmptyString);
 	bool SaveGroupInfo(wxString file = wxEmptyString) const;
 
+	/// Parse a group file without touching any model. Safe to call from any thread.
+	static bool ReadGroupInfo(const wxString &file, InstanceGroupInfo &info);
+	/// Apply parsed group info. Instances added later get their groups from it too.
+	void SetGroupInfo(const InstanceGroupInfo &info);
+
 	bool SelectInstanceByID(wxString select);
 
 	Instance *GetSelectedInstance()
@@ -132,6 +158,16 @@ public:
 	};
 	void InstanceRenamed ( Instance* renamedInstance );
 	void InstanceGroupChanged ( Instance* changedInstance );
+	/// Notes, mods or version changed. Updates the search index.
+	void InstanceInfoChanged ( Instance* changedInstance );
+	/// The mods changed, reads the mod IDs again in the background.
+	void InstanceModsChanged ( Instance* changedInstance );
+	/// Called by groups when they are renamed
+	void GroupRenamed ( InstanceGroup* group );
+
+	/// Find the instances matching every word of the query in their name, notes, group,
+	/// version or mod IDs (case insensitive). matches is indexed like the model.
+	void Search(const wxString &query, std::vector<bool> &matches) const;
 
 	void SetInstanceGroup(Instance *inst, wxString groupName);
 	InstanceGroup* GetInstanceGroup(Instance *inst) const;
@@ -163,4 +199,20 @@ protected:
 	unsigned int m_freeze_level;
 
 	wxString m_groupFile;
+	// group assignments for instances that weren't added yet (instance ID -> group name)
+	std::map<wxString, wxString> m_pendingGroups;
+
+	// searchable text of all instances
+	InstanceSearchIndex m_search;
+	void UpdateSearchIndex(Instance *inst);
+
+	// Mod IDs are read on worker threads for instances that don't have them yet.
+	friend class ModIDResultHandler;
+	void RequestModIDs(Instance *inst);
+	void ModIDsRead();
+	// pending reads, the newest request ID for each instance
+	std::map<Instance *, int> m_modIDRequests;
+	int m_nextModIDRequest;
+	std::shared_ptr<ModIDReadState> m_modIDState;
+	ModIDResultHandler *m_modIDHandler;
 };
@@ -0,0 +1,200 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "instancesearch.h"
+
+#include <algorithm>
+
+InstanceSearchIndex::InstanceSearchIndex()
+{
+	
+}
+
+uint32_t InstanceSearchIndex::GramKey(const char *str, int len)
+{
+	uint32_t key = len << 24;
+	for (int i = 0; i < len; i++)
+		key |= (uint32_t)(unsigned char)str[i] << (8 * (len - 1 - i));
+	return key;
+}
+
+void InstanceSearchIndex::GetGrams(const std::string &text, std::vector<uint32_t> &grams)
+{
+	grams.clear();
+	for (std::size_t i = 0; i + 1 < text.size(); i++)
+	{
+		grams.push_back(GramKey(text.data() + i, 2));
+		if (i + 2 < text.size())
+			grams.push_back(GramKey(text.data() + i, 3));
+	}
+	std::sort(grams.begin(), grams.end());
+	grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+}
+
+void InstanceSearchIndex::AddPostings(DocID id)
+{
+	std::vector<uint32_t> grams;
+	GetGrams(m_docs[id].text, grams);
+	for (auto iter = grams.begin(); iter != grams.end(); iter++)
+	{
+		std::vector<DocID> &docs = m_postings[*iter];
+		docs.insert(std::lower_bound(docs.begin(), docs.end(), id), id);
+	}
+}
+
+void InstanceSearchIndex::RemovePostings(DocID id)
+{
+	std::vector<uint32_t> grams;
+	GetGrams(m_docs[id].text, grams);
+	for (auto iter = grams.begin(); iter != grams.end(); iter++)
+	{
+		auto found = m_postings.find(*iter);
+		if (found == m_postings.end())
+			continue;
+		std::vector<DocID> &docs = found->second;
+		auto pos = std::lower_bound(docs.begin(), docs.end(), id);
+		if (pos != docs.end() && *pos == id)
+			docs.erase(pos);
+		if (docs.empty())
+			m_postings.erase(found);
+	}
+}
+
+void InstanceSearchIndex::Set(Instance *inst, const std::string &text)
+{
+	auto found = m_docIDs.find(inst);
+	if (found != m_docIDs.end())
+	{
+		DocID id = found->second;
+		if (m_docs[id].text == text)
+			return;
+		RemovePostings(id);
+		m_docs[id].text = text;
+		AddPostings(id);
+		return;
+	}
+
+	DocID id;
+	if (!m_freeDocs.empty())
+	{
+		id = m_freeDocs.back();
+		m_freeDocs.pop_back();
+	}
+	else
+	{
+		id = m_docs.size();
+		m_docs.push_back(Doc());
+	}
+	m_docs[id].inst = inst;
+	m_docs[id].text = text;
+	m_docIDs[inst] = id;
+	AddPostings(id);
+}
+
+void InstanceSearchIndex::Remove(Instance *inst)
+{
+	auto found = m_docIDs.find(inst);
+	if (found == m_docIDs.end())
+		return;
+
+	DocID id = found->second;
+	RemovePostings(id);
+	m_docs[id].inst = nullptr;
+	m_docs[id].text.clear();
+	m_freeDocs.push_back(id);
+	m_docIDs.erase(found);
+}
+
+void InstanceSearchIndex::Clear()
+{
+	m_docs.clear();
+	m_freeDocs.clear();
+	m_docIDs.clear();
+	m_postings.clear();
+}
+
+void InstanceSearchIndex::Search(const std::string &query, std::vector<Instance *> &results) const
+{
+	results.clear();
+
+	std::vector<std::string> words;
+	std::size_t start = 0;
+	while (start < query.size())
+	{
+		std::size_t end = query.find_first_of(" \t\r\n", start);
+		if (end == std::string::npos)
+			end = query.size();
+		if (end > start)
+			words.push_back(query.substr(start, end - start));
+		start = end + 1;
+	}
+
+	// Collect the posting lists of every word's sequences. A two byte word is one 
+	// sequence, longer words only need their three byte ones.
+	std::vector<const std::vector<DocID> *> lists;
+	for (auto word = words.begin(); word != words.end(); word++)
+	{
+		int len = word->size() == 2 ? 2 : 3;
+		for (std::size_t i = 0; i + len <= word->size(); i++)
+		{
+			auto found = m_postings.find(GramKey(word->data() + i, len));
+			if (found == m_postings.end())
+				return;
+			lists.push_back(&found->second);
+		}
+	}
+
+	// Intersect them, shortest first.
+	std::vector<DocID> candidates;
+	if (!lists.empty())
+	{
+		std::sort(lists.begin(), lists.end(), 
+			[] (const std::vector<DocID> *a, const std::vector<DocID> *b) { return a->size() < b->size(); });
+		candidates = *lists[0];
+		std::vector<DocID> merged;
+		for (std::size_t i = 1; i < lists.size() && !candidates.empty(); i++)
+		{
+			merged.clear();
+			std::set_intersection(candidates.begin(), candidates.end(), 
+				lists[i]->begin(), lists[i]->end(), std::back_inserter(merged));
+			candidates.swap(merged);
+		}
+	}
+	else
+	{
+		// only single letter words (or none at all), check everything
+		for (DocID id = 0; id < m_docs.size(); id++)
+		{
+			if (m_docs[id].inst != nullptr)
+				candidates.push_back(id);
+		}
+	}
+
+	// Having all sequences of a word doesn't mean having the word itself.
+	for (auto id = candidates.begin(); id != candidates.end(); id++)
+	{
+		const Doc &doc = m_docs[*id];
+		bool match = true;
+		for (auto word = words.begin(); word != words.end() && match; word++)
+		{
+			if (doc.text.find(*word) == std::string::npos)
+				match = false;
+		}
+		if (match)
+			results.push_back(doc.inst);
+	}
+	std::sort(results.begin(), results.end());
+}
@@ -0,0 +1,69 @@
+//
+//  Copyright 2012 MultiMC Contributors
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+class Instance;
+
+// In-memory index over the searchable text of each instance (name, notes, group,
+// version, mods). Every distinct two and three byte sequence of the text lists the
+// instances that contain it, so a query only looks at the instances that have all
+// of its sequences. Texts and queries are UTF-8 and should already be lower case.
+class InstanceSearchIndex
+{
+public:
+	InstanceSearchIndex();
+
+	// Adds the instance or replaces its text.
+	void Set(Instance *inst, const std::string &text);
+	void Remove(Instance *inst);
+	void Clear();
+
+	// Finds the instances containing every space separated word of the query.
+	// The results are sorted by pointer, an empty query finds everything.
+	void Search(const std::string &query, std::vector<Instance *> &results) const;
+
+	std::size_t size() const { return m_docIDs.size(); }
+
+protected:
+	typedef uint32_t DocID;
+
+	struct Doc
+	{
+		Instance *inst;
+		std::string text;
+	};
+
+	// Key of the sequence of len (2 or 3) bytes at str.
+	static uint32_t GramKey(const char *str, int len);
+	// Sorted, distinct keys of all two and three byte sequences in text.
+	static void GetGrams(const std::string &text, std::vector<uint32_t> &grams);
+
+	void AddPostings(DocID id);
+	void RemovePostings(DocID id);
+
+	// indexed by DocID, inst is nullptr for unused entries
+	std::vector<Doc> m_docs;
+	std::vector<DocID> m_freeDocs;
+	std::unordered_map<Instance *, DocID> m_docIDs;
+
+	// sequence key -> sorted IDs of the documents containing it
+	std::unordered_map<uint32_t, std::vector<DocID> > m_postings;
+};
@@ -0,0 +1,247 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "multimc_pragma.h"
+#include "jarmanifest.h"
+
+#include <wx/wfstream.h>
+#include <wx/zipstrm.h>
+#include <wx/arrstr.h>
+
+#include <memory>
+
+#include "utils/datautils.h"
+
+const wxString manifestHeader = "MultiMC jar manifest 1";
+
+static bool StatFile(const wxString &path, uint64_t &size, int64_t &mtime)
+{
+	wxFileName file(path);
+	if (!file.FileExists())
+		return false;
+
+	size = file.GetSize().GetValue();
+	mtime = file.GetModificationTime().GetTicks();
+	return true;
+}
+
+static bool ParseU64(const wxString &str, uint64_t &out, int base = 10)
+{
+	wxULongLong_t value;
+	if (!str.ToULongLong(&value, base))
+		return false;
+	out = value;
+	return true;
+}
+
+static bool ParseS64(const wxString &str, int64_t &out)
+{
+	wxLongLong_t value;
+	if (!str.ToLongLong(&value))
+		return false;
+	out = value;
+	return true;
+}
+
+JarManifest::Source::Source(SourceType type, const wxString &path)
+	: type(type), path(path), size(0), mtime(0)
+{
+
+}
+
+bool JarManifest::Source::Stat()
+{
+	return StatFile(path, size, mtime);
+}
+
+bool JarManifest::Source::Scan(const wxString &entryName)
+{
+	entries.clear();
+	if (!Stat())
+		return false;
+
+	if (type == SOURCE_SINGLEFILE)
+	{
+		Entry entry = { entryName, 0, size };
+		entries.push_back(entry);
+		return true;
+	}
+
+	wxFFileInputStream fileIn(path);
+	if (!fileIn.IsOk())
+		return false;
+
+	// The file is seekable, so the entries come from the central directory
+	// and the entry data is skipped over.
+	wxZipInputStream zipIn(fileIn);
+	std::unique_ptr<wxZipEntry> zipEntry;
+	while (zipEntry.reset(zipIn.GetNextEntry()), zipEntry.get() != nullptr)
+	{
+		wxString name = zipEntry->GetName();
+		if (type == SOURCE_ZIPFILE && zipEntry->IsDir())
+			continue;
+		if (type == SOURCE_BACKUP && name.Matches("META-INF*"))
+			continue;
+
+		Entry entry = { name, (uint32_t)zipEntry->GetCrc(), (uint64_t)zipEntry->GetSize() };
+		entries.push_back(entry);
+	}
+	return true;
+}
+
+bool JarManifest::Source::SameFile(const Source &other) const
+{
+	return type == other.type && path == other.path && 
+		size == other.size && mtime == other.mtime;
+}
+
+JarManifest::JarManifest()
+	: jarSize(0), jarMTime(0)
+{
+
+}
+
+bool JarManifest::Load(const wxString &file)
+{
+	sources.clear();
+	jarSize = 0;
+	jarMTime = 0;
+
+	if (!wxFileExists(file))
+		return false;
+
+	wxFFileInputStream inStream(file);
+	if (!inStream.IsOk())
+		return false;
+
+	wxArrayString lines = ReadAllLines(inStream);
+	if (lines.empty() || lines[0] != manifestHeader)
+		return false;
+
+	bool ok = true;
+	for (size_t i = 1; i < lines.size() && ok; i++)
+	{
+		// No escape character, paths on Windows contain backslashes.
+		wxArrayString fields = wxSplit(lines[i], '\t', '\0');
+
+		if (fields[0] == "jar" && fields.size() == 3)
+		{
+			ok = ParseU64(fields[1], jarSize) && ParseS64(fields[2], jarMTime);
+		}
+		else if (fields[0] == "source" && fields.size() == 5)
+		{
+			long type;
+			Source src;
+			ok = fields[1].ToLong(&type) && type >= SOURCE_BACKUP && type <= SOURCE_SINGLEFILE &&
+				ParseU64(fields[2], src.size) && ParseS64(fields[3], src.mtime);
+			src.type = (SourceType)type;
+			src.path = fields[4];
+			sources.push_back(src);
+		}
+		else if (fields[0] == "entry" && fields.size() == 4 && !sources.empty())
+		{
+			uint64_t crc;
+			Entry entry;
+			ok = ParseU64(fields[1], crc, 16) && ParseU64(fields[2], entry.size);
+			entry.crc = crc;
+			entry.name = fields[3];
+			sources.back().entries.push_back(entry);
+		}
+		else
+		{
+			ok = false;
+		}
+	}
+
+	if (!ok)
+	{
+		sources.clear();
+		return false;
+	}
+	return true;
+}
+
+bool JarManifest::Save(const wxString &file) const
+{
+	wxString text;
+	text << manifestHeader << "\n";
+	text << wxString::Format("jar\t%" wxLongLongFmtSpec "u\t%" wxLongLongFmtSpec "d\n",
+		(wxULongLong_t)jarSize, (wxLongLong_t)jarMTime);
+
+	for (auto src = sources.begin(); src != sources.end(); ++src)
+	{
+		text << wxString::Format("source\t%i\t%" wxLongLongFmtSpec "u\t%" wxLongLongFmtSpec "d\t",
+			(int)src->type, (wxULongLong_t)src->size, (wxLongLong_t)src->mtime);
+		text << src->path << "\n";
+
+		for (auto entry = src->entries.begin(); entry != src->entries.end(); ++entry)
+		{
+			text << wxString::Format("entry\t%08x\t%" wxLongLongFmtSpec "u\t",
+				(unsigned)entry->crc, (wxULongLong_t)entry->size);
+			text << entry->name << "\n";
+		}
+	}
+
+	wxTempFileOutputStream out(file);
+	WriteAllText(out, text);
+	return out.Commit();
+}
+
+void JarManifest::SetJar(const wxFileName &jar)
+{
+	if (!StatFile(jar.GetFullPath(), jarSize, jarMTime))
+	{
+		jarSize = 0;
+		jarMTime = 0;
+	}
+}
+
+bool JarManifest::MatchesJar(const wxFileName &jar) const
+{
+	uint64_t size;
+	int64_t mtime;
+	if (!StatFile(jar.GetFullPath(), size, mtime))
+		return false;
+	return size == jarSize && mtime == jarMTime;
+}
+
+const JarManifest::Source *JarManifest::FindSource(const wxString &path) const
+{
+	for (auto src = sources.begin(); src != sources.end(); ++src)
+	{
+		if (src->path == path)
+			return &(*src);
+	}
+	return nullptr;
+}
+
+JarManifest::OwnerMap JarManifest::GetEntryOwners() const
+{
+	OwnerMap owners;
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		const std::vector<Entry> &entries = sources[i].entries;
+		for (auto entry = entries.begin(); entry != entries.end(); ++entry)
+		{
+			if (owners.count(entry->name) == 0)
+			{
+				EntryOwner owner = { i, &(*entry) };
+				owners[entry->name] = owner;
+			}
+		}
+	}
+	return owners;
+}
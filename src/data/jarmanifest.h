@@ -0,0 +1,109 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#pragma once
+#include <vector>
+#include <map>
+#include <stdint.h>
+
+#include <wx/string.h>
+#include <wx/filename.h>
+
+// Records which source every entry of a modded minecraft.jar was taken from.
+// It is stored next to the jar and lets ModderTask carry unchanged entries
+// over from the previous build instead of rebuilding the whole jar.
+class JarManifest
+{
+public:
+	enum SourceType
+	{
+		// The unmodified jar (mcbackup.jar). Its META-INF folder is left out.
+		SOURCE_BACKUP,
+
+		// A zip or jar mod. Directory entries are left out.
+		SOURCE_ZIPFILE,
+
+		// A single file that is added as one entry.
+		SOURCE_SINGLEFILE,
+	};
+
+	struct Entry
+	{
+		wxString name;
+		uint32_t crc;
+		uint64_t size;
+	};
+
+	struct Source
+	{
+		Source(SourceType type = SOURCE_ZIPFILE, const wxString &path = wxEmptyString);
+
+		// Reads the size and modification time of the source file.
+		// Returns false if the file doesn't exist.
+		bool Stat();
+
+		// Fills the entry list from the file. For zip files this only reads
+		// the central directory, none of the entry data is decompressed.
+		// entryName is the name used for SOURCE_SINGLEFILE sources.
+		bool Scan(const wxString &entryName = wxEmptyString);
+
+		// True if both refer to the same, unmodified file.
+		bool SameFile(const Source &other) const;
+
+		SourceType type;
+		wxString path;
+		uint64_t size;
+		int64_t mtime;
+		std::vector<Entry> entries;
+	};
+
+	struct EntryOwner
+	{
+		// Index of the source in the sources vector.
+		size_t source;
+		const Entry *entry;
+	};
+	typedef std::map<wxString, EntryOwner> OwnerMap;
+
+	JarManifest();
+
+	// Loads the manifest from the given file. Returns false if the file is
+	// missing or isn't a valid manifest.
+	bool Load(const wxString &file);
+
+	// Saves the manifest to the given file.
+	bool Save(const wxString &file) const;
+
+	// Remembers the size and modification time of the built jar.
+	void SetJar(const wxFileName &jar);
+
+	// True if the given jar is the one this manifest was written for.
+	bool MatchesJar(const wxFileName &jar) const;
+
+	// Returns the source with the given path or nullptr if there is none.
+	const Source *FindSource(const wxString &path) const;
+
+	// Maps the name of every entry in the jar to the source it comes from.
+	OwnerMap GetEntryOwners() const;
+
+	// Sources in order of priority. The first source that has an entry
+	// with a given name is the one that ends up in the jar.
+	std::vector<Source> sources;
+
+protected:
+	uint64_t jarSize;
+	int64_t jarMTime;
+};
@@ -0,0 +1,341 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+
+#include "launchlog.h"
+
+#include <algorithm>
+
+#include <wx/dir.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/mstream.h>
+#include <wx/zstream.h>
+#include <wx/time.h>
+#include <wx/tokenzr.h>
+
+#include "utils/apputils.h"
+
+const wxString indexHeader = "MultiMC launch log 1";
+
+// Blocks are compressed once they hold this many bytes or are this old (in ms).
+const size_t maxBlockSize = 64 * 1024;
+const int maxBlockAge = 5000;
+
+// Only this many logs are kept per instance.
+const size_t maxLogCount = 30;
+
+static wxString FormatS64(int64_t value)
+{
+	return wxString::Format("%" wxLongLongFmtSpec "d", (wxLongLong_t)value);
+}
+
+static bool ParseS64(const wxString &str, int64_t &out)
+{
+	wxLongLong_t value;
+	if (!str.ToLongLong(&value))
+		return false;
+	out = value;
+	return true;
+}
+
+LaunchLogWriter::LaunchLogWriter()
+	: m_offset(0), m_lineCount(0), m_blockFirstLine(0)
+{
+	
+}
+
+LaunchLogWriter::~LaunchLogWriter()
+{
+	Close();
+}
+
+bool LaunchLogWriter::Open(const wxString &logDir)
+{
+	Close();
+
+	if (!wxDirExists(logDir) && !wxFileName::Mkdir(logDir, 0777, wxPATH_MKDIR_FULL))
+		return false;
+
+	// Make room for the new log.
+	wxArrayString logs = LaunchLogReader::ListLogs(logDir);
+	for (size_t i = maxLogCount - 1; i < logs.size(); i++)
+	{
+		wxRemoveFile(logs[i] + ".log.z");
+		wxRemoveFile(logs[i] + ".idx");
+	}
+
+	wxDateTime now = wxDateTime::Now();
+	m_path = Path::Combine(logDir, now.Format("launch-%Y%m%d-%H%M%S"));
+	for (int i = 2; wxFileExists(m_path + ".idx"); i++)
+		m_path = Path::Combine(logDir, now.Format("launch-%Y%m%d-%H%M%S-") + wxString::Format("%i", i));
+
+	if (!m_dataFile.Open(m_path + ".log.z", "wb") || !m_indexFile.Open(m_path + ".idx", "w"))
+	{
+		m_dataFile.Close();
+		m_indexFile.Close();
+		return false;
+	}
+
+	m_indexFile.Write(indexHeader + "\n");
+	m_indexFile.Write("start\t" + FormatS64(now.GetValue().GetValue()) + "\n");
+	m_indexFile.Flush();
+
+	m_offset = 0;
+	m_lineCount = 0;
+	m_blockFirstLine = 0;
+	m_block.clear();
+	return true;
+}
+
+void LaunchLogWriter::AppendLine(const wxString &line)
+{
+	if (!IsOpen())
+		return;
+
+	if (m_block.empty())
+	{
+		m_blockFirstLine = m_lineCount;
+		m_blockTime = wxGetLocalTimeMillis();
+	}
+
+	wxCharBuffer utf8 = line.ToUTF8();
+	m_block.append(utf8.data(), utf8.length());
+	m_block.push_back('\n');
+	m_lineCount++;
+
+	if (m_block.size() >= maxBlockSize)
+		Flush();
+}
+
+void LaunchLogWriter::Flush()
+{
+	if (!IsOpen() || m_block.empty())
+		return;
+
+	// Each block is its own zlib stream, so it can be read on its own.
+	wxMemoryOutputStream memOut;
+	{
+		wxZlibOutputStream zOut(memOut, wxZ_DEFAULT_COMPRESSION, wxZLIB_ZLIB);
+		zOut.Write(m_block.data(), m_block.size());
+		zOut.Close();
+	}
+
+	size_t size = memOut.GetSize();
+	std::vector<char> data(size);
+	memOut.CopyTo(&data[0], size);
+	if (m_dataFile.Write(&data[0], size) != size)
+	{
+		Close();
+		return;
+	}
+	m_dataFile.Flush();
+
+	int64_t lines = m_lineCount - m_blockFirstLine;
+	m_indexFile.Write("block\t" + FormatS64(m_offset) + "\t" + FormatS64(size) + "\t" +
+		FormatS64(m_blockFirstLine) + "\t" + FormatS64(lines) + "\t" + FormatS64(m_blockTime.GetValue()) + "\n");
+	m_indexFile.Flush();
+
+	m_offset += size;
+	m_block.clear();
+}
+
+void LaunchLogWriter::FlushIfOld()
+{
+	if (!m_block.empty() && wxGetLocalTimeMillis() - m_blockTime >= maxBlockAge)
+		Flush();
+}
+
+void LaunchLogWriter::Close()
+{
+	if (!IsOpen())
+		return;
+
+	Flush();
+	m_indexFile.Write("end\t" + FormatS64(wxDateTime::Now().GetValue().GetValue()) + "\n");
+	m_dataFile.Close();
+	m_indexFile.Close();
+}
+
+bool LaunchLogReader::Open(const wxString &path)
+{
+	m_path = path;
+	m_lineCount = 0;
+	m_blocks.clear();
+	m_startTime = wxInvalidDateTime;
+
+	wxFFile indexFile;
+	wxString indexText;
+	if (!wxFileExists(path + ".idx") || !indexFile.Open(path + ".idx", "r") || !indexFile.ReadAll(&indexText))
+		return false;
+
+	wxStringTokenizer lines(indexText, "\r\n");
+	if (!lines.HasMoreTokens() || lines.GetNextToken() != indexHeader)
+		return false;
+
+	while (lines.HasMoreTokens())
+	{
+		wxArrayString fields = wxSplit(lines.GetNextToken(), '\t', '\0');
+		int64_t value;
+		if (fields.size() == 2 && fields[0] == "start" && ParseS64(fields[1], value))
+		{
+			m_startTime = wxDateTime(wxLongLong(value));
+		}
+		else if (fields.size() == 6 && fields[0] == "block")
+		{
+			Block block;
+			int64_t time;
+			if (!ParseS64(fields[1], block.offset) || !ParseS64(fields[2], block.size) ||
+				!ParseS64(fields[3], block.firstLine) || !ParseS64(fields[4], block.lineCount) ||
+				!ParseS64(fields[5], time))
+			{
+				// A torn write at the end of a log that is being written.
+				break;
+			}
+			block.time = time;
+			m_blocks.push_back(block);
+			m_lineCount = block.firstLine + block.lineCount;
+		}
+	}
+	return true;
+}
+
+bool LaunchLogReader::ReadBlock(size_t index, wxArrayString &lines)
+{
+	const Block &block = m_blocks[index];
+
+	wxFFile dataFile;
+	if (!dataFile.Open(m_path + ".log.z", "rb") || !dataFile.Seek(block.offset))
+		return false;
+
+	std::vector<char> compressed(block.size);
+	if (block.size == 0 || dataFile.Read(&compressed[0], block.size) != (size_t)block.size)
+		return false;
+
+	wxMemoryInputStream memIn(&compressed[0], compressed.size());
+	wxZlibInputStream zIn(memIn, wxZLIB_ZLIB);
+	std::string text;
+	char buf[16 * 1024];
+	while (!zIn.Eof())
+	{
+		size_t read = zIn.Read(buf, sizeof(buf)).LastRead();
+		if (read == 0)
+			break;
+		text.append(buf, read);
+	}
+
+	size_t start = 0;
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		if (text[i] == '\n')
+		{
+			lines.Add(wxString::FromUTF8(text.data() + start, i - start));
+			start = i + 1;
+		}
+	}
+	return true;
+}
+
+bool LaunchLogReader::ReadLines(int64_t first, int64_t count, wxArrayString &lines)
+{
+	for (size_t i = 0; i < m_blocks.size() && count > 0; i++)
+	{
+		const Block &block = m_blocks[i];
+		if (block.firstLine + block.lineCount <= first)
+			continue;
+
+		wxArrayString blockLines;
+		if (!ReadBlock(i, blockLines))
+			return false;
+
+		for (size_t j = first - block.firstLine; j < blockLines.size() && count > 0; j++)
+		{
+			lines.Add(blockLines[j]);
+			first++;
+			count--;
+		}
+	}
+	return true;
+}
+
+bool LaunchLogReader::ReadTail(int64_t count, wxArrayString &lines)
+{
+	int64_t first = std::max<int64_t>(0, m_lineCount - count);
+	return ReadLines(first, m_lineCount - first, lines);
+}
+
+void LaunchLogReader::Search(const wxString &text, std::vector<Match> &matches, size_t maxMatches)
+{
+	for (size_t i = 0; i < m_blocks.size() && matches.size() < maxMatches; i++)
+	{
+		wxArrayString blockLines;
+		if (!ReadBlock(i, blockLines))
+			return;
+
+		for (size_t j = 0; j < blockLines.size() && matches.size() < maxMatches; j++)
+		{
+			if (blockLines[j].Contains(text))
+			{
+				Match match;
+				match.line = m_blocks[i].firstLine + j;
+				match.text = blockLines[j];
+				matches.push_back(match);
+			}
+		}
+	}
+}
+
+// Log names are launch-<date>-<time>, with -2, -3, ... appended if there already
+// was one that second. Sorts newest first.
+static int CompareLogs(const wxString &first, const wxString &second)
+{
+	wxString firstName = wxFileName(first).GetFullName();
+	wxString secondName = wxFileName(second).GetFullName();
+	const size_t timeLength = wxString("launch-YYYYmmdd-HHMMSS").length();
+
+	int result = secondName.Left(timeLength).Cmp(firstName.Left(timeLength));
+	if (result != 0)
+		return result;
+
+	long firstNum, secondNum;
+	if (!firstName.Mid(timeLength + 1).ToLong(&firstNum))
+		firstNum = 1;
+	if (!secondName.Mid(timeLength + 1).ToLong(&secondNum))
+		secondNum = 1;
+	return secondNum < firstNum ? -1 : secondNum > firstNum;
+}
+
+wxArrayString LaunchLogReader::ListLogs(const wxString &logDir)
+{
+	wxArrayString logs;
+	// wxDir complains about folders that don't exist.
+	if (!wxDirExists(logDir))
+		return logs;
+	wxDir dir(logDir);
+	if (!dir.IsOpened())
+		return logs;
+
+	wxString file;
+	bool cont = dir.GetFirst(&file, "launch-*.idx", wxDIR_FILES);
+	while (cont)
+	{
+		logs.Add(Path::Combine(logDir, file.BeforeLast('.')));
+		cont = dir.GetNext(&file);
+	}
+
+	logs.Sort(CompareLogs);
+	return logs;
+}
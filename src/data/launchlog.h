@@ -0,0 +1,113 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+
+#pragma once
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+#include <wx/string.h>
+#include <wx/arrstr.h>
+#include <wx/ffile.h>
+#include <wx/datetime.h>
+
+// Every launch's output is kept in the instance's logs folder as a pair of files:
+//   launch-<time>.log.z  independently compressed blocks of lines
+//   launch-<time>.idx    one line per block with its offset, first line number and time
+// so any part of an old log can be read without decompressing the rest.
+
+// Writes the log of the running launch.
+class LaunchLogWriter
+{
+public:
+	LaunchLogWriter();
+	~LaunchLogWriter();
+
+	// Starts a new log in the given folder. Old logs beyond the limit are deleted.
+	bool Open(const wxString &logDir);
+
+	void AppendLine(const wxString &line);
+
+	// Writes the lines added so far to disk.
+	void Flush();
+
+	// Flushes if the current block is old enough. Call this regularly.
+	void FlushIfOld();
+
+	void Close();
+
+	bool IsOpen() const { return m_dataFile.IsOpened(); }
+
+	// Path of the log without extension, for LaunchLogReader.
+	wxString GetPath() const { return m_path; }
+
+protected:
+	wxString m_path;
+	wxFFile m_dataFile;
+	wxFFile m_indexFile;
+
+	std::string m_block;
+	int64_t m_offset;
+	int64_t m_lineCount;
+	int64_t m_blockFirstLine;
+	wxLongLong m_blockTime;
+};
+
+// Reads a launch log written by LaunchLogWriter, also while it's still being written.
+class LaunchLogReader
+{
+public:
+	struct Match
+	{
+		int64_t line;
+		wxString text;
+	};
+
+	bool Open(const wxString &path);
+
+	wxDateTime GetStartTime() const { return m_startTime; }
+	int64_t GetLineCount() const { return m_lineCount; }
+
+	// Reads count lines starting at line first.
+	bool ReadLines(int64_t first, int64_t count, wxArrayString &lines);
+
+	// Reads the last count lines.
+	bool ReadTail(int64_t count, wxArrayString &lines);
+
+	// Finds lines containing the text, up to maxMatches of them.
+	void Search(const wxString &text, std::vector<Match> &matches, size_t maxMatches);
+
+	// Lists the logs in the given folder, newest first.
+	static wxArrayString ListLogs(const wxString &logDir);
+
+protected:
+	struct Block
+	{
+		int64_t offset;
+		int64_t size;
+		int64_t firstLine;
+		int64_t lineCount;
+		wxLongLong time;
+	};
+
+	bool ReadBlock(size_t block, wxArrayString &lines);
+
+	wxString m_path;
+	wxDateTime m_startTime;
+	int64_t m_lineCount;
+	std::vector<Block> m_blocks;
+};
@@ -0,0 +1,227 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "multimc_pragma.h"
+#include "librarycache.h"
+
+#include <wx/dir.h>
+#include <wx/wfstream.h>
+
+#include "appsettings.h"
+#include "utils/apputils.h"
+#include "utils/datautils.h"
+#include "utils/fsutils.h"
+
+LibraryCache* LibraryCache::pInstance = 0;
+
+LibraryCache::LibraryCache()
+{
+	indexLoaded = false;
+}
+
+bool LibraryCache::IsMD5(const wxString &str)
+{
+	if (str.Len() != 32)
+		return false;
+	for (size_t i = 0; i < str.Len(); i++)
+	{
+		wxChar c = str[i];
+		if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')))
+			return false;
+	}
+	return true;
+}
+
+wxFileName LibraryCache::GetEntryDir(const wxString &md5) const
+{
+	return wxFileName::DirName(Path::Combine(settings->GetLibCacheDir(), md5));
+}
+
+wxFileName LibraryCache::GetNativesDir(const wxString &md5) const
+{
+	return wxFileName::DirName(Path::Combine(GetEntryDir(md5), "natives"));
+}
+
+wxString LibraryCache::GetURLHash(const wxString &url)
+{
+	wxMutexLocker lock(indexLock);
+	LoadIndex();
+
+	auto iter = urlHashes.find(url);
+	if (iter == urlHashes.end())
+		return wxEmptyString;
+	return iter->second;
+}
+
+void LibraryCache::SetURLHash(const wxString &url, const wxString &md5)
+{
+	wxMutexLocker lock(indexLock);
+	LoadIndex();
+
+	if (urlHashes[url] != md5)
+	{
+		urlHashes[url] = md5;
+		SaveIndex();
+	}
+}
+
+wxString LibraryCache::PatchKey(const wxString &srcMD5, const wxString &patchMD5)
+{
+	return "patch:" + srcMD5 + ":" + patchMD5;
+}
+
+wxString LibraryCache::GetPatchResult(const wxString &srcMD5, const wxString &patchMD5)
+{
+	if (!IsMD5(srcMD5) || !IsMD5(patchMD5))
+		return wxEmptyString;
+	return GetURLHash(PatchKey(srcMD5, patchMD5));
+}
+
+void LibraryCache::SetPatchResult(const wxString &srcMD5, const wxString &patchMD5, const wxString &resultMD5)
+{
+	if (!IsMD5(srcMD5) || !IsMD5(patchMD5) || !IsMD5(resultMD5))
+		return;
+	SetURLHash(PatchKey(srcMD5, patchMD5), resultMD5);
+}
+
+bool LibraryCache::HasFile(const wxString &md5, const wxString &name)
+{
+	if (!IsMD5(md5))
+		return false;
+	return wxFileExists(Path::Combine(GetEntryDir(md5), name));
+}
+
+bool LibraryCache::AddFile(const wxString &md5, const wxString &path, const wxString &fileName)
+{
+	wxString name = fileName.IsEmpty() ? wxFileName(path).GetFullName() : fileName;
+	if (!IsMD5(md5))
+		return false;
+	if (HasFile(md5, name))
+		return true;
+
+	wxFileName entryDir = GetEntryDir(md5);
+	if (!entryDir.DirExists() && !entryDir.Mkdir(0777, wxPATH_MKDIR_FULL))
+		return false;
+
+	// Link into a temporary name first so a half written file is never picked up.
+	wxString dest = Path::Combine(entryDir, name);
+	wxString tmpDest = dest + wxString::Format(".%lu.tmp", (unsigned long)wxThread::GetCurrentId());
+	if (!fsutils::LinkFile(path, tmpDest))
+		return false;
+	if (!wxRenameFile(tmpDest, dest, true))
+	{
+		wxRemoveFile(tmpDest);
+		return false;
+	}
+	return true;
+}
+
+bool LibraryCache::LinkFile(const wxString &md5, const wxString &name, const wxString &dest)
+{
+	if (!HasFile(md5, name))
+		return false;
+	return fsutils::LinkFile(Path::Combine(GetEntryDir(md5), name), dest);
+}
+
+bool LibraryCache::HasNatives(const wxString &md5)
+{
+	if (!IsMD5(md5))
+		return false;
+	return GetNativesDir(md5).DirExists();
+}
+
+wxFileName LibraryCache::BeginNatives(const wxString &md5)
+{
+	wxFileName extractDir = wxFileName::DirName(Path::Combine(GetEntryDir(md5), 
+		wxString::Format("natives.%lu.tmp", (unsigned long)wxThread::GetCurrentId())));
+	if (extractDir.DirExists())
+		fsutils::RecursiveDelete(extractDir.GetFullPath());
+	extractDir.Mkdir(0777, wxPATH_MKDIR_FULL);
+	return extractDir;
+}
+
+bool LibraryCache::CommitNatives(const wxString &md5, const wxFileName &extractDir)
+{
+	wxFileName nativesDir = GetNativesDir(md5);
+
+	// Someone else may have finished extracting the same natives first.
+	if (nativesDir.DirExists() || !wxRenameFile(extractDir.GetPath(), nativesDir.GetPath(), false))
+	{
+		fsutils::RecursiveDelete(extractDir.GetFullPath());
+		return nativesDir.DirExists();
+	}
+	return true;
+}
+
+bool LibraryCache::LinkNatives(const wxString &md5, const wxFileName &destDir)
+{
+	if (!HasNatives(md5))
+		return false;
+
+	wxFileName nativesDir = GetNativesDir(md5);
+	wxDir dir(nativesDir.GetFullPath());
+	if (!dir.IsOpened())
+		return false;
+
+	if (!destDir.DirExists() && !destDir.Mkdir(0777, wxPATH_MKDIR_FULL))
+		return false;
+
+	wxString fileName;
+	bool cont = dir.GetFirst(&fileName, wxEmptyString, wxDIR_FILES);
+	while (cont)
+	{
+		if (!fsutils::LinkFile(Path::Combine(nativesDir, fileName), Path::Combine(destDir, fileName)))
+			return false;
+		cont = dir.GetNext(&fileName);
+	}
+	return true;
+}
+
+void LibraryCache::LoadIndex()
+{
+	if (indexLoaded)
+		return;
+	indexLoaded = true;
+
+	wxString indexFile = Path::Combine(settings->GetLibCacheDir(), "index");
+	if (!wxFileExists(indexFile))
+		return;
+
+	wxFFileInputStream inStream(indexFile);
+	wxArrayString lines = ReadAllLines(inStream);
+	for (size_t i = 0; i < lines.size(); i++)
+	{
+		wxString md5 = lines[i].BeforeFirst('\t');
+		wxString url = lines[i].AfterFirst('\t');
+		if (IsMD5(md5) && !url.IsEmpty())
+			urlHashes[url] = md5;
+	}
+}
+
+void LibraryCache::SaveIndex()
+{
+	wxFileName cacheDir = settings->GetLibCacheDir();
+	if (!cacheDir.DirExists())
+		cacheDir.Mkdir(0777, wxPATH_MKDIR_FULL);
+
+	wxString text;
+	for (auto iter = urlHashes.begin(); iter != urlHashes.end(); ++iter)
+		text << iter->second << "\t" << iter->first << "\n";
+
+	wxTempFileOutputStream out(Path::Combine(cacheDir, "index"));
+	WriteAllText(out, text);
+	out.Commit();
+}
@@ -0,0 +1,92 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#pragma once
+#include <map>
+
+#include <wx/string.h>
+#include <wx/filename.h>
+#include <wx/thread.h>
+
+// A content-addressed store for the jars and natives shared by all instances.
+// Files are kept in <LibCacheDir>/<md5>/<filename> and are linked into the
+// instances' bin folders instead of being downloaded again.
+class LibraryCache
+{
+public:
+	static LibraryCache& Instance()
+	{
+		if (pInstance == 0)
+			pInstance = new LibraryCache();
+		return *pInstance;
+	};
+
+	// True if the string looks like an MD5 sum (32 lower case hex digits).
+	static bool IsMD5(const wxString &str);
+
+	// Returns the MD5 sum last downloaded from the given URL or an empty string.
+	wxString GetURLHash(const wxString &url);
+
+	// Records the MD5 sum of the file served by the given URL.
+	void SetURLHash(const wxString &url, const wxString &md5);
+
+	// Returns the MD5 sum of the file produced by applying the patch with MD5 sum
+	// patchMD5 to the file with MD5 sum srcMD5, or an empty string if unknown.
+	wxString GetPatchResult(const wxString &srcMD5, const wxString &patchMD5);
+
+	// Records the result of applying a patch. The result itself goes in with AddFile.
+	void SetPatchResult(const wxString &srcMD5, const wxString &patchMD5, const wxString &resultMD5);
+
+	// True if the file with the given MD5 sum and name is in the cache.
+	bool HasFile(const wxString &md5, const wxString &name);
+
+	// Adds the file at path to the cache under the given MD5 sum.
+	// The file is stored under its own name unless another one is given.
+	bool AddFile(const wxString &md5, const wxString &path, const wxString &name = wxEmptyString);
+
+	// Links the cached file into dest, replacing dest.
+	bool LinkFile(const wxString &md5, const wxString &name, const wxString &dest);
+
+	// True if the natives extracted from the jar with the given MD5 sum are in the cache.
+	bool HasNatives(const wxString &md5);
+
+	// Returns an empty folder to extract the natives for the given MD5 sum into.
+	// Call CommitNatives once extraction is done.
+	wxFileName BeginNatives(const wxString &md5);
+	bool CommitNatives(const wxString &md5, const wxFileName &extractDir);
+
+	// Links all cached natives for the given MD5 sum into destDir.
+	bool LinkNatives(const wxString &md5, const wxFileName &destDir);
+
+protected:
+	LibraryCache();
+
+	wxFileName GetEntryDir(const wxString &md5) const;
+	wxFileName GetNativesDir(const wxString &md5) const;
+
+	static wxString PatchKey(const wxString &srcMD5, const wxString &patchMD5);
+
+	void LoadIndex();
+	void SaveIndex();
+
+	// URL -> MD5 sum of the last file downloaded from it.
+	// Patch results are kept here too, keyed by PatchKey.
+	std::map<wxString, wxString> urlHashes;
+	bool indexLoaded;
+	wxMutex indexLock;
+
+	static LibraryCache *pInstance;
+};
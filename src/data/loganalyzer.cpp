@@ -0,0 +1,187 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+
+#include "loganalyzer.h"
+
+#include <wx/filefn.h>
+#include <wx/log.h>
+#include <wx/intl.h>
+
+#include <boost/property_tree/json_parser.hpp>
+
+#include "utils/apputils.h"
+
+const wxString userRulesFile = "logrules.json";
+
+LogRuleSet *LogRuleSet::pInstance = 0;
+
+static LogRule MakeRule(const wxString &id, const wxString &literal, const wxString &regex, 
+	const wxString &message, bool isProblem)
+{
+	LogRule rule;
+	rule.id = id;
+	rule.literal = literal;
+	rule.regex = regex;
+	rule.message = message;
+	rule.isProblem = isProblem;
+	return rule;
+}
+
+LogRuleSet::LogRuleSet()
+{
+	AddRule(MakeRule("idconflict", " is already occupied by ", 
+		"([0-9]+) is already occupied by ([A-Za-z0-9.]+)@[A-Za-z0-9]+ when adding ([A-Za-z0-9.]+)@[A-Za-z0-9]+",
+		_("MultiMC found a block or item ID conflict. %2 and %3 are both using the same block ID (%1)."), true));
+	// FML and core mods log these during normal class discovery, so they don't keep the console open.
+	AddRule(MakeRule("classnotfound", "ClassNotFoundException: ", "ClassNotFoundException: ([A-Za-z0-9_.$/]+)",
+		_("The class %1 could not be found. A mod is probably missing, or it was made for another Minecraft version."), false));
+	AddRule(MakeRule("noclassdef", "NoClassDefFoundError: ", "NoClassDefFoundError: ([A-Za-z0-9_.$/]+)",
+		_("The class %1 could not be found. A mod is probably missing, or it was made for another Minecraft version."), false));
+	AddRule(MakeRule("outofmemory", "java.lang.OutOfMemoryError", wxEmptyString,
+		_("Minecraft ran out of memory. Try raising the maximum memory allocation in the instance settings."), true));
+	AddRule(MakeRule("pixelformat", "Pixel format not accelerated", wxEmptyString,
+		_("Your graphics driver doesn't support OpenGL properly. Try updating your graphics drivers."), true));
+	AddRule(MakeRule("glerror", "GL ERROR", "GL ERROR.*@ (.*)",
+		_("OpenGL reported an error (%1). This usually means a graphics driver or shader mod problem."), false));
+	AddRule(MakeRule("wrongmcversion", "WrongMinecraftVersionException", "WrongMinecraftVersionException: (.*)",
+		_("A mod was made for a different Minecraft version: %1"), true));
+	AddRule(MakeRule("missingmods", "MissingModsException", wxEmptyString,
+		_("A mod requires another mod that is missing or has the wrong version. Check the FML log for details."), true));
+
+	if (wxFileExists(userRulesFile))
+		LoadRules(userRulesFile);
+
+	Compile();
+}
+
+bool LogRuleSet::LoadRules(const wxString &file)
+{
+	using namespace boost::property_tree;
+	try
+	{
+		ptree pt;
+		read_json(stdStr(file), pt);
+
+		for (auto iter = pt.get_child("rules").begin(); iter != pt.get_child("rules").end(); ++iter)
+		{
+			ptree &item = iter->second;
+			LogRule rule = MakeRule(
+				wxStr(item.get<std::string>("id", "")),
+				wxStr(item.get<std::string>("literal")),
+				wxStr(item.get<std::string>("regex", "")),
+				wxStr(item.get<std::string>("message")),
+				item.get<bool>("problem", false));
+
+			if (rule.literal.IsEmpty())
+			{
+				wxLogError(_("Log rule '%s' in %s has no literal and was ignored."), rule.id.c_str(), file.c_str());
+				continue;
+			}
+			AddRule(rule);
+		}
+		return true;
+	}
+	catch (ptree_error &e)
+	{
+		wxLogError(_("Failed to read log rules from %s: %s"), file.c_str(), wxStr(e.what()).c_str());
+		return false;
+	}
+}
+
+void LogRuleSet::AddRule(const LogRule &rule)
+{
+	CompiledRule compiled;
+	compiled.rule = rule;
+	if (!rule.regex.IsEmpty())
+	{
+		compiled.regex = std::make_shared<wxRegEx>(rule.regex, wxRE_EXTENDED);
+		if (!compiled.regex->IsValid())
+		{
+			wxLogError(_("The regex of log rule '%s' is invalid."), rule.id.c_str());
+			return;
+		}
+	}
+	m_rules.push_back(compiled);
+}
+
+void LogRuleSet::Compile()
+{
+	m_matcher = LiteralMatcher();
+	for (size_t r = 0; r < m_rules.size(); r++)
+		m_matcher.Add(std::wstring(m_rules[r].rule.literal.wc_str()));
+	m_matcher.Compile();
+}
+
+void LogRuleSet::Match(const wxString &line, std::vector<LogDiagnostic> &diags)
+{
+	// Find the rules whose literal is in the line.
+	m_candidates.clear();
+	m_matcher.Find(line.wc_str(), m_candidates);
+
+	// Only now run the regexes, and only for those.
+	for (size_t i = 0; i < m_candidates.size(); i++)
+	{
+		CompiledRule &compiled = m_rules[m_candidates[i]];
+
+		wxString message = compiled.rule.message;
+		if (compiled.regex)
+		{
+			if (!compiled.regex->Matches(line))
+				continue;
+			for (size_t group = compiled.regex->GetMatchCount() - 1; group > 0; group--)
+			{
+				if (group <= 9)
+					message.Replace(wxString::Format("%%%u", (unsigned)group), compiled.regex->GetMatch(line, group));
+			}
+		}
+
+		LogDiagnostic diag;
+		diag.ruleID = compiled.rule.id;
+		diag.message = message;
+		diag.isProblem = compiled.rule.isProblem;
+		diags.push_back(diag);
+	}
+}
+
+LogAnalyzer::LogAnalyzer()
+	: m_foundProblems(false)
+{
+	
+}
+
+std::vector<LogDiagnostic> LogAnalyzer::AnalyzeLine(const wxString &line)
+{
+	std::vector<LogDiagnostic> diags;
+	LogRuleSet::Instance().Match(line, diags);
+
+	std::vector<LogDiagnostic> newDiags;
+	for (size_t i = 0; i < diags.size(); i++)
+	{
+		if (!m_reported.insert(diags[i].message).second)
+			continue;
+		if (diags[i].isProblem)
+			m_foundProblems = true;
+		newDiags.push_back(diags[i]);
+	}
+	return newDiags;
+}
+
+void LogAnalyzer::Reset()
+{
+	m_reported.clear();
+	m_foundProblems = false;
+}
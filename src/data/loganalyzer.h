@@ -0,0 +1,115 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+
+#pragma once
+#include <vector>
+#include <set>
+#include <string>
+#include <memory>
+
+#include <wx/string.h>
+#include <wx/regex.h>
+
+#include "utils/literalmatcher.h"
+
+// A known problem that can show up in Minecraft's output.
+struct LogRule
+{
+	wxString id;
+
+	// Text every matching line contains. Lines without it are never passed to the regex.
+	wxString literal;
+
+	// Optional regex that has to match too. Its groups can be used in the message as %1 to %9.
+	wxString regex;
+
+	wxString message;
+
+	// Problems keep the console open when the game exits.
+	bool isProblem;
+};
+
+// Something a rule found in the output.
+struct LogDiagnostic
+{
+	wxString ruleID;
+	wxString message;
+	bool isProblem;
+};
+
+// The built-in rules plus the ones from logrules.json, compiled once.
+// Use from the GUI thread only, the compiled regexes are shared.
+class LogRuleSet
+{
+public:
+	static LogRuleSet &Instance()
+	{
+		if (pInstance == 0)
+			pInstance = new LogRuleSet();
+		return *pInstance;
+	}
+
+	// Checks the line against every rule. Matches are added to diags.
+	void Match(const wxString &line, std::vector<LogDiagnostic> &diags);
+
+	size_t GetRuleCount() const { return m_rules.size(); }
+
+protected:
+	LogRuleSet();
+
+	// Loads user rules from a JSON file: {"rules": [{"id", "literal", "regex", "message", "problem"}]}
+	bool LoadRules(const wxString &file);
+	void AddRule(const LogRule &rule);
+
+	// Builds the literal matcher. Call after the last AddRule.
+	void Compile();
+
+	struct CompiledRule
+	{
+		LogRule rule;
+		std::shared_ptr<wxRegEx> regex;
+	};
+	std::vector<CompiledRule> m_rules;
+
+	// All rule literals, so each line is scanned once no matter how many rules there are.
+	// Literal i belongs to rule i.
+	LiteralMatcher m_matcher;
+
+	// scratch space for Match
+	std::vector<int> m_candidates;
+
+	static LogRuleSet *pInstance;
+};
+
+// Runs the rule set over one launch's output and remembers what it found.
+class LogAnalyzer
+{
+public:
+	LogAnalyzer();
+
+	// Returns diagnostics that are new in this launch. Each message is only reported once.
+	std::vector<LogDiagnostic> AnalyzeLine(const wxString &line);
+
+	// True if any rule marked as a problem has matched.
+	bool FoundProblems() const { return m_foundProblems; }
+
+	void Reset();
+
+protected:
+	std::set<wxString> m_reported;
+	bool m_foundProblems;
+};
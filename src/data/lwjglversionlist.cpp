@@ -17,17 +17,13 @@
 #include "lwjglversionlist.h"
 #include "appsettings.h"
 
-#include <boost/property_tree/xml_parser.hpp>
-#include <boost/foreach.hpp>
-
-#include <sstream>
-
 #include <wx/regex.h>
 #include <wx/numformatter.h>
 #include <wx/dir.h>
 
 #include "utils/httputils.h"
 #include "utils/apputils.h"
+#include "utils/feedparser.h"
 
 const wxString rssURL = "http://sourceforge.net/api/file/index/project-id/58488/mtime/desc/rss";
 
@@ -58,60 +54,44 @@ bool LWJGLVersionList::LoadIfNeeded()
 
 bool LWJGLVersionList::Reload()
 {
+	versions.clear();
 	versions.push_back(LWJGLVersion("Mojang",""));
 	
-	// Parse XML from the given URL.
-	wxString rssXML = wxEmptyString;
-	bool failed = false;
-	if (!DownloadString(rssURL, &rssXML))
+	// Pick the download links out of the feed while it downloads.
+	wxRegEx lwjglRegex("^lwjgl-(([0-9]\\.?)+)\\.zip$");
+	XmlStreamParser parser;
+	bool sawRSS = false;
+	parser.onEndElement = [&] (const std::string &path, const std::string &text)
 	{
-		//wxLogError(_("Failed to get RSS feed. Check your internet connection."));
-		failed = true;
-	}
-	using namespace boost::property_tree;
-	if(!failed)
-	try
-	{
-		ptree pt;
-		std::stringstream inStream(stdStr(rssXML), std::ios::in);
-		read_xml(inStream, pt);
-
-		wxRegEx lwjglRegex("^lwjgl-(([0-9]\\.?)+)\\.zip$");
-
-		if(pt.count("rss")) BOOST_FOREACH(const ptree::value_type& v, pt.get_child("rss.channel"))
+		if (path == "rss")
+		{
+			sawRSS = true;
+		}
+		else if (path == "rss/channel/item/link")
 		{
-			if (v.first == "item")
+			wxString link = wxStr(text);
+
+			// Look for download links.
+			if (link.EndsWith("/download"))
 			{
-				auto val = v.second.get_optional<std::string>("link");
-				if(!val)
-					continue;
-				wxString link = wxStr(val.get());
+				wxString name = link.BeforeLast('/');
+				name = name.AfterLast('/');
 
-				// Look for download links.
-				if (link.EndsWith("/download"))
+				if (lwjglRegex.Matches(name))
 				{
-					wxString name = link.BeforeLast('/');
-					name = name.AfterLast('/');
-
-					if (lwjglRegex.Matches(name))
-					{
-						wxString version = lwjglRegex.GetMatch(name,1);
-						versions.push_back(LWJGLVersion(version, link));
-					}
+					wxString version = lwjglRegex.GetMatch(name,1);
+					versions.push_back(LWJGLVersion(version, link));
 				}
 			}
 		}
-		else
-		{
-			failed = true;
-		}
-	}
-	catch (ptree_error)
-	{
-		failed = true;
-	}
+	};
+
+	bool failed = !DownloadParsed(rssURL, parser) || !sawRSS;
 	if(failed)
 	{
+		// Drop whatever was read before the feed broke off.
+		versions.erase(versions.begin() + 1, versions.end());
+
 		wxDir dir(settings->GetLwjglDir().GetFullPath());
 		if ( !dir.IsOpened() )
 			return false;
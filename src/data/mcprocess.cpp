@@ -21,7 +21,12 @@
 #include "consolewindow.h"
 #include <insticonlist.h>
 #include <memory>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <wx/time.h>
 #include "launcher/launcherdata.h"
+#include "utils/lockfreequeue.h"
 #if !defined(WIN32)
 #include <sys/types.h>
 #include <sys/wait.h>
@@ -31,6 +36,105 @@
 // macro for adding "" around strings
 #define DQuote(X) "\"" << X << "\""
 
+// Size of the reads from the process pipes.
+const size_t readChunkSize = 64 * 1024;
+
+// How long to wait for the rest of the output after the process exits (in ms).
+const int outputWaitTime = 2000;
+
+struct OutputLine
+{
+	OutputLine() : isError(false) {}
+
+	std::string text;
+	bool isError;
+};
+
+// Shared by the process and its reader threads.
+struct ProcessOutput
+{
+	ProcessOutput() : stop(false), running(0) {}
+
+	// True once every reader hit the end of its pipe.
+	bool ReadersDone()
+	{
+		wxMutexLocker locker(lock);
+		return running == 0;
+	}
+
+	LockFreeQueue<OutputLine> lines;
+	std::atomic<bool> stop;
+
+	// number of readers still running, guarded by lock
+	int running;
+	wxMutex lock;
+};
+
+// Reads a pipe in big chunks and splits it into lines, so the game never 
+// waits for the GUI to empty its pipe.
+class PipeReaderThread : public wxThread
+{
+public:
+	PipeReaderThread(wxInputStream *stream, bool isError, std::shared_ptr<ProcessOutput> output)
+		: wxThread(wxTHREAD_DETACHED), m_stream(stream), m_isError(isError), m_output(output)
+	{
+		
+	}
+
+	virtual ~PipeReaderThread()
+	{
+		delete m_stream;
+	}
+
+protected:
+	virtual ExitCode Entry()
+	{
+		std::vector<char> buf(readChunkSize);
+		OutputLine line;
+		line.isError = m_isError;
+
+		while (!m_output->stop)
+		{
+			size_t read = m_stream->Read(&buf[0], buf.size()).LastRead();
+			if (read == 0)
+			{
+				if (m_stream->Eof())
+					break;
+
+				// Nothing there right now.
+				m_stream->Reset();
+				wxThread::Sleep(10);
+				continue;
+			}
+
+			for (size_t i = 0; i < read; i++)
+			{
+				char c = buf[i];
+				if (c == '\r')
+					continue;
+				if (c == '\n')
+				{
+					m_output->lines.Push(line);
+					line.text.clear();
+					continue;
+				}
+				line.text.push_back(c);
+			}
+		}
+
+		if (!line.text.empty())
+			m_output->lines.Push(line);
+
+		wxMutexLocker lock(m_output->lock);
+		m_output->running--;
+		return (ExitCode)0;
+	}
+
+	wxInputStream *m_stream;
+	bool m_isError;
+	std::shared_ptr<ProcessOutput> m_output;
+};
+
 void ExtractLauncher(Instance* source)
 {
 	// init streams
@@ -148,11 +252,16 @@ wxProcess* MinecraftProcess::Launch ( Instance* source, InstConsoleWindow* paren
 		lwjgl = fname.GetFullPath();
 	}
 	
-	wxString launchCmd;
+	wxString launchCmd, launchArgs;
 	launchCmd << DQuote(source->GetJavaPath()) << " " << javaArgs
 	          << " -Xms" << source->GetMinMemAlloc() << "m" << " -Xmx" << source->GetMaxMemAlloc() << "m"
 	          << " -jar MultiMCLauncher.jar "
-	          << " " << DQuote(username) << " " << DQuote(sessionID) << " " << DQuote(windowTitle) << " " << DQuote(winSizeArg) << " " << DQuote(lwjgl);
+	          << " " << DQuote(username) << " ";
+	launchArgs << " " << DQuote(windowTitle) << " " << DQuote(winSizeArg) << " " << DQuote(lwjgl);
+	
+	// the session ID is never shown
+	wxString shownCmd = launchCmd + DQuote("<session ID>") + launchArgs;
+	launchCmd << DQuote(sessionID) << launchArgs;
 	
 	// create a (custom) process object!
 	MinecraftProcess *instProc = new MinecraftProcess(source, parent);
@@ -175,12 +284,13 @@ wxProcess* MinecraftProcess::Launch ( Instance* source, InstConsoleWindow* paren
 	if(pid > 0)
 	{
 		instProc->m_pid = pid;
+		instProc->StartReaders();
 		parent->LinkProcess(instProc);
-		parent->AppendMessage(wxString::Format(_("Instance started with command:\n%s\n"), launchCmd.c_str()));
+		parent->AppendMessage(wxString::Format(_("Instance started with command:\n%s\n"), shownCmd.c_str()));
 	}
 	else
 	{
-		parent->AppendMessage(wxString::Format(_("Failed to start instance with command:\n%s\n"), launchCmd.c_str()),
+		parent->AppendMessage(wxString::Format(_("Failed to start instance with command:\n%s\n"), shownCmd.c_str()),
 		                      InstConsoleWindow::MSGT_STDERR);
 		parent->AppendMessage(_("This can mean that you either don't have Java installed,\n or that you need to set up Java path in MultiMC settings."),InstConsoleWindow::MSGT_STDERR);
 		delete instProc;
@@ -193,62 +303,94 @@ MinecraftProcess::MinecraftProcess(Instance * source, InstConsoleWindow* parent)
 	: wxProcess(wxPROCESS_REDIRECT), m_wasKilled(false), m_parent(parent), m_source(source)
 {
 	m_pid = 0;
+	m_exited = false;
+	m_exitPid = 0;
+	m_exitStatus = 0;
 }
 
-bool MinecraftProcess::ProcessInput()    // The following methods are adapted from the exec sample.  This one manages the stream redirection
+MinecraftProcess::~MinecraftProcess()
 {
-	int c;
-	bool hasInput = false;
-	// The original used wxTextInputStream to read a line at a time.  Fine, except when there was no \n, whereupon the thing would hang
-	// Instead, read the stream (which may occasionally contain non-ascii bytes e.g. from g++) into a memorybuffer, then to a wxString
-	while (IsInputAvailable())
+	if (m_output)
+		m_output->stop = true;
+}
+
+void MinecraftProcess::StartReaders()
+{
+	m_output = std::make_shared<ProcessOutput>();
+
+	// The reader threads own the streams from now on, since they may outlive this object.
+	wxInputStream *outStream = GetInputStream();
+	wxInputStream *errStream = GetErrorStream();
+	SetPipeStreams(nullptr, GetOutputStream(), nullptr);
+
+	wxInputStream *streams[] = { outStream, errStream };
+	for (int i = 0; i < 2; i++)
 	{
-		wxMemoryBuffer buf;
-		do
+		if (!streams[i])
+			continue;
+
 		{
-			// Get a char from the input
-			c = GetInputStream()->GetC();
-			if (c == wxEOF)
-				break;
-			if (c == '\r')
-				continue;
-			if (c== '\n')
-				break;
-			buf.AppendByte(c);
+			wxMutexLocker lock(m_output->lock);
+			m_output->running++;
+		}
+		PipeReaderThread *thread = new PipeReaderThread(streams[i], i == 1, m_output);
+		if (thread->Create() != wxTHREAD_NO_ERROR || thread->Run() != wxTHREAD_NO_ERROR)
+		{
+			// Without a reader the child would block on a full pipe.
+			wxLogError(_("Failed to start a thread to read Minecraft's output."));
+			delete thread;
+			delete streams[i];
+			wxMutexLocker lock(m_output->lock);
+			m_output->running--;
 		}
-		while (IsInputAvailable());// Unless \n, loop to get another char
-		
-		wxString line((const char*)buf.GetData(), wxConvLibc, buf.GetDataLen());
-		m_parent->AppendMessage(line,InstConsoleWindow::MSGT_STDOUT);
-		hasInput = true;
 	}
+}
+
+bool MinecraftProcess::ProcessInput()
+{
+	if (!m_output)
+		return false;
 
-	while (IsErrorAvailable())
+	bool hasInput = false;
+	OutputLine line;
+	while (m_output->lines.Pop(line))
 	{
-		wxMemoryBuffer buf;
-		do
-		{
-			c = GetErrorStream()->GetC();
-			if (c == wxEOF)
-				break;
-			if (c == '\r')
-				continue;
-			if (c== '\n')
-				break;
-			buf.AppendByte(c);
-		}
-		while (IsErrorAvailable());
-		wxString line((const char*)buf.GetData(), wxConvLibc, buf.GetDataLen());
-		m_parent->AppendMessage(line,InstConsoleWindow::MSGT_STDERR);
+		m_parent->AppendMessage(wxString(line.text.c_str(), wxConvLibc, line.text.size()),
+			line.isError ? InstConsoleWindow::MSGT_STDERR : InstConsoleWindow::MSGT_STDOUT);
 		hasInput = true;
 	}
 	return hasInput;
 }
 
-// empty the minecraft output buffers, notify the console window about process exiting
 void MinecraftProcess::OnTerminate(int pid, int status)
 {
-	while (ProcessInput());
+	// The pipes close when the process exits, but the readers may still be getting 
+	// the rest (or a child of the game keeps them open). The console's timer finishes 
+	// up once they are done, so the GUI never waits for them.
+	m_exited = true;
+	m_exitPid = pid;
+	m_exitStatus = status;
+	m_exitDeadline = wxGetLocalTimeMillis() + outputWaitTime;
+	CheckExit();
+}
+
+bool MinecraftProcess::CheckExit()
+{
+	if (!m_exited)
+		return false;
+	if (m_output && !m_output->ReadersDone() && wxGetLocalTimeMillis() < m_exitDeadline)
+		return false;
+	FinishExit();
+	return true;
+}
+
+// empty the minecraft output buffers, notify the console window about process exiting
+void MinecraftProcess::FinishExit()
+{
+	m_exited = false;
+	int pid = m_exitPid;
+	int status = m_exitStatus;
+	ProcessInput();
 
 	// Run post-exit command.
 	if (!m_source->GetPostExitCmd().IsEmpty())
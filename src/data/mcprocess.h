@@ -17,9 +17,12 @@
 #pragma once
 
 #include <wx/process.h>
+#include <wx/longlong.h>
+#include <memory>
 
 class InstConsoleWindow;
 class Instance;
+struct ProcessOutput;
 
 class MinecraftProcess : public wxProcess
 {
@@ -27,7 +30,17 @@ public:
 	static wxProcess *Launch(Instance * source, InstConsoleWindow* parent, wxString username, wxString sessionID);
 
 public:
+	virtual ~MinecraftProcess();
+
+	// Passes the lines the reader threads got so far on to the console.
+	// Returns true if there were any. Call this on the GUI thread.
 	bool ProcessInput();
+
+	// Finishes up once the process exited and the readers got the rest of its output
+	// (or waiting for that timed out). Returns true if it did, the console may have 
+	// deleted this object then. Call this on the GUI thread.
+	bool CheckExit();
+
 	void KillMinecraft();
 	bool AlreadyKilled() const
 	{
@@ -36,7 +49,19 @@ public:
 protected:
 	MinecraftProcess(Instance * source, InstConsoleWindow* parent);
 	void OnTerminate ( int pid, int status );
+	void FinishExit();
+
+	// Hands stdout and stderr over to a reader thread each.
+	void StartReaders();
+
+	std::shared_ptr<ProcessOutput> m_output;
 	bool m_wasKilled;
+
+	// set by OnTerminate until the exit is handled
+	bool m_exited;
+	int m_exitPid;
+	int m_exitStatus;
+	wxLongLong m_exitDeadline;
 	InstConsoleWindow* m_parent;
 	Instance * m_source;
 };
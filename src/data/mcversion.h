@@ -48,6 +48,21 @@ public:
 		ver.SetVersionType(MCRewind);
 		return ver;
 	}
+	// A copy that shares no strings with this one, so it can be handed to another thread.
+	MCVersion Clone() const
+	{
+		if(linkedVersion)
+		{
+			MCVersion ver = linkedVersion->Clone();
+			ver.descriptor = descriptor.Clone();
+			ver.patchTargetVersion = patchTargetVersion.Clone();
+			return ver;
+		}
+		MCVersion ver(descriptor.Clone(), name.Clone(), unixTimestamp, dlURL.Clone(), has_lwjgl, etag.Clone());
+		ver.patchTargetVersion = patchTargetVersion.Clone();
+		ver.type = type;
+		return ver;
+	}
 	wxString GetDLUrl() const
 	{
 		if(linkedVersion)
@@ -85,6 +100,12 @@ public:
 			return linkedVersion->GetTimestamp();
 		return unixTimestamp;
 	}
+	bool HasLWJGL() const
+	{
+		if(linkedVersion)
+			return linkedVersion->HasLWJGL();
+		return has_lwjgl;
+	}
 	bool IsMeta() const
 	{
 		return type == MetaCustom || type == MetaLatestSnapshot || type == MetaLatestStable;
@@ -16,24 +16,30 @@
 
 #include "mcversionlist.h"
 
-#include <boost/property_tree/xml_parser.hpp>
-#include <boost/property_tree/json_parser.hpp>
-#include <boost/foreach.hpp>
-
 #include <string>
-#include <sstream>
 #include <map>
+#include <functional>
 
 #include <wx/regex.h>
 #include <wx/numformatter.h>
 #include <wx/datetime.h>
+#include <wx/wfstream.h>
 
+#include "appsettings.h"
 #include "utils/httputils.h"
 #include "utils/apputils.h"
+#include "utils/datautils.h"
+#include "utils/feedparser.h"
 
 //#define PRINT_CRUD
 
 const wxString mcrwIndexURL = "http://mcrw.forkk.net/index.json";
+const wxString mojangURL = "http://s3.amazonaws.com/MinecraftDownload/";
+// ``broken'' URL for testing
+//const wxString mojangURL = "http://dethware.org/dl/";
+const wxString assetsURL = "http://assets.minecraft.net/";
+
+const wxString cacheHeader = "MultiMC version list cache 1";
 
 class initme
 {
@@ -82,12 +88,80 @@ wxString MCRWVersionToAssetsVersion(wxString mcrw_version)
 	return mcrw_version;
 }
 
+static wxString GetCacheFile(const wxString &name = "versionlist")
+{
+	wxFileName cacheDir = settings->GetLibCacheDir();
+	if (!cacheDir.DirExists())
+		cacheDir.Mkdir(0777, wxPATH_MKDIR_FULL);
+	return Path::Combine(cacheDir, name);
+}
+
+// The copy of a feed that's parsed again when it didn't change.
+static wxString GetFeedFile(const wxString &url)
+{
+	if (url == mcrwIndexURL)
+		return GetCacheFile("versionlist-mcrw.json");
+	else if (url == assetsURL)
+		return GetCacheFile("versionlist-assets.xml");
+	return GetCacheFile("versionlist-mojang.xml");
+}
+
 MCVersionList* MCVersionList::pInstance = 0;
 
+static const wxEventType wxEVT_VERSION_LIST_REFRESHED = wxNewEventType();
+
+// Swaps refreshed lists in on the main thread.
+class VersionListRefreshHandler : public wxEvtHandler
+{
+public:
+	virtual bool ProcessEvent(wxEvent &event)
+	{
+		if (event.GetEventType() != wxEVT_VERSION_LIST_REFRESHED)
+			return wxEvtHandler::ProcessEvent(event);
+		MCVersionList::Instance().ApplyRefresh();
+		return true;
+	}
+};
+
+class VersionListRefreshThread : public wxThread
+{
+public:
+	VersionListRefreshThread(MCVersionList *list, MCVersionList::ListData *data, bool withMCRW)
+		: wxThread(wxTHREAD_DETACHED), m_list(list), m_data(data), m_withMCRW(withMCRW) {}
+
+	~VersionListRefreshThread()
+	{
+		delete m_data;
+	}
+
+protected:
+	virtual ExitCode Entry()
+	{
+		// Nobody is waiting for this, so don't bother the user if it fails.
+		// The cached lists are still good.
+		wxLogNull noLog;
+		if (MCVersionList::RefreshLists(*m_data, m_withMCRW))
+		{
+			m_list->QueueRefresh(m_data);
+			m_data = nullptr;
+		}
+		return (ExitCode)0;
+	}
+
+	MCVersionList *m_list;
+	MCVersionList::ListData *m_data;
+	bool m_withMCRW;
+};
+
 MCVersionList::MCVersionList()
 {
 	stableVersionIndex = -1;
 	includesMCRW = false;
+	cacheLoaded = false;
+	refreshStarted = false;
+	refreshed = nullptr;
+	holds = 0;
+	refreshHandler = new VersionListRefreshHandler();
 }
 
 bool TimeFromS3Time(wxString str, wxDateTime & datetime)
@@ -103,266 +177,337 @@ bool compareVersions(const MCVersion & left, const MCVersion & right)
 	return left.GetTimestamp() > right.GetTimestamp();
 }
 
-MCVersion * MCVersionList::GetVersion ( wxString descriptor )
+// The <Contents> entries of an S3 bucket listing whose keys pass the filter.
+class BucketListing
 {
-	if(descriptor == MCVer_Unknown)
-		return nullptr;
-	else
+public:
+	struct Entry
+	{
+		wxString key;
+		wxString lastModified;
+		wxString etag;
+	};
+
+	BucketListing(std::function<bool (const std::string &key)> filter, bool firstOnly)
+		: m_filter(filter), m_firstOnly(firstOnly), m_fields(0), m_sawRoot(false), m_badFormat(false)
 	{
-		auto descriptorPredicate = [&descriptor](MCVersion & ver){ return ver.GetDescriptor() == descriptor;};
-		auto found = std::find_if(versions.begin(), versions.end(), descriptorPredicate);
-		if(found != versions.end())
+		parser.onStartElement = [this] (const std::string &path)
 		{
-			return &*found;
-		}
-		found = std::find_if(mcrw_versions.begin(), mcrw_versions.end(), descriptorPredicate);
-		if(found != mcrw_versions.end())
+			if (path == "ListBucketResult/Contents")
+				m_fields = 0;
+		};
+		parser.onEndElement = [this] (const std::string &path, const std::string &text)
 		{
-			return &*found;
+			if (path == "ListBucketResult/Contents/Key")
+			{
+				m_key = text;
+				m_fields |= 1;
+			}
+			else if (path == "ListBucketResult/Contents/LastModified")
+			{
+				m_lastModified = text;
+				m_fields |= 2;
+			}
+			else if (path == "ListBucketResult/Contents/ETag")
+			{
+				m_etag = text;
+				m_fields |= 4;
+			}
+			else if (path == "ListBucketResult/Contents")
+				EndEntry();
+			else if (path == "ListBucketResult")
+				m_sawRoot = true;
+		};
+	}
+
+	// True if the listing parsed but didn't look like a bucket listing.
+	bool IsBadFormat() const
+	{
+		return m_badFormat || (!parser.IsStopped() && !m_sawRoot);
+	}
+
+	XmlStreamParser parser;
+	std::vector<Entry> entries;
+
+protected:
+	void EndEntry()
+	{
+		if (m_fields != 7)
+		{
+			m_badFormat = true;
+			parser.Stop();
+			return;
 		}
-		return nullptr;
+		if (!m_filter(m_key))
+			return;
+
+		Entry entry;
+		entry.key = wxStr(m_key);
+		entry.lastModified = wxStr(m_lastModified);
+		entry.etag = wxStr(m_etag);
+		entries.push_back(entry);
+		if (m_firstOnly)
+			parser.Stop();
 	}
-}
 
-MCVersion* MCVersionList::GetCurrentStable()
+	std::function<bool (const std::string &key)> m_filter;
+	bool m_firstOnly;
+	std::string m_key;
+	std::string m_lastModified;
+	std::string m_etag;
+	int m_fields;
+	bool m_sawRoot;
+	bool m_badFormat;
+};
+
+// The main bucket only matters for its minecraft.jar.
+static bool IsStableJar(const std::string &key)
 {
-	if(versions.empty() || stableVersionIndex == -1)
-		return nullptr;
-	return &versions[stableVersionIndex];
+	return key == "minecraft.jar";
 }
 
+// The assets bucket has a <version>/minecraft.jar for every version.
+static bool IsAssetsJar(const std::string &key)
+{
+	const std::string suffix = "/minecraft.jar";
+	return key.size() > suffix.size() && key.compare(key.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
 
-bool MCVersionList::LoadIfNeeded()
+// The version names and MD5 sums from the MCRewind index.
+class MCRWIndex
 {
-	bool OK = true;
-	if(NeedsMojangLoad())
+public:
+	MCRWIndex()
+		: m_fields(0), m_haveMCVersion(false), m_badFormat(false)
 	{
-		OK &= LoadMojang();
+		parser.onStartObject = [this] (const std::string &path)
+		{
+			if (path == "versions/[]")
+				m_fields = 0;
+		};
+		parser.onValue = [this] (const std::string &path, const std::string &value)
+		{
+			if (path == "mcversion")
+			{
+				mcVersion = wxStr(value);
+				m_haveMCVersion = true;
+			}
+			else if (path == "versions/[]/name")
+			{
+				m_name = value;
+				m_fields |= 1;
+			}
+			else if (path == "versions/[]/md5")
+			{
+				m_md5 = value;
+				m_fields |= 2;
+			}
+		};
+		parser.onEndObject = [this] (const std::string &path)
+		{
+			if (path != "versions/[]")
+				return;
+			if (m_fields != 3)
+			{
+				m_badFormat = true;
+				parser.Stop();
+				return;
+			}
+			names.push_back(wxStr(m_name));
+			md5s.push_back(wxStr(m_md5));
+		};
 	}
-	if(NeedsMCRWLoad())
+
+	bool IsBadFormat() const
 	{
-		OK &= LoadMCRW();
+		return m_badFormat || !m_haveMCVersion;
 	}
-	return OK;
-}
 
-bool MCVersionList::LoadMCRW()
+	JsonStreamParser parser;
+	wxString mcVersion;
+	std::vector<wxString> names;
+	std::vector<wxString> md5s;
+
+protected:
+	std::string m_name;
+	std::string m_md5;
+	int m_fields;
+	bool m_haveMCVersion;
+	bool m_badFormat;
+};
+
+// Builds the MCRewind version list, leaving out versions that are in the Mojang list.
+static bool BuildMCRWList(const MCRWIndex &mcrwIndex, const std::vector<MCVersion> &versions, 
+	std::vector<MCVersion> &mcrw_versions)
 {
 	mcrw_versions.clear();
 	if(!versions.size())
 		return false;
-	wxString vlistJSON;
-	if (DownloadString(mcrwIndexURL, &vlistJSON))
-	{
-		using namespace boost::property_tree;
 
-		try
-		{
-			// Parse the JSON
-			ptree pt;
-			std::stringstream jsonStream(stdStr(vlistJSON), std::ios::in);
-			read_json(jsonStream, pt);
-			wxRegEx indevRegex("in(f)?dev");
-			wxString mcVersion = wxStr(pt.get<std::string>("mcversion"));
-			BOOST_FOREACH(const ptree::value_type& v, pt.get_child("versions"))
-			{
-				wxString rawVersion = wxStr(v.second.get<std::string>("name"));
-				if(indevRegex.Matches(rawVersion))
-					continue;
-				wxString niceVersion = MCRWVersionToAssetsVersion(rawVersion);
-				if(niceVersion.empty())
-					continue;
-				if(GetVersion(niceVersion))
-					continue;
-
-				wxString md5sum = wxStr(v.second.get<std::string>("md5"));
-
-				MCVersion ver = MCVersion::getMCRVersion(rawVersion, niceVersion, mcVersion, md5sum);
-				mcrw_versions.insert(mcrw_versions.begin(),ver);
-			}
-		}
-		catch (json_parser_error e)
-		{
-			wxLogError(_("Failed to read MCRewind list.\nJSON parser error at line %i: %s"), 
-				e.line(), wxStr(e.message()).c_str());
-			return false;
-		}
-		catch (ptree_error)
-		{
-			wxLogError(_("Failed to read MCRewind list.\nThe format either changed or the server returned something else."));
-			return false;
-		}
-		return true;
+	if (mcrwIndex.parser.HasError())
+	{
+		wxLogError(_("Failed to read MCRewind list.\nJSON parser error at line %i: %s"), 
+			mcrwIndex.parser.GetLine(), wxStr(mcrwIndex.parser.GetError()).c_str());
+		return false;
 	}
-	else
+	if (mcrwIndex.IsBadFormat())
 	{
-		wxLogError(_("Failed to get MCRewind list. Check your internet connection and try again later."));
+		wxLogError(_("Failed to read MCRewind list.\nThe format either changed or the server returned something else."));
 		return false;
 	}
+
+	MCVersionIndex known;
+	for(unsigned i = 0; i < versions.size(); i++)
+		known[versions[i].GetDescriptor()] = i;
+
+	wxRegEx indevRegex("in(f)?dev");
+	for(unsigned i = 0; i < mcrwIndex.names.size(); i++)
+	{
+		wxString rawVersion = mcrwIndex.names[i];
+		if(indevRegex.Matches(rawVersion))
+			continue;
+		wxString niceVersion = MCRWVersionToAssetsVersion(rawVersion);
+		if(niceVersion.empty())
+			continue;
+		if(known.find(niceVersion) != known.end())
+			continue;
+
+		MCVersion ver = MCVersion::getMCRVersion(rawVersion, niceVersion, mcrwIndex.mcVersion, mcrwIndex.md5s[i]);
+		mcrw_versions.insert(mcrw_versions.begin(),ver);
+		known[rawVersion] = 0;
+	}
+	return true;
 }
 
-bool MCVersionList::LoadMojang()
+// Builds the version list from the S3 bucket listing and the assets listing.
+// gotMain and gotAssets say whether they were downloaded and parsed without errors.
+static bool BuildMojangList(const BucketListing &main, bool gotMain, const BucketListing &assets, bool gotAssets,
+	std::vector<MCVersion> &versions, int &stableVersionIndex)
 {
-	using namespace boost::property_tree;
 	versions.clear();
 	stableVersionIndex = -1;
 	MCVersion currentStable;
 	bool currentStableFound = false;
 	
-	wxString mainXML = wxEmptyString;
-	
-	wxString MojangURL = "http://s3.amazonaws.com/MinecraftDownload/";
-	// ``broken'' URL for testing
-	//wxString MojangURL = "http://dethware.org/dl/";
 	bool suppress_error = false;
 	
-	if (DownloadString(MojangURL, &mainXML))
+	if (main.parser.HasError())
 	{
-		try
-		{
-			ptree pt;
-			std::stringstream inStream(stdStr(mainXML), std::ios::in);
-			read_xml(inStream, pt);
-			BOOST_FOREACH(const ptree::value_type& v, pt.get_child("ListBucketResult"))
-			{
-				if (v.first != "Contents")
-					continue;
-				wxString keyName = wxStr(v.second.get<std::string>("Key"));
-				if(keyName != "minecraft.jar")
-					continue;
-				wxString datetimeStr = wxStr(v.second.get<std::string>("LastModified"));
-				wxString etag = wxStr(v.second.get<std::string>("ETag"));
-				// use some kind of sensible time if we fail to parse it
-				wxDateTime dtt;
-				if(!TimeFromS3Time(datetimeStr, dtt))
-				{
-					wxLogError(_("Failed to parse date/time: %s %s"), keyName.c_str() , datetimeStr.c_str());
-					dtt.SetToCurrent();
-				}
-				MCVersion version("LatestStable",_("Current"),dtt.GetTicks(),"http://s3.amazonaws.com/MinecraftDownload/",true,etag);
-				currentStable = version;
-				currentStableFound = true;
-				break;
-			}
-		}
-		catch (xml_parser_error e)
-		{
-			wxLogError(_("Failed to get the current stable version.\nEncountered a parser error at line %i: %s"), e.line(), e.message().c_str());
-			suppress_error = true;
-		}
-		catch (ptree_error e)
+		wxLogError(_("Failed to get the current stable version.\nEncountered a parser error at line %i: %s"), 
+			main.parser.GetLine(), wxStr(main.parser.GetError()).c_str());
+		suppress_error = true;
+	}
+	else if (gotMain && main.IsBadFormat())
+	{
+		wxLogError(_("Failed to get the current stable version.\nThe list format might have changed.\nPlease report this as a bug."));
+		suppress_error = true;
+	}
+	else if (gotMain && !main.entries.empty())
+	{
+		const BucketListing::Entry &entry = main.entries[0];
+		// use some kind of sensible time if we fail to parse it
+		wxDateTime dtt;
+		if(!TimeFromS3Time(entry.lastModified, dtt))
 		{
-			wxLogError(_("Failed to get the current stable version.\nThe list format might have changed.\nPlease report this as a bug."));
-			suppress_error = true;
+			wxLogError(_("Failed to parse date/time: %s %s"), entry.key.c_str() , entry.lastModified.c_str());
+			dtt.SetToCurrent();
 		}
+		MCVersion version("LatestStable",_("Current"),dtt.GetTicks(),mojangURL,true,entry.etag);
+		currentStable = version;
+		currentStableFound = true;
 	}
 	if(!currentStableFound && !suppress_error)
 		wxLogError(_("Failed to get the current stable version.\nCheck your internet connection."));
 	
 	// Getting snapshots from the assets site is optional.
 	// If it stops working, it shouldn't affect getting the current version
-	bool have_snapshots = false;
 	bool found_current_in_assets = false;
-	wxString assetsXML = wxEmptyString;
-	if (DownloadString("http://assets.minecraft.net/", &assetsXML))
+	if (assets.parser.HasError())
 	{
-		try
-		{
-			ptree pt;
-			std::stringstream inStream(stdStr(assetsXML), std::ios::in);
-			read_xml(inStream, pt);
+		wxLogError(_("Failed to parse snapshot list.\nXML parser error at line %i: %s"), 
+			assets.parser.GetLine(), wxStr(assets.parser.GetError()).c_str());
+	}
+	else if (gotAssets && assets.IsBadFormat())
+	{
+		wxLogError(_("Failed to parse snapshot list fully.\nThe format might have changed.\nPlease report this as a bug."));
+	}
 
-			wxRegEx mcRegex("/minecraft.jar$");
-			wxRegEx snapshotRegex("[0-9][0-9]w[0-9][0-9][a-z]|pre|rc");
-			BOOST_FOREACH(const ptree::value_type& v, pt.get_child("ListBucketResult"))
-			{
-				if (v.first != "Contents")
-					continue;
-				
-				wxString Key = wxStr(v.second.get<std::string>("Key"));
-				wxString datetimeStr = wxStr(v.second.get<std::string>("LastModified"));
-				wxString etag = wxStr(v.second.get<std::string>("ETag"));
-				
-				if (!mcRegex.Matches(Key))
-					continue;
-				wxString versionID = Key.Left(Key.Len() - 14);
-				
-				wxString dlUrl;
-				dlUrl << "http://assets.minecraft.net/" << versionID << "/";
-				
-				wxString versionName = versionID;
-				for(unsigned i = 0; i < versionName.size();i++)
-				{
-					if(versionName[i] == '_')
-						versionName[i] = '.';
-				}
-				
-				wxDateTime dtt;
-				if(!TimeFromS3Time(datetimeStr, dtt))
-				{
-					wxLogError(_("Failed to parse date/time: %s %s"), versionName.c_str() , datetimeStr.c_str());
-					dtt.SetToCurrent();
-				}
-				
-				if(currentStableFound && ver.MatchEtags(etag, currentStable.GetEtag()))
-				{
-					MCVersion version(versionName,versionName,dtt.GetTicks(),currentStable.GetDLUrl(),true,etag);
-					version.SetVersionType(CurrentStable);
-					versions.push_back(version);
-					found_current_in_assets = true;
-				}
-				else if (currentStableFound)
-				{
-					bool older = dtt.GetTicks() < currentStable.GetTimestamp();
-					bool newer = dtt.GetTicks() > currentStable.GetTimestamp();
-					bool isSnapshot = snapshotRegex.Matches(versionName);
-					MCVersion version(versionName, versionName,dtt.GetTicks(),dlUrl,false,etag);
-					if(newer)
-					{
-						version.SetVersionType(Snapshot);
-					}
-					else if(older && isSnapshot)
-					{
-						version.SetVersionType(OldSnapshot);
-					}
-					else if(older)
-					{
-						version.SetVersionType(Stable);
-					}
-					else
-					{
-						// shouldn't happen, right? we handle this above
-						version.SetVersionType(CurrentStable);
-					}
-					versions.push_back(version);
-				}
-				else // there is no current stable :<
-				{
-					bool isSnapshot = snapshotRegex.Matches(versionName);
-					MCVersion version(versionName,versionName,dtt.GetTicks(),dlUrl,false,etag);
-					if(isSnapshot)
-					{
-						version.SetVersionType(Snapshot);
-					}
-					else
-					{
-						version.SetVersionType(Stable);
-					}
-					versions.push_back(version);
-				}
-			}
-		}
-		catch (xml_parser_error e)
+	// If the format was off, whatever was read before that is still good.
+	wxRegEx snapshotRegex("[0-9][0-9]w[0-9][0-9][a-z]|pre|rc");
+	unsigned assetCount = gotAssets ? assets.entries.size() : 0;
+	for (unsigned j = 0; j < assetCount; j++)
+	{
+		const wxString &Key = assets.entries[j].key;
+		const wxString &datetimeStr = assets.entries[j].lastModified;
+		const wxString &etag = assets.entries[j].etag;
+
+		wxString versionID = Key.Left(Key.Len() - 14);
+		
+		wxString dlUrl;
+		dlUrl << assetsURL << versionID << "/";
+		
+		wxString versionName = versionID;
+		for(unsigned i = 0; i < versionName.size();i++)
 		{
-			wxLogError(_("Failed to parse snapshot list.\nXML parser error at line %i: %s"), 
-				e.line(), wxStr(e.message()).c_str());
+			if(versionName[i] == '_')
+				versionName[i] = '.';
 		}
-		catch (ptree_error e)
+		
+		wxDateTime dtt;
+		if(!TimeFromS3Time(datetimeStr, dtt))
 		{
-			wxLogError(_("Failed to parse snapshot list fully.\nThe format might have changed.\nPlease report this as a bug."));
+			wxLogError(_("Failed to parse date/time: %s %s"), versionName.c_str() , datetimeStr.c_str());
+			dtt.SetToCurrent();
 		}
 		
+		if(currentStableFound && ver.MatchEtags(etag, currentStable.GetEtag()))
+		{
+			MCVersion version(versionName,versionName,dtt.GetTicks(),currentStable.GetDLUrl(),true,etag);
+			version.SetVersionType(CurrentStable);
+			versions.push_back(version);
+			found_current_in_assets = true;
+		}
+		else if (currentStableFound)
+		{
+			bool older = dtt.GetTicks() < currentStable.GetTimestamp();
+			bool newer = dtt.GetTicks() > currentStable.GetTimestamp();
+			bool isSnapshot = snapshotRegex.Matches(versionName);
+			MCVersion version(versionName, versionName,dtt.GetTicks(),dlUrl,false,etag);
+			if(newer)
+			{
+				version.SetVersionType(Snapshot);
+			}
+			else if(older && isSnapshot)
+			{
+				version.SetVersionType(OldSnapshot);
+			}
+			else if(older)
+			{
+				version.SetVersionType(Stable);
+			}
+			else
+			{
+				// shouldn't happen, right? we handle this above
+				version.SetVersionType(CurrentStable);
+			}
+			versions.push_back(version);
+		}
+		else // there is no current stable :<
+		{
+			bool isSnapshot = snapshotRegex.Matches(versionName);
+			MCVersion version(versionName,versionName,dtt.GetTicks(),dlUrl,false,etag);
+			if(isSnapshot)
+			{
+				version.SetVersionType(Snapshot);
+			}
+			else
+			{
+				version.SetVersionType(Stable);
+			}
+			versions.push_back(version);
+		}
 	}
+
 	// if this ever happens, we need to inject the current version into the list, if it exists
 	if(!found_current_in_assets && currentStableFound)
 	{
@@ -417,6 +562,384 @@ bool MCVersionList::LoadMojang()
 	return versions.size() != 0;
 }
 
+MCVersion * MCVersionList::GetVersion ( wxString descriptor )
+{
+	if(descriptor == MCVer_Unknown)
+		return nullptr;
+	wxMutexLocker lock(refreshLock);
+	auto found = index.find(descriptor);
+	if(found == index.end())
+		return nullptr;
+	return &(*this)[found->second];
+}
+
+bool MCVersionList::FindIn(const std::vector<MCVersion> &list, const wxString &descriptor, 
+	MCVersion &version)
+{
+	for (auto iter = list.begin(); iter != list.end(); ++iter)
+	{
+		if (iter->GetDescriptor() == descriptor)
+		{
+			version = iter->Clone();
+			return true;
+		}
+	}
+	return false;
+}
+
+bool MCVersionList::FindVersion(const wxString &descriptor, MCVersion &version)
+{
+	if(descriptor == MCVer_Unknown)
+		return false;
+	wxMutexLocker lock(refreshLock);
+	if (refreshed)
+	{
+		if (FindIn(refreshed->versions, descriptor, version) || 
+			(refreshed->hasMCRW && FindIn(refreshed->mcrw_versions, descriptor, version)))
+			return true;
+	}
+	auto found = index.find(descriptor);
+	if(found == index.end())
+		return false;
+	version = (*this)[found->second].Clone();
+	return true;
+}
+
+MCVersion* MCVersionList::GetCurrentStable()
+{
+	if(versions.empty() || stableVersionIndex == -1)
+		return nullptr;
+	return &versions[stableVersionIndex];
+}
+
+
+bool MCVersionList::LoadIfNeeded()
+{
+	bool OK = true;
+	if(NeedsMojangLoad())
+	{
+		OK &= LoadMojang();
+	}
+	if(NeedsMCRWLoad())
+	{
+		OK &= LoadMCRW();
+	}
+	return OK;
+}
+
+bool MCVersionList::NeedsMojangLoad()
+{
+	LoadCacheIfNeeded();
+	return versions.size() == 0;
+}
+
+bool MCVersionList::NeedsMCRWLoad()
+{
+	LoadCacheIfNeeded();
+	return includesMCRW && mcrw_versions.size() == 0;
+}
+
+bool MCVersionList::LoadMCRW()
+{
+	ListData data;
+	if (!versions.size())
+	{
+		wxMutexLocker lock(refreshLock);
+		SetLists(data, false, true);
+		return false;
+	}
+
+	MCRWIndex mcrwIndex;
+	bool notModified;
+	if (!DownloadParsedIfModified(mcrwIndexURL, mcrwIndex.parser, data.feeds[mcrwIndexURL], 
+		GetFeedFile(mcrwIndexURL), &notModified) && !mcrwIndex.parser.HasError())
+	{
+		wxLogError(_("Failed to get MCRewind list. Check your internet connection and try again later."));
+		wxMutexLocker lock(refreshLock);
+		SetLists(data, false, true);
+		return false;
+	}
+
+	bool success = BuildMCRWList(mcrwIndex, versions, data.mcrw_versions);
+	{
+		wxMutexLocker lock(refreshLock);
+		SetLists(data, false, true);
+	}
+	SaveCache();
+	return success;
+}
+
+bool MCVersionList::LoadMojang()
+{
+	ListData data;
+	BucketListing main(IsStableJar, true);
+	BucketListing assets(IsAssetsJar, false);
+	bool notModified;
+	bool gotMain = DownloadParsedIfModified(mojangURL, main.parser, data.feeds[mojangURL], 
+		GetFeedFile(mojangURL), &notModified);
+	bool gotAssets = DownloadParsedIfModified(assetsURL, assets.parser, data.feeds[assetsURL], 
+		GetFeedFile(assetsURL), &notModified);
+
+	BuildMojangList(main, gotMain, assets, gotAssets, data.versions, data.stableVersionIndex);
+	{
+		wxMutexLocker lock(refreshLock);
+		SetLists(data, true, false);
+	}
+	SaveCache();
+	return versions.size() != 0;
+}
+
+bool MCVersionList::Reload()
+{
+	// No ETags, so everything is downloaded.
+	ListData *data = new ListData();
+	if (!RefreshLists(*data, includesMCRW))
+	{
+		delete data;
+		return false;
+	}
+	QueueRefresh(data);
+	return true;
+}
+
+bool MCVersionList::RefreshLists(ListData &data, bool withMCRW)
+{
+	BucketListing main(IsStableJar, true);
+	BucketListing assets(IsAssetsJar, false);
+	MCRWIndex mcrwIndex;
+
+	const wxString urls[] = { mojangURL, assetsURL, mcrwIndexURL };
+	FeedParser *parsers[] = { &main.parser, &assets.parser, &mcrwIndex.parser };
+	const int feedCount = withMCRW ? 3 : 2;
+	bool notModified[3];
+
+	// The lists are built from all feeds together. Feeds that didn't change are parsed
+	// from the copies kept from last time.
+	bool anyModified = false;
+	for (int i = 0; i < feedCount; i++)
+	{
+		if (!DownloadParsedIfModified(urls[i], *parsers[i], data.feeds[urls[i]], 
+			GetFeedFile(urls[i]), &notModified[i]))
+			return false;
+		anyModified |= !notModified[i];
+	}
+	if (!anyModified)
+		return false;
+
+	if (!BuildMojangList(main, true, assets, true, data.versions, data.stableVersionIndex))
+		return false;
+	if (withMCRW)
+	{
+		if (!BuildMCRWList(mcrwIndex, data.versions, data.mcrw_versions))
+			return false;
+		data.hasMCRW = true;
+	}
+	return true;
+}
+
+void MCVersionList::SetLists(ListData &data, bool setMojang, bool setMCRW)
+{
+	if (setMojang)
+	{
+		versions.swap(data.versions);
+		stableVersionIndex = data.stableVersionIndex;
+		feeds[mojangURL] = data.feeds[mojangURL];
+		feeds[assetsURL] = data.feeds[assetsURL];
+	}
+	if (setMCRW)
+	{
+		mcrw_versions.swap(data.mcrw_versions);
+		feeds[mcrwIndexURL] = data.feeds[mcrwIndexURL];
+	}
+	RebuildIndex();
+}
+
+void MCVersionList::RebuildIndex()
+{
+	// Mojang versions win over MCRewind versions with the same descriptor.
+	index.clear();
+	for (std::size_t i = 0; i < size(); i++)
+	{
+		wxString descriptor = (*this)[i].GetDescriptor();
+		if (index.find(descriptor) == index.end())
+			index[descriptor] = i;
+	}
+}
+
+void MCVersionList::LoadCacheIfNeeded()
+{
+	{
+		wxMutexLocker lock(refreshLock);
+		if (cacheLoaded)
+			return;
+		cacheLoaded = true;
+	}
+
+	wxString cacheFile = GetCacheFile();
+	if (!wxFileExists(cacheFile))
+		return;
+
+	wxFFileInputStream inStream(cacheFile);
+	if (!inStream.IsOk())
+		return;
+	wxArrayString lines = ReadAllLines(inStream);
+	if (lines.IsEmpty() || lines[0] != cacheHeader)
+		return;
+
+	// feed <url> <etag> <last modified>
+	// stable <index>
+	// version <descriptor> <name> <timestamp> <download URL> <has lwjgl> <etag> <type>
+	// mcrw <descriptor> <name> <patch target version> <md5>
+	ListData data;
+	for (size_t i = 1; i < lines.size(); i++)
+	{
+		wxArrayString fields = wxSplit(lines[i], '\t', '\0');
+		if (fields.IsEmpty())
+			continue;
+		for (size_t j = 0; j < fields.size(); j++)
+			fields[j] = UnescapeField(fields[j]);
+
+		if (fields[0] == "feed" && fields.size() == 4)
+		{
+			data.feeds[fields[1]].etag = fields[2];
+			data.feeds[fields[1]].lastModified = fields[3];
+		}
+		else if (fields[0] == "stable" && fields.size() == 2)
+		{
+			long stable;
+			if (fields[1].ToLong(&stable))
+				data.stableVersionIndex = stable;
+		}
+		else if (fields[0] == "version" && fields.size() == 8)
+		{
+			wxULongLong_t timestamp;
+			long type;
+			if (!fields[3].ToULongLong(&timestamp) || !fields[7].ToLong(&type) || 
+				type < OldSnapshot || type > Snapshot)
+			{
+				continue;
+			}
+			MCVersion version(fields[1], fields[2], timestamp, fields[4], fields[5] == "1", fields[6]);
+			version.SetVersionType((VersionType)type);
+			data.versions.push_back(version);
+		}
+		else if (fields[0] == "mcrw" && fields.size() == 5)
+		{
+			data.mcrw_versions.push_back(
+				MCVersion::getMCRVersion(fields[1], fields[2], fields[3], fields[4]));
+		}
+	}
+
+	if (data.stableVersionIndex >= (int)data.versions.size())
+		data.stableVersionIndex = -1;
+
+	{
+		wxMutexLocker lock(refreshLock);
+		bool setMojang = versions.empty() && !data.versions.empty();
+		bool setMCRW = setMojang && mcrw_versions.empty() && !data.mcrw_versions.empty();
+		if (!setMojang)
+			return;
+		SetLists(data, setMojang, setMCRW);
+	}
+	StartRefresh();
+}
+
+void MCVersionList::SaveCache()
+{
+	wxMutexLocker lock(refreshLock);
+	if (versions.empty())
+		return;
+
+	wxString text;
+	text << cacheHeader << "\n";
+	for (auto iter = feeds.begin(); iter != feeds.end(); ++iter)
+	{
+		text << "feed\t" << EscapeField(iter->first) << "\t" << EscapeField(iter->second.etag) << "\t"
+			<< EscapeField(iter->second.lastModified) << "\n";
+	}
+	text << "stable\t" << stableVersionIndex << "\n";
+	for (size_t i = 0; i < versions.size(); i++)
+	{
+		const MCVersion &v = versions[i];
+		text << "version\t" << EscapeField(v.GetDescriptor()) << "\t" << EscapeField(v.GetName()) << "\t"
+			<< wxString::Format("%" wxLongLongFmtSpec "u", (wxULongLong_t)v.GetTimestamp()) << "\t"
+			<< EscapeField(v.GetDLUrl()) << "\t" << (v.HasLWJGL() ? "1" : "0") << "\t"
+			<< EscapeField(v.GetEtag()) << "\t" << (int)v.GetVersionType() << "\n";
+	}
+	for (size_t i = 0; i < mcrw_versions.size(); i++)
+	{
+		const MCVersion &v = mcrw_versions[i];
+		text << "mcrw\t" << EscapeField(v.GetDescriptor()) << "\t" << EscapeField(v.GetName()) << "\t"
+			<< EscapeField(v.GetPatchTargetVersion()) << "\t" << EscapeField(v.GetEtag()) << "\n";
+	}
+
+	wxTempFileOutputStream out(GetCacheFile());
+	WriteAllText(out, text);
+	out.Commit();
+}
+
+void MCVersionList::StartRefresh()
+{
+	if (refreshStarted)
+		return;
+	refreshStarted = true;
+
+	// The thread gets its own copies of the strings.
+	ListData *data = new ListData();
+	for (auto iter = feeds.begin(); iter != feeds.end(); ++iter)
+	{
+		HttpCacheInfo &info = data->feeds[iter->first.Clone()];
+		info.etag = iter->second.etag.Clone();
+		info.lastModified = iter->second.lastModified.Clone();
+	}
+	VersionListRefreshThread *thread = new VersionListRefreshThread(this, data, !mcrw_versions.empty());
+	if (thread->Run() != wxTHREAD_NO_ERROR)
+		delete thread;
+}
+
+void MCVersionList::QueueRefresh(ListData *data)
+{
+	wxMutexLocker lock(refreshLock);
+	delete refreshed;
+	refreshed = data;
+	wxCommandEvent event(wxEVT_VERSION_LIST_REFRESHED);
+	refreshHandler->AddPendingEvent(event);
+}
+
+void MCVersionList::ApplyRefresh()
+{
+	ListData *data;
+	{
+		wxMutexLocker lock(refreshLock);
+		// Release() asks again once the last holder is gone.
+		if (!refreshed || holds > 0)
+			return;
+		data = refreshed;
+		refreshed = nullptr;
+		SetLists(*data, true, data->hasMCRW);
+	}
+	// Nothing holds the old lists, so they can go.
+	delete data;
+	SaveCache();
+}
+
+void MCVersionList::Hold()
+{
+	wxMutexLocker lock(refreshLock);
+	holds++;
+}
+
+void MCVersionList::Release()
+{
+	wxMutexLocker lock(refreshLock);
+	holds--;
+	if (holds == 0 && refreshed)
+	{
+		wxCommandEvent event(wxEVT_VERSION_LIST_REFRESHED);
+		refreshHandler->AddPendingEvent(event);
+	}
+}
+
 std::size_t MCVersionList::size() const
 {
 	return versions.size() + mcrw_versions.size();
@@ -16,13 +16,40 @@
 
 #pragma once
 #include <wx/string.h>
+#include <wx/thread.h>
+#include <wx/hashmap.h>
+#include <wx/event.h>
 #include <vector>
+#include <map>
 #include <stdint.h>
 #include "mcversion.h"
+#include "utils/httputils.h"
 
+// descriptor -> index into the list
+WX_DECLARE_STRING_HASH_MAP(std::size_t, MCVersionIndex);
+
+// The Minecraft and MCRewind version lists.
+// What was last downloaded is kept in a cache file, so the lists can be shown right away.
+// When they come from the cache, they are checked for changes in the background and
+// the new lists are swapped in on the main thread, once nothing holds the list.
 class MCVersionList
 {
 public:
+	// While one of these exists, refreshed lists aren't swapped in, so pointers and
+	// indexes into the list stay valid. Can be used on any thread.
+	class Holder
+	{
+	public:
+		Holder()
+		{
+			MCVersionList::Instance().Hold();
+		}
+		~Holder()
+		{
+			MCVersionList::Instance().Release();
+		}
+	};
+
 	static MCVersionList& Instance()
 	{
 		if (pInstance == 0)
@@ -30,22 +57,22 @@ public:
 		return *pInstance;
 	};
 	
+	// Download the lists right away.
 	bool LoadMCRW();
 	bool LoadMojang();
+
+	// Downloads both lists again, ignoring the cache. The new lists are swapped in on 
+	// the main thread later, FindVersion sees them right away.
+	bool Reload();
 	
 	bool LoadIfNeeded();
+	// These read the cache first, so they only return true if there is nothing to show.
 	bool NeedsLoad()
 	{
 		return NeedsMojangLoad() || NeedsMCRWLoad();
 	}
-	bool NeedsMojangLoad()
-	{
-		return versions.size() == 0;
-	}
-	bool NeedsMCRWLoad()
-	{
-		return includesMCRW && mcrw_versions.size() == 0;
-	}
+	bool NeedsMojangLoad();
+	bool NeedsMCRWLoad();
 	void SetNeedsMCRW()
 	{
 		includesMCRW = true;
@@ -56,15 +83,72 @@ public:
 	
 	MCVersion * GetVersion ( wxString descriptor );
 	MCVersion * GetCurrentStable ();
+	// Copies the version with the given descriptor, for threads that don't hold the list.
+	// Lists that were reloaded but aren't swapped in yet are searched first.
+	bool FindVersion(const wxString &descriptor, MCVersion &version);
 	int GetStableVersionIndex()
 	{
 		return stableVersionIndex;
 	};
 private:
+	typedef std::map<wxString, HttpCacheInfo> FeedMap;
+
+	// Everything that's built from the feeds.
+	struct ListData
+	{
+		ListData() : stableVersionIndex(-1), hasMCRW(false) {}
+
+		std::vector <MCVersion> versions;
+		std::vector <MCVersion> mcrw_versions;
+		int stableVersionIndex;
+		bool hasMCRW;
+		FeedMap feeds;
+	};
+
+	// Checks the feeds in data.feeds for changes and rebuilds the lists if there were any.
+	// Returns false if nothing changed or if anything couldn't be downloaded.
+	static bool RefreshLists(ListData &data, bool withMCRW);
+
+	// Swaps the lists in data in, and the old ones out into data.
+	// Call with refreshLock locked. Off the main thread, only lists that are still 
+	// empty may be replaced.
+	void SetLists(ListData &data, bool setMojang, bool setMCRW);
+	void RebuildIndex();
+	static bool FindIn(const std::vector<MCVersion> &list, const wxString &descriptor, 
+		MCVersion &version);
+
+	void LoadCacheIfNeeded();
+	void SaveCache();
+
+	void Hold();
+	void Release();
+
+	void StartRefresh();
+	// Hands new lists to the main thread. Takes ownership of data.
+	void QueueRefresh(ListData *data);
+	// Main thread only.
+	void ApplyRefresh();
+	friend class VersionListRefreshThread;
+	friend class VersionListRefreshHandler;
+
 	std::vector <MCVersion> versions;
 	std::vector <MCVersion> mcrw_versions;
+	MCVersionIndex index;
 	int stableVersionIndex;
 	bool includesMCRW;
+
+	// ETags and such of the feeds the lists came from.
+	FeedMap feeds;
+	bool cacheLoaded;
+	bool refreshStarted;
+
+	// Guards the lists while they're replaced, and everything below.
+	wxMutex refreshLock;
+	// Waiting to be swapped in by the main thread.
+	ListData *refreshed;
+	int holds;
+	wxEvtHandler *refreshHandler;
+
 	static MCVersionList * pInstance;
 	MCVersionList();
 };
@@ -40,7 +40,44 @@ Mod::Mod(const wxFileName& file, ModType type)
 {
 	modFile = file;
 	modName = modFile.GetName();
+	DetectType(type);
+	ReadInfo();
+}
+
+Mod::Mod(const wxFileName &file, ModInfoCache *cache)
+{
+	modFile = file;
+	modName = modFile.GetName();
+	DetectType(MOD_UNKNOWN);
+
+	// Folder mods are cheap to read and their mtime says nothing about mcmod.info.
+	if (modType != MOD_ZIPFILE || cache == nullptr)
+	{
+		ReadInfo();
+		return;
+	}
 
+	ModInfoCache::Entry entry;
+	if (cache->Lookup(modFile.GetFullPath(), entry))
+	{
+		modID = entry.modID;
+		if (!entry.name.IsEmpty())
+			modName = entry.name;
+		modVersion = entry.version;
+		mcVersion = entry.mcVersion;
+		return;
+	}
+
+	ReadInfo();
+	entry.modID = modID;
+	entry.name = modName;
+	entry.version = modVersion;
+	entry.mcVersion = mcVersion;
+	cache->Store(modFile.GetFullPath(), entry);
+}
+
+void Mod::DetectType(ModType type)
+{
 	if (type == MOD_UNKNOWN)
 	{
 		if (wxDirExists(modFile.GetFullPath()))
@@ -56,7 +93,10 @@ Mod::Mod(const wxFileName& file, ModType type)
 	}
 
 	modType = type;
+}
 
+void Mod::ReadInfo()
+{
 #ifdef READ_MODINFO
 	switch (modType)
 	{
@@ -156,6 +196,7 @@ void Mod::ReadModInfoData(wxString info)
 		modID = wxStr(pt.get<std::string>("modid"));
 		modName = wxStr(pt.get<std::string>("name"));
 		modVersion = wxStr(pt.get<std::string>("version"));
+		mcVersion = wxStr(pt.get<std::string>("mcversion", ""));
 	}
 	catch (json_parser_error e)
 	{
@@ -213,6 +254,7 @@ void Mod::ReadForgeInfoData ( wxString infoFileData )
 Mod::Mod(const Mod& mod)
 {
 	modFile = mod.GetFileName();
+	modID = mod.modID;
 	modName = mod.GetName();
 	modVersion = mod.GetModVersion();
 	mcVersion = mod.GetMCVersion();
@@ -18,6 +18,8 @@
 #include <wx/wx.h>
 #include <wx/filename.h>
 
+#include "modinfocache.h"
+
 class Mod
 {
 public:
@@ -37,6 +39,9 @@ public:
 	};
 
 	Mod(const wxFileName &file, ModType type = MOD_UNKNOWN);
+
+	// Like the above, but zip mods are only opened if the cache doesn't know them yet.
+	Mod(const wxFileName &file, ModInfoCache *cache);
 	Mod(const Mod &mod);
 	
 	wxFileName GetFileName() const;
@@ -55,6 +60,8 @@ public:
 	bool operator ==(const Mod &other) const;
 	
 protected:
+	void DetectType(ModType type);
+	void ReadInfo();
 
 	void ReadModInfoData(wxString info);
 	void ReadForgeInfoData ( wxString infoFileData );
@@ -0,0 +1,189 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+
+#include "modinfocache.h"
+
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/wfstream.h>
+
+#include "utils/datautils.h"
+
+const wxString cacheHeader = "MultiMC mod info cache 2";
+
+static wxString FormatS64(int64_t value)
+{
+	return wxString::Format("%" wxLongLongFmtSpec "d", (wxLongLong_t)value);
+}
+
+static bool ParseS64(const wxString &str, int64_t &out)
+{
+	wxLongLong_t value;
+	if (!str.ToLongLong(&value))
+		return false;
+	out = value;
+	return true;
+}
+
+ModInfoCache::ModInfoCache(const wxString &cacheFile, const wxString &rootDir)
+	: m_cacheFile(cacheFile), m_loaded(false), m_dirty(false)
+{
+	wxFileName root = wxFileName::DirName(rootDir);
+	root.MakeAbsolute();
+	m_rootDir = root.GetFullPath();
+}
+
+wxString ModInfoCache::GetKey(const wxFileName &file) const
+{
+	// Relative to the instance, so the entries survive copying or moving it.
+	// Files outside of it keep their absolute path.
+	wxFileName absPath(file);
+	absPath.MakeAbsolute();
+	wxFileName relPath(absPath);
+	if (!relPath.MakeRelativeTo(m_rootDir))
+		return absPath.GetFullPath();
+	wxString key = relPath.GetFullPath(wxPATH_UNIX);
+	if (key.StartsWith(".."))
+		return absPath.GetFullPath();
+	return key;
+}
+
+wxString ModInfoCache::GetPath(const wxString &key) const
+{
+	if (wxFileName(key).IsAbsolute())
+		return key;
+	wxFileName path(key, wxPATH_UNIX);
+	path.MakeAbsolute(m_rootDir);
+	return path.GetFullPath();
+}
+
+void ModInfoCache::LoadIfNeeded()
+{
+	if (m_loaded)
+		return;
+	m_loaded = true;
+
+	if (!wxFileExists(m_cacheFile))
+		return;
+
+	wxFFileInputStream inStream(m_cacheFile);
+	if (!inStream.IsOk())
+		return;
+	wxArrayString lines = ReadAllLines(inStream);
+	if (lines.IsEmpty() || lines[0] != cacheHeader)
+		return;
+
+	// mod <size> <mtime> <path relative to the instance> <modid> <name> <version> <mcversion>
+	for (size_t i = 1; i < lines.size(); i++)
+	{
+		wxArrayString fields = wxSplit(lines[i], '\t', '\0');
+		if (fields.size() != 8 || fields[0] != "mod")
+			continue;
+
+		Entry entry;
+		if (!ParseS64(fields[1], entry.size) || !ParseS64(fields[2], entry.mtime))
+			continue;
+		entry.modID = UnescapeField(fields[4]);
+		entry.name = UnescapeField(fields[5]);
+		entry.version = UnescapeField(fields[6]);
+		entry.mcVersion = UnescapeField(fields[7]);
+		m_entries[UnescapeField(fields[3])] = entry;
+	}
+}
+
+// Entries are shared between threads, so they get their own strings.
+static ModInfoCache::Entry CloneEntry(const ModInfoCache::Entry &entry)
+{
+	ModInfoCache::Entry copy;
+	copy.size = entry.size;
+	copy.mtime = entry.mtime;
+	copy.modID = entry.modID.Clone();
+	copy.name = entry.name.Clone();
+	copy.version = entry.version.Clone();
+	copy.mcVersion = entry.mcVersion.Clone();
+	return copy;
+}
+
+bool ModInfoCache::Lookup(const wxString &file, Entry &entry)
+{
+	wxFileName fileName(file);
+	fileName.MakeAbsolute();
+	entry.size = -1;
+	entry.mtime = -1;
+	if (!fileName.FileExists())
+		return false;
+	entry.size = fileName.GetSize().GetValue();
+	entry.mtime = wxFileModificationTime(fileName.GetFullPath());
+
+	wxMutexLocker lock(m_lock);
+	LoadIfNeeded();
+	auto found = m_entries.find(GetKey(fileName));
+	if (found == m_entries.end() || 
+		found->second.size != entry.size || found->second.mtime != entry.mtime)
+	{
+		return false;
+	}
+	entry = CloneEntry(found->second);
+	return true;
+}
+
+void ModInfoCache::Store(const wxString &file, const Entry &entry)
+{
+	if (entry.size < 0 || entry.mtime < 0)
+		return;
+
+	wxFileName fileName(file);
+	fileName.MakeAbsolute();
+
+	wxMutexLocker lock(m_lock);
+	LoadIfNeeded();
+	m_entries[GetKey(fileName)] = CloneEntry(entry);
+	m_dirty = true;
+}
+
+bool ModInfoCache::Save()
+{
+	wxMutexLocker lock(m_lock);
+	if (!m_dirty)
+		return true;
+
+	// Drop mods that were deleted, so the cache doesn't grow forever.
+	wxString text;
+	text << cacheHeader << "\n";
+	for (auto iter = m_entries.begin(); iter != m_entries.end(); )
+	{
+		if (!wxFileExists(GetPath(iter->first)))
+		{
+			iter = m_entries.erase(iter);
+			continue;
+		}
+
+		const Entry &entry = iter->second;
+		text << "mod\t" << FormatS64(entry.size) << "\t" << FormatS64(entry.mtime) << "\t"
+			<< EscapeField(iter->first) << "\t" << EscapeField(entry.modID) << "\t"
+			<< EscapeField(entry.name) << "\t" << EscapeField(entry.version) << "\t"
+			<< EscapeField(entry.mcVersion) << "\n";
+		++iter;
+	}
+
+	wxTempFileOutputStream outStream(m_cacheFile);
+	WriteAllText(outStream, text);
+	if (!outStream.Commit())
+		return false;
+	m_dirty = false;
+	return true;
+}
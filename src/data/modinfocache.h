@@ -0,0 +1,73 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+
+#pragma once
+#include <map>
+#include <stdint.h>
+
+#include <wx/string.h>
+#include <wx/thread.h>
+#include <wx/filename.h>
+
+// Remembers what was read from each mod's mcmod.info, so mods that didn't change
+// don't have to be opened again. Entries are keyed by the path relative to the 
+// instance and checked against the file's size and modification time. 
+// Safe to use from several threads.
+class ModInfoCache
+{
+public:
+	struct Entry
+	{
+		Entry() : size(-1), mtime(-1) {}
+
+		int64_t size;
+		int64_t mtime;
+
+		wxString modID;
+		wxString name;
+		wxString version;
+		wxString mcVersion;
+	};
+
+	// The cache file is read on first use. Paths are stored relative to rootDir.
+	ModInfoCache(const wxString &cacheFile, const wxString &rootDir);
+
+	// Stats the file and fills in entry.size and entry.mtime.
+	// Returns true if the cache has info for the file at that size and mtime, 
+	// which is then also copied into entry.
+	bool Lookup(const wxString &file, Entry &entry);
+
+	// Remembers the info for the given file. entry.size and entry.mtime should come from Lookup.
+	void Store(const wxString &file, const Entry &entry);
+
+	// Writes the cache file if anything changed since it was read.
+	bool Save();
+
+protected:
+	void LoadIfNeeded();
+
+	// Key for a file, relative to the root if it's inside it, and back.
+	wxString GetKey(const wxFileName &file) const;
+	wxString GetPath(const wxString &key) const;
+
+	wxString m_cacheFile;
+	wxString m_rootDir;
+	bool m_loaded;
+	bool m_dirty;
+	std::map<wxString, Entry> m_entries;
+	wxMutex m_lock;
+};
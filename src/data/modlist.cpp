@@ -23,14 +23,18 @@
 
 #include <algorithm>
 #include <functional>
+#include <memory>
 
 #include "utils/apputils.h"
 #include "utils/osutils.h"
 #include "utils/datautils.h"
+#include "utils/fsutils.h"
+#include "utils/parallel.h"
 #include "instance.h"
+#include "trash.h"
 
 ModList::ModList(const wxString &dir)
-	: modsFolder(dir)
+	: modsFolder(dir), m_infoCache(nullptr)
 {
 	
 }
@@ -55,6 +59,9 @@ bool ModList::UpdateModList(bool quickLoad)
 	if (LoadModListFromDir(wxEmptyString, quickLoad))
 		listChanged = true;
 
+	if (m_infoCache)
+		m_infoCache->Save();
+
 	return listChanged;
 }
 
@@ -74,6 +81,8 @@ bool ModList::LoadModListFromDir(const wxString& loadFrom, bool quickLoad)
 		return false;
 	}
 
+	wxArrayString newMods;
+	wxArrayString subDirs;
 	wxString currentFile;
 	if (modDir.GetFirst(&currentFile))
 	{
@@ -85,22 +94,44 @@ bool ModList::LoadModListFromDir(const wxString& loadFrom, bool quickLoad)
 			{
 				if (quickLoad || FindByFilename(modFile.GetFullPath()) == nullptr)
 				{
-					Mod mod(modFile.GetFullPath());
-					push_back(mod);
-					listChanged = true;
+					newMods.Add(modFile.GetFullPath());
 				}
 			}
 			else if (wxDirExists(modFile.GetFullPath()))
 			{
-				if (LoadModListFromDir(modFile.GetFullPath()))
-					listChanged = true;
+				subDirs.Add(modFile.GetFullPath());
 			}
 		} while (modDir.GetNext(&currentFile));
 	}
 
+	if (!newMods.IsEmpty())
+	{
+		AddMods(newMods);
+		listChanged = true;
+	}
+
+	for (size_t i = 0; i < subDirs.size(); i++)
+	{
+		if (LoadModListFromDir(subDirs[i]))
+			listChanged = true;
+	}
+
 	return listChanged;
 }
 
+void ModList::AddMods(const wxArrayString &files)
+{
+	// Opening zip mods is slow, so cache misses are read in parallel.
+	std::vector<std::unique_ptr<Mod>> mods(files.size());
+	ParallelFor(files.size(), GetIOThreadCount(), [&] (size_t i)
+	{
+		mods[i].reset(new Mod(files[i], m_infoCache));
+	});
+
+	for (size_t i = 0; i < mods.size(); i++)
+		push_back(*mods[i]);
+}
+
 Mod *ModList::FindByFilename(const wxString& filename)
 {
 	// Search the list for a mod with the given filename.
@@ -165,7 +196,7 @@ void ModList::LoadFromFile(const wxString& file)
 
 		if (FindByFilename(modFile.GetFullPath()) == nullptr)
 		{
-			push_back(Mod(modFile));
+			push_back(Mod(modFile, m_infoCache));
 		}
 	}
 }
@@ -193,7 +224,7 @@ bool ModList::InsertMod(size_t index, const wxString &filename, const wxString&
 
 	if (!source.SameAs(dest))
 	{
-		wxCopyFile(source.GetFullPath(), dest.GetFullPath());
+		fsutils::LinkFile(source.GetFullPath(), dest.GetFullPath(), false);
 	}
 
 	dest.MakeRelativeTo();
@@ -206,9 +237,9 @@ bool ModList::InsertMod(size_t index, const wxString &filename, const wxString&
 	}
 
 	if (index >= size())
-		push_back(Mod(dest));
+		push_back(Mod(dest, m_infoCache));
 	else
-		insert(begin() + index, Mod(dest));
+		insert(begin() + index, Mod(dest, m_infoCache));
 
 	if (!saveToFile.IsEmpty())
 		SaveToFile(saveToFile);
@@ -221,7 +252,7 @@ bool ModList::DeleteMod(size_t index, const wxString& saveToFile)
 	Mod *mod = &at(index);
 	if(mod->GetModType() == Mod::MOD_FOLDER)
 	{
-		if(wxFileName::Rmdir(mod->GetFileName().GetFullPath(),wxPATH_RMDIR_RECURSIVE))
+		if(Trash::Instance().Delete(mod->GetFileName().GetFullPath()))
 		{
 			erase(begin() + index);
 			
@@ -235,7 +266,7 @@ bool ModList::DeleteMod(size_t index, const wxString& saveToFile)
 			wxLogError(_("Failed to delete mod."));
 		}
 	}
-	else if (wxRemoveFile(mod->GetFileName().GetFullPath()))
+	else if (Trash::Instance().Delete(mod->GetFileName().GetFullPath()))
 	{
 		erase(begin() + index);
 		
@@ -261,6 +292,11 @@ void ModList::SetDir(const wxString& dir)
 	modsFolder = dir;
 }
 
+void ModList::SetInfoCache(ModInfoCache *cache)
+{
+	m_infoCache = cache;
+}
+
 wxString ModList::ToString(int indentation)
 {
 	wxString indent;
@@ -338,6 +374,7 @@ bool FolderModList::LoadModListFromDir(const wxString& loadFrom, bool quickLoad)
 		return false;
 	}
 
+	wxArrayString newMods;
 	wxString currentFile;
 	if (modDir.GetFirst(&currentFile))
 	{
@@ -349,14 +386,18 @@ bool FolderModList::LoadModListFromDir(const wxString& loadFrom, bool quickLoad)
 			{
 				if (quickLoad || FindByFilename(modFile.GetFullPath()) == nullptr)
 				{
-					Mod mod(modFile.GetFullPath());
-					push_back(mod);
-					listChanged = true;
+					newMods.Add(modFile.GetFullPath());
 				}
 			}
 		} while (modDir.GetNext(&currentFile));
 	}
 
+	if (!newMods.IsEmpty())
+	{
+		AddMods(newMods);
+		listChanged = true;
+	}
+
 	return listChanged;
 }
 
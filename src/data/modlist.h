@@ -50,6 +50,9 @@ public:
 	// Sets this mod list's directory
 	void SetDir(const wxString& dir);
 
+	// Sets the cache used to skip reading mods that didn't change. May be nullptr.
+	void SetInfoCache(ModInfoCache *cache);
+
 	// Saves the mod list to a file.
 	virtual void SaveToFile(const wxString& file);
 
@@ -73,7 +76,11 @@ protected:
 	// Returns true if the list changed.
 	virtual bool LoadModListFromDir(const wxString& loadFrom = wxEmptyString, bool quickLoad = false);
 
+	// Reads the given mods on worker threads and appends them in order.
+	void AddMods(const wxArrayString &files);
+
 	wxString modsFolder;
+	ModInfoCache *m_infoCache;
 };
 
 class JarModList : public ModList
@@ -16,8 +16,8 @@
 #include "multimc_pragma.h"
 #include "stdinstance.h"
 
-StdInstance::StdInstance(wxString rootDir)
-	: Instance(rootDir)
+StdInstance::StdInstance(wxString rootDir, const InstanceMetadata *cached)
+	: Instance(rootDir, cached)
 {
 
 }
@@ -20,7 +20,7 @@
 class StdInstance : public Instance
 {
 public:
-	StdInstance(wxString rootDir);
+	StdInstance(wxString rootDir, const InstanceMetadata *cached = nullptr);
 
 	virtual Type GetType() const;
 };
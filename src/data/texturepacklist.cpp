@@ -22,6 +22,7 @@
 #include <wx/log.h>
 
 #include "utils/apputils.h"
+#include "trash.h"
 
 TexturePackList::TexturePackList(const wxString& dir)
 	: m_tpackDir(dir)
@@ -86,7 +87,7 @@ bool TexturePackList::LoadTexturePackListFromDir(const wxString& loadFrom)
 bool TexturePackList::DeletePack(size_t index)
 {
 	TexturePack *pack = &at(index);
-	if (wxRemoveFile(pack->GetFileName()))
+	if (Trash::Instance().Delete(pack->GetFileName()))
 	{
 		erase(begin() + index);
 		return true;
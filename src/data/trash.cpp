@@ -0,0 +1,264 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "multimc_pragma.h"
+#include "trash.h"
+
+#include <wx/dir.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/time.h>
+
+#include <vector>
+
+#include "appsettings.h"
+#include "utils/apputils.h"
+#include "utils/fsutils.h"
+
+Trash* Trash::pInstance = 0;
+
+class TrashPurgeThread : public wxThread
+{
+public:
+	TrashPurgeThread(Trash *trash)
+		: wxThread(wxTHREAD_JOINABLE), m_trash(trash) {}
+
+protected:
+	virtual ExitCode Entry()
+	{
+		m_trash->PurgeLoop();
+		return 0;
+	}
+
+	Trash *m_trash;
+};
+
+Trash::Trash()
+	: m_wake(m_lock)
+{
+	m_nextID = 0;
+	m_stopping = false;
+	m_thread = nullptr;
+}
+
+wxString Trash::GetStagingDir() const
+{
+	// Reads the settings, so only call this on the main thread.
+	// Instances aren't loaded from hidden folders or folders without an instance.cfg.
+	return Path::Combine(settings->GetInstDir(), ".trash");
+}
+
+bool Trash::Delete(const wxString &path, wxString *id)
+{
+	wxString target = path;
+	while (target.Len() > 1 && wxFileName::IsPathSeparator(target.Last()))
+		target.RemoveLast();
+
+	if (id)
+		id->Clear();
+	if (!wxFileExists(target) && !wxDirExists(target))
+		return false;
+
+	// The instance folder may have been changed in the settings since the last time.
+	wxString stagingDir = GetStagingDir();
+	if (stagingDir != m_stagingDir)
+	{
+		m_stagingDir = stagingDir;
+		wxMutexLocker lock(m_lock);
+		m_leftoverDirs.push_back(stagingDir);
+		m_wake.Broadcast();
+	}
+
+	// The entry is known before its folder exists, so it's never taken for a leftover.
+	wxString entryID;
+	wxString entryDir;
+	{
+		wxMutexLocker lock(m_lock);
+		entryID = wxGetUTCTimeMillis().ToString() + wxString::Format("-%i", m_nextID++);
+		entryDir = Path::Combine(stagingDir, entryID);
+
+		Entry entry;
+		entry.dir = entryDir;
+		entry.origin = target;
+		entry.time = wxGetLocalTimeMillis();
+		m_entries[entryID] = entry;
+	}
+
+	if (fsutils::CreateAllDirs(wxFileName::DirName(entryDir)) &&
+		wxRename(target, Path::Combine(entryDir, "data")) == 0)
+	{
+		if (id)
+			*id = entryID;
+		return true;
+	}
+
+	{
+		wxMutexLocker lock(m_lock);
+		m_entries.erase(entryID);
+	}
+
+	// A rename can't move it to another volume.
+	wxRmdir(entryDir);
+	return fsutils::RecursiveDelete(target);
+}
+
+bool Trash::Restore(const wxString &id, wxString *restoredPath)
+{
+	wxMutexLocker lock(m_lock);
+	auto iter = m_entries.find(id);
+	if (iter == m_entries.end())
+		return false;
+
+	const Entry &entry = iter->second;
+	if (wxFileExists(entry.origin) || wxDirExists(entry.origin))
+		return false;
+	if (wxRename(Path::Combine(entry.dir, "data"), entry.origin) != 0)
+		return false;
+
+	wxRmdir(entry.dir);
+	if (restoredPath)
+		*restoredPath = entry.origin;
+	m_entries.erase(iter);
+	return true;
+}
+
+bool Trash::Contains(const wxString &id)
+{
+	wxMutexLocker lock(m_lock);
+	return m_entries.find(id) != m_entries.end();
+}
+
+void Trash::Start()
+{
+	if (m_thread)
+		return;
+
+	// Resolved here, the purge thread must not read the settings.
+	m_stagingDir = GetStagingDir();
+	{
+		wxMutexLocker lock(m_lock);
+		m_leftoverDirs.push_back(m_stagingDir);
+	}
+
+	m_thread = new TrashPurgeThread(this);
+	if (m_thread->Create() != wxTHREAD_NO_ERROR)
+	{
+		delete m_thread;
+		m_thread = nullptr;
+		return;
+	}
+	m_thread->SetPriority(WXTHREAD_MIN_PRIORITY);
+	m_thread->Run();
+}
+
+void Trash::Shutdown()
+{
+	if (!m_thread)
+		return;
+
+	{
+		wxMutexLocker lock(m_lock);
+		m_stopping = true;
+		m_wake.Broadcast();
+	}
+	m_thread->Wait();
+	delete m_thread;
+	m_thread = nullptr;
+}
+
+bool Trash::IsStopping()
+{
+	wxMutexLocker lock(m_lock);
+	return m_stopping;
+}
+
+void Trash::PurgeLoop()
+{
+	while (true)
+	{
+		std::vector<wxString> purge;
+		{
+			wxMutexLocker lock(m_lock);
+			if (m_stopping)
+				return;
+
+			// Nothing from an earlier session can be restored.
+			for (size_t i = 0; i < m_leftoverDirs.size(); i++)
+			{
+				wxDir dir(m_leftoverDirs[i]);
+				wxString name;
+				if (dir.IsOpened() && dir.GetFirst(&name, wxEmptyString, wxDIR_DIRS | wxDIR_HIDDEN))
+				{
+					do
+					{
+						if (m_entries.find(name) == m_entries.end())
+							purge.push_back(Path::Combine(m_leftoverDirs[i], name));
+					} while (dir.GetNext(&name));
+				}
+			}
+			m_leftoverDirs.clear();
+
+			wxLongLong now = wxGetLocalTimeMillis();
+			for (auto iter = m_entries.begin(); iter != m_entries.end();)
+			{
+				if (now - iter->second.time >= keepTime)
+				{
+					purge.push_back(iter->second.dir);
+					m_entries.erase(iter++);
+				}
+				else
+				{
+					++iter;
+				}
+			}
+
+			if (purge.empty())
+			{
+				m_wake.WaitTimeout(60 * 1000);
+				continue;
+			}
+		}
+
+		for (size_t i = 0; i < purge.size() && !IsStopping(); i++)
+			PurgePath(purge[i]);
+	}
+}
+
+bool Trash::PurgePath(const wxString &path)
+{
+	// Checked for every file, so shutting down doesn't wait for a big folder.
+	if (IsStopping())
+		return false;
+
+	if (wxFileExists(path))
+		return wxRemoveFile(path);
+
+	if (wxDirExists(path))
+	{
+		wxDir dir(path);
+		wxString subpath;
+		if (dir.GetFirst(&subpath))
+		{
+			do
+			{
+				if (!PurgePath(Path::Combine(path, subpath)))
+					return false;
+			} while (dir.GetNext(&subpath));
+		}
+		return wxRmdir(path);
+	}
+	return true;
+}
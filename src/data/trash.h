@@ -0,0 +1,96 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#pragma once
+#include <map>
+#include <vector>
+
+#include <wx/string.h>
+#include <wx/thread.h>
+#include <wx/longlong.h>
+
+class TrashPurgeThread;
+
+// Deleted instances, mods and texture packs are renamed into a staging folder
+// next to the instances, which is instant, and a low priority worker thread
+// deletes them for real once they are old enough. Until then they can be
+// restored. Whatever is left over from earlier sessions is purged on startup.
+class Trash
+{
+public:
+	static Trash& Instance()
+	{
+		if (pInstance == 0)
+			pInstance = new Trash();
+		return *pInstance;
+	};
+
+	// How long deleted things can be restored, in milliseconds.
+	static const int keepTime = 15 * 60 * 1000;
+
+	// Moves the file or folder at path into the trash. If it can't be moved
+	// there (it's on another volume), it is deleted right away instead and id
+	// is left empty. Main thread only.
+	bool Delete(const wxString &path, wxString *id = nullptr);
+
+	// Moves a trashed file or folder back to where it came from.
+	// Fails if it has been purged or something else is in its place now.
+	bool Restore(const wxString &id, wxString *restoredPath = nullptr);
+
+	// True until the trashed file or folder is restored or purged.
+	bool Contains(const wxString &id);
+
+	// Starts the purge worker. Call once settings are loaded.
+	void Start();
+
+	// Stops the purge worker. Anything not purged yet is purged on the next start.
+	void Shutdown();
+
+protected:
+	friend class TrashPurgeThread;
+
+	Trash();
+
+	// The staging folder for the current settings. Main thread only.
+	wxString GetStagingDir() const;
+
+	// Runs on the worker thread.
+	void PurgeLoop();
+	bool PurgePath(const wxString &path);
+	bool IsStopping();
+
+	struct Entry
+	{
+		// The entry's folder in the staging area. The trashed file is in it as "data".
+		wxString dir;
+		wxString origin;
+		wxLongLong time;
+	};
+
+	// ID -> entry
+	std::map<wxString, Entry> m_entries;
+	int m_nextID;
+	bool m_stopping;
+	// Where Delete puts things, only used on the main thread.
+	wxString m_stagingDir;
+	// Staging folders the purge worker still has to clear of earlier sessions' leftovers
+	std::vector<wxString> m_leftoverDirs;
+	TrashPurgeThread *m_thread;
+	wxMutex m_lock;
+	wxCondition m_wake;
+
+	static Trash *pInstance;
+};
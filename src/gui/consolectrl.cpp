@@ -0,0 +1,180 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+
+#include "consolectrl.h"
+
+#include <wx/dcclient.h>
+#include <wx/clipbrd.h>
+#include <wx/settings.h>
+
+// Flush at most this often (in ms).
+const int flushInterval = 40;
+
+enum
+{
+	ID_FlushTimer = 1,
+};
+
+ConsoleCtrl::ConsoleCtrl(wxWindow *parent, wxWindowID id, size_t maxLines)
+	: wxVListBox(parent, id, wxDefaultPosition, wxDefaultSize, wxLB_MULTIPLE | wxBORDER_SUNKEN),
+	  m_first(0), m_count(0), m_maxLines(maxLines > 0 ? maxLines : 1), m_dropped(0), m_dirty(false),
+	  m_flushTimer(this, ID_FlushTimer)
+{
+	m_lineHeight = GetCharHeight() + 2;
+	m_flushTimer.Start(flushInterval);
+}
+
+void ConsoleCtrl::AppendLine(const wxString &line, int type)
+{
+	Line newLine;
+	newLine.text = line;
+	newLine.type = type;
+
+	if (m_lines.size() < m_maxLines)
+	{
+		m_lines.push_back(newLine);
+		m_count++;
+	}
+	else
+	{
+		// Full. Overwrite the oldest line.
+		m_lines[m_first] = newLine;
+		m_first = (m_first + 1) % m_maxLines;
+		m_dropped++;
+	}
+	m_dirty = true;
+}
+
+void ConsoleCtrl::SetTypeColour(int type, const wxColour &colour)
+{
+	m_colours[type] = colour;
+	RefreshAll();
+}
+
+const ConsoleCtrl::Line &ConsoleCtrl::GetLine(size_t n) const
+{
+	return m_lines[(m_first + n) % m_lines.size()];
+}
+
+void ConsoleCtrl::Flush()
+{
+	if (!m_dirty)
+		return;
+
+	size_t oldCount = GetItemCount();
+	bool atBottom = oldCount == 0 || GetVisibleRowsEnd() >= oldCount;
+	size_t oldTop = GetVisibleRowsBegin();
+
+	// Selections are by index and the indices moved.
+	if (m_dropped > 0 && GetSelectedCount() > 0)
+		DeselectAll();
+
+	SetItemCount(m_count);
+	if (atBottom)
+		ScrollToRow(m_count - 1);
+	else if (m_dropped > 0)
+		ScrollToRow(oldTop > m_dropped ? oldTop - m_dropped : 0);
+	RefreshAll();
+
+	m_dropped = 0;
+	m_dirty = false;
+}
+
+wxString ConsoleCtrl::GetText() const
+{
+	wxString text;
+	for (size_t i = 0; i < m_count; i++)
+	{
+		text << GetLine(i).text << "\n";
+	}
+	return text;
+}
+
+void ConsoleCtrl::OnDrawItem(wxDC &dc, const wxRect &rect, size_t n) const
+{
+	if (n >= m_count)
+		return;
+
+	const Line &line = GetLine(n);
+	wxColour colour = wxSystemSettings::GetColour(wxSYS_COLOUR_LISTBOXTEXT);
+	auto found = m_colours.find(line.type);
+	if (IsSelected(n))
+		colour = wxSystemSettings::GetColour(wxSYS_COLOUR_HIGHLIGHTTEXT);
+	else if (found != m_colours.end())
+		colour = found->second;
+
+	wxString text = line.text;
+	text.Replace("\t", "    ");
+
+	dc.SetFont(GetFont());
+	dc.SetTextForeground(colour);
+	dc.DrawText(text, rect.x + 2, rect.y + 1);
+}
+
+wxCoord ConsoleCtrl::OnMeasureItem(size_t n) const
+{
+	return m_lineHeight;
+}
+
+void ConsoleCtrl::OnFlushTimer(wxTimerEvent &event)
+{
+	Flush();
+}
+
+void ConsoleCtrl::OnKeyDown(wxKeyEvent &event)
+{
+	if (event.GetModifiers() == wxMOD_CMD && event.GetKeyCode() == 'C')
+	{
+		CopyToClipboard();
+	}
+	else if (event.GetModifiers() == wxMOD_CMD && event.GetKeyCode() == 'A')
+	{
+		SelectAll();
+	}
+	else
+	{
+		event.Skip();
+	}
+}
+
+void ConsoleCtrl::CopyToClipboard()
+{
+	wxString text;
+	if (GetSelectedCount() == 0)
+	{
+		text = GetText();
+	}
+	else
+	{
+		for (size_t i = 0; i < m_count; i++)
+		{
+			if (IsSelected(i))
+				text << GetLine(i).text << "\n";
+		}
+	}
+
+	if (wxTheClipboard->Open())
+	{
+		wxTheClipboard->SetData(new wxTextDataObject(text));
+		wxTheClipboard->Close();
+	}
+}
+
+BEGIN_EVENT_TABLE(ConsoleCtrl, wxVListBox)
+	EVT_TIMER(ID_FlushTimer, ConsoleCtrl::OnFlushTimer)
+	EVT_KEY_DOWN(ConsoleCtrl::OnKeyDown)
+END_EVENT_TABLE()
@@ -0,0 +1,80 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+
+#pragma once
+#include <vector>
+#include <map>
+
+#include <wx/vlbox.h>
+#include <wx/timer.h>
+
+// A read-only log view. Lines go into a ring buffer that keeps at most maxLines lines
+// and are shown by a fixed rate flush timer, so appending a line is cheap no matter 
+// how fast they come in. Only the visible lines are ever drawn.
+class ConsoleCtrl : public wxVListBox
+{
+public:
+	ConsoleCtrl(wxWindow *parent, wxWindowID id, size_t maxLines);
+
+	// Adds a line. It shows up on the next flush. Must be called on the GUI thread.
+	void AppendLine(const wxString &line, int type);
+
+	// Lines of the given type are drawn in this colour.
+	void SetTypeColour(int type, const wxColour &colour);
+
+	// Shows the lines added since the last flush right away.
+	void Flush();
+
+	// Returns every line in the scrollback, separated by '\n'.
+	wxString GetText() const;
+
+	size_t GetLineCount() const { return m_count; }
+
+protected:
+	struct Line
+	{
+		wxString text;
+		int type;
+	};
+
+	// Returns the nth oldest line in the scrollback.
+	const Line &GetLine(size_t n) const;
+
+	virtual void OnDrawItem(wxDC &dc, const wxRect &rect, size_t n) const;
+	virtual wxCoord OnMeasureItem(size_t n) const;
+
+	void OnFlushTimer(wxTimerEvent &event);
+	void OnKeyDown(wxKeyEvent &event);
+
+	// Copies the selected lines, or all of them if none are selected.
+	void CopyToClipboard();
+
+	std::vector<Line> m_lines;
+	size_t m_first;
+	size_t m_count;
+	size_t m_maxLines;
+
+	// lines that fell out of the scrollback since the last flush
+	size_t m_dropped;
+	bool m_dirty;
+
+	std::map<int, wxColour> m_colours;
+	wxCoord m_lineHeight;
+	wxTimer m_flushTimer;
+
+	DECLARE_EVENT_TABLE()
+};
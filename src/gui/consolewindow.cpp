@@ -23,7 +23,6 @@
 #include <wx/msgdlg.h>
 #include <wx/clipbrd.h>
 #include <wx/persist.h>
-#include <wx/regex.h>
 #include <wx/dir.h>
 
 #include <gui/mainwindow.h>
@@ -43,11 +42,16 @@
 #include "resources/consoleicon.h"
 #include "utils/apputils.h"
 #include "utils/osutils.h"
+#include "utils/datautils.h"
 #include "version.h"
 #include "buildtag.h"
 #include "mcprocess.h"
 #include "mainwindow.h"
 
+// How much of each log goes into a crash report.
+const int64_t reportConsoleLines = 5000;
+const size_t reportLogBytes = 512 * 1024;
+
 InstConsoleWindow::InstConsoleWindow(Instance *inst, MainWindow* mainWin, bool quitAppOnClose)
 	: wxFrame(NULL, -1, _("MultiMC Console"), wxDefaultPosition, wxSize(620, 250))
 {
@@ -58,16 +62,19 @@ InstConsoleWindow::InstConsoleWindow(Instance *inst, MainWindow* mainWin, bool q
 	m_running = nullptr;
 	m_inst = inst;
 	crashReportIsOpen = false;
+	m_processTimer.SetOwner(this, processinput);
 	
 	wxPanel *mainPanel = new wxPanel(this, -1);
 	wxBoxSizer *mainSizer = new wxBoxSizer(wxVERTICAL);
 	mainPanel->SetSizer(mainSizer);
 	
-	consoleTextCtrl = new wxTextCtrl(mainPanel, -1, wxEmptyString, 
-									 wxDefaultPosition, wxSize(200, 100), 
-									 wxTE_MULTILINE | wxTE_READONLY | wxTE_RICH);
-	mainSizer->Add(consoleTextCtrl, wxSizerFlags(1).Expand().Border(wxALL, 8));
-	consoleTextCtrl->SetBackgroundColour(*wxWHITE);
+	consoleCtrl = new ConsoleCtrl(mainPanel, -1, settings->GetConsoleMaxLines());
+	consoleCtrl->SetMinSize(wxSize(200, 100));
+	mainSizer->Add(consoleCtrl, wxSizerFlags(1).Expand().Border(wxALL, 8));
+	consoleCtrl->SetBackgroundColour(*wxWHITE);
+	consoleCtrl->SetTypeColour(MSGT_SYSTEM, settings->GetConsoleSysMsgColor());
+	consoleCtrl->SetTypeColour(MSGT_STDOUT, settings->GetConsoleStdoutColor());
+	consoleCtrl->SetTypeColour(MSGT_STDERR, settings->GetConsoleStderrColor());
 	
 
 	wxBoxSizer *btnBox = new wxBoxSizer(wxHORIZONTAL);
@@ -105,43 +112,57 @@ InstConsoleWindow::InstConsoleWindow(Instance *inst, MainWindow* mainWin, bool q
 	trayIcon = new ConsoleIcon(this);
 	SetState(STATE_OK);
 	CenterOnScreen();
+
+	m_launchLog.Open(m_inst->GetLaunchLogDir().GetFullPath());
 }
 
 InstConsoleWindow::~InstConsoleWindow() {}
 
 void InstConsoleWindow::AppendMessage(const wxString& msg, MessageType msgT)
+{
+	// Tell the user about known problems right below the line that shows them.
+	if (msgT != MSGT_SYSTEM)
+	{
+		std::vector<LogDiagnostic> diags = m_logAnalyzer.AnalyzeLine(msg);
+		if (!diags.empty())
+		{
+			AppendLine(msg, msgT);
+			for (size_t i = 0; i < diags.size(); i++)
+				AppendLine(diags[i].message, MSGT_SYSTEM);
+			return;
+		}
+	}
+	AppendLine(msg, msgT);
+}
+
+void InstConsoleWindow::AppendLine(const wxString& msg, MessageType msgT)
 {
 	// Prevent some red spam
 	if (msg.Contains("[STDOUT]") || msg.Contains("[ForgeModLoader]"))
 		msgT = MSGT_STDOUT;
 
-	switch (msgT)
+	// System messages can span several lines.
+	if (!msg.Contains("\n"))
 	{
-	case MSGT_SYSTEM:
-		consoleTextCtrl->SetDefaultStyle(
-			wxTextAttr(settings->GetConsoleSysMsgColor()));
-		break;
-
-	case MSGT_STDOUT:
-		consoleTextCtrl->SetDefaultStyle(
-			wxTextAttr(settings->GetConsoleStdoutColor()));
-		break;
-
-	case MSGT_STDERR:
-		consoleTextCtrl->SetDefaultStyle(
-			wxTextAttr(settings->GetConsoleStderrColor()));
-		break;
+		consoleCtrl->AppendLine(msg, msgT);
+		m_launchLog.AppendLine(MaskUserInfo(msg));
+		return;
 	}
 
-	(*consoleTextCtrl) << msg << "\n";
-
-	consoleTextCtrl->SetDefaultStyle(wxTextAttr(
-		wxSystemSettings::GetColour(wxSYS_COLOUR_LISTBOXTEXT)));
+	wxArrayString lines = wxSplit(msg, '\n', '\0');
+	for (size_t i = 0; i < lines.size(); i++)
+	{
+		// Skip the empty line after a trailing newline.
+		if (i == lines.size() - 1 && lines[i].IsEmpty())
+			break;
+		consoleCtrl->AppendLine(lines[i], msgT);
+		m_launchLog.AppendLine(MaskUserInfo(lines[i]));
+	}
 }
 
 void InstConsoleWindow::OnProcessExit( bool killed, int status )
 {
-	m_timerIdleWakeUp.Stop();
+	m_processTimer.Stop();
 	//FIXME: what are the exact semantics of this?
 	if(killed)
 		delete m_running;
@@ -152,7 +173,8 @@ void InstConsoleWindow::OnProcessExit( bool killed, int status )
 	
 	AppendMessage(wxString::Format(_("Minecraft exited with code %i."), status));
 
-	bool keepOpen = CheckCommonProblems(consoleTextCtrl->GetValue());
+	bool keepOpen = m_logAnalyzer.FoundProblems();
+	m_launchLog.Flush();
 
 	if (killed)
 	{
@@ -213,6 +235,7 @@ void InstConsoleWindow::OnWindowClosed(wxCloseEvent& event)
 		Show(false);
 		return;
 	}
+	m_launchLog.Close();
 	if (trayIcon->IsIconInstalled())
 		trayIcon->RemoveIcon();
 	delete trayIcon;
@@ -306,7 +329,13 @@ void InstConsoleWindow::OnKillMC ( wxCommandEvent& event )
 
 void InstConsoleWindow::OnProcessTimer(wxTimerEvent& WXUNUSED(event))
 {
-	wxWakeUpIdle();
+	m_launchLog.FlushIfOld();
+	if (m_running)
+	{
+		m_running->ProcessInput();
+		// may end up in OnProcessExit
+		m_running->CheckExit();
+	}
 }
 
 bool InstConsoleWindow::LinkProcess(MinecraftProcess *process)
@@ -314,26 +343,31 @@ bool InstConsoleWindow::LinkProcess(MinecraftProcess *process)
 	if (m_running==NULL)
 	{
 		m_running = process;
-		m_timerIdleWakeUp.Start(100);
+		m_logAnalyzer.Reset();
+		m_processTimer.Start(40);
 		SetCloseIsHide(true);
 		return true;
 	}
 	return false;
 }
 
-void InstConsoleWindow::OnIdle(wxIdleEvent& event)
-{
-	if (m_running==NULL)
-		return;
-	m_running->ProcessInput();
-}
-
 void InstConsoleWindow::SetUserInfo(wxString username, wxString sessID)
 {
 	m_username = username;
 	m_sessID = sessID;
 }
 
+wxString InstConsoleWindow::MaskUserInfo(const wxString &text) const
+{
+	// Mask the username and session ID if possible.
+	wxString masked = text;
+	if (!m_username.IsEmpty())
+		masked.Replace(m_username, "<username>");
+	if (!m_sessID.IsEmpty())
+		masked.Replace(m_sessID, "<session ID>");
+	return masked;
+}
+
 wxString InstConsoleWindow::GetCrashReport()
 {
 	wxString mlLogPath = Path::Combine(m_inst->GetMCDir(), "ModLoader.txt");
@@ -343,32 +377,29 @@ wxString InstConsoleWindow::GetCrashReport()
 
 	wxString consoleLog, modListStr, mlLog, fmlLog;
 
-	consoleLog = consoleTextCtrl->GetValue();
-
-	// Mask the username and session ID if possible.
-	if (!m_username.IsEmpty())
+	// Only the tail of the logs is interesting and they can be huge.
+	LaunchLogReader launchLog;
+	m_launchLog.Flush();
+	wxArrayString consoleLines;
+	if (m_launchLog.IsOpen() && launchLog.Open(m_launchLog.GetPath()) && 
+		launchLog.ReadTail(reportConsoleLines, consoleLines))
 	{
-		consoleLog.Replace(m_username, "<username>");
+		for (size_t i = 0; i < consoleLines.size(); i++)
+			consoleLog << consoleLines[i] << "\n";
 	}
-
-	if (!m_sessID.IsEmpty())
+	else
 	{
-		consoleLog.Replace(m_sessID, "<session ID>");
+		consoleLog = consoleCtrl->GetText();
 	}
 
+	// The launch log is masked already, the console isn't.
+	consoleLog = MaskUserInfo(consoleLog);
+
 	if (wxFileExists(mlLogPath))
-	{
-		wxFFileInputStream in(mlLogPath);
-		wxStringOutputStream out(&mlLog);
-		in.Read(out);
-	}
+		mlLog = ReadFileTail(mlLogPath, reportLogBytes);
 
 	if (wxFileExists(fmlLogPath))
-	{
-		wxFFileInputStream in(fmlLogPath);
-		wxStringOutputStream out(&fmlLog);
-		in.Read(out);
-	}
+		fmlLog = ReadFileTail(fmlLogPath, reportLogBytes);
 
 	{
 		wxString jModList = m_inst->GetModList()->ToString(1);
@@ -489,44 +520,6 @@ void InstConsoleWindow::OnGenReportClicked(wxCommandEvent& event)
 	crashReportIsOpen = false;
 }
 
-bool InstConsoleWindow::CheckCommonProblems(const wxString& output)
-{
-	wxRegEx idConflictRegex("([0-9]+) is already occupied by ([A-Za-z0-9.]+)@[A-Za-z0-9]+ when adding ([A-Za-z0-9.]+)@[A-Za-z0-9]+");
-
-	if (!idConflictRegex.IsValid())
-	{
-		wxLogError(_("ID conflict regex is invalid!"));
-		return false;
-	}
-
-	if (idConflictRegex.Matches(output))
-	{
-		// We have an ID conflict.
-		wxArrayString values;
-
-		for (unsigned i = 0; i < idConflictRegex.GetMatchCount(); i++)
-		{
-			values.Add(idConflictRegex.GetMatch(output, i));
-		}
-
-		if (values.Count() < 4)
-		{
-			// Something's wrong here...
-			wxLogError(_("Not enough values matched ID conflict regex!"));
-			return false;
-		}
-
-		// Alert the user.
-		AppendMessage(wxString::Format(
-			_("MultiMC found a block or item ID conflict. %s and %s are both using the same block ID (%s)."), 
-			values[2].c_str(), values[3].c_str(), values[1].c_str()), MSGT_SYSTEM);
-		return true;
-	}
-
-	// No common problems found.
-	return false;
-}
-
 void InstConsoleWindow::OnImgurClicked(wxCommandEvent& event)
 {
 	// Find the newest screenshot.
@@ -585,8 +578,7 @@ BEGIN_EVENT_TABLE(InstConsoleWindow, wxFrame)
 	EVT_BUTTON(wxID_CLOSE, InstConsoleWindow::OnCloseButton)
 	EVT_BUTTON(wxID_DELETE, InstConsoleWindow::OnKillMC)
 	EVT_CLOSE( InstConsoleWindow::OnWindowClosed )
-	EVT_IDLE(InstConsoleWindow::OnIdle)
-	EVT_TIMER(wakeupidle, InstConsoleWindow::OnProcessTimer)
+	EVT_TIMER(processinput, InstConsoleWindow::OnProcessTimer)
 	
 	EVT_BUTTON(ID_GENREPORT, InstConsoleWindow::OnGenReportClicked)
 END_EVENT_TABLE()
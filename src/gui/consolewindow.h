@@ -19,6 +19,9 @@
 #include <wx/taskbar.h>
 
 #include "instance.h"
+#include "consolectrl.h"
+#include "loganalyzer.h"
+#include "launchlog.h"
 
 class MinecraftProcess;
 class MainWindow;
@@ -27,7 +30,7 @@ class InstConsoleWindow : public wxFrame
 {
 	enum timertype
 	{
-		wakeupidle=5000
+		processinput=5000
 	};
 
 public:
@@ -37,6 +40,8 @@ public:
 	// Returns a "crash report" string that contains console logs, FML logs, 
 	// and ML logs as well as other useful info.
 	wxString GetCrashReport();
+	// Replaces the username and session ID, so they never end up in logs or reports.
+	wxString MaskUserInfo(const wxString &text) const;
 
 	// Tells the console the user's username and session ID. This allows 
 	// them to be "masked" in the user's crash report.
@@ -80,7 +85,7 @@ protected:
 	wxIconArray *consoleIcons;
 	
 	wxScrolledWindow *scrollWindow;
-	wxTextCtrl *consoleTextCtrl;
+	ConsoleCtrl *consoleCtrl;
 	
 	wxButton *closeButton;
 	wxButton *killButton;
@@ -88,12 +93,17 @@ protected:
 	MainWindow *m_mainWin;
 	Instance *m_inst;
 
-	// Scans the output for common problems and alerts the user.
-	bool CheckCommonProblems(const wxString& output);
+	// Scans the output for common problems as it comes in.
+	LogAnalyzer m_logAnalyzer;
+
+	// Everything shown in the console also goes into the instance's log archive.
+	LaunchLogWriter m_launchLog;
+
+	// Adds a line without analyzing it.
+	void AppendLine(const wxString &msg, MessageType msgT);
 	
-	// Called by timer to generate wakeupidle events
+	// Called by timer to move the process output to the console
 	void OnProcessTimer(wxTimerEvent& event);
-	void OnIdle(wxIdleEvent& event);
 
 	void OnWindowClosed(wxCloseEvent &event);
 
@@ -117,7 +127,7 @@ protected:
 	
 	bool closeIsHide;
 	bool crashReportIsOpen;
-	wxTimer m_timerIdleWakeUp;
+	wxTimer m_processTimer;
 	MinecraftProcess* m_running;
 	
 	DECLARE_EVENT_TABLE()
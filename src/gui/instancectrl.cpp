@@ -16,6 +16,7 @@
 #include "wx/image.h"
 #include "wx/dcbuffer.h"
 #include "wx/sstream.h"
+#include "wx/stopwatch.h"
 
 #include "instancemodel.h"
 
@@ -45,6 +46,7 @@ BEGIN_EVENT_TABLE(InstanceCtrl, wxScrolledCanvas)
 	EVT_SIZE(InstanceCtrl::OnSize)
 	EVT_SET_FOCUS(InstanceCtrl::OnSetFocus)
 	EVT_KILL_FOCUS(InstanceCtrl::OnKillFocus)
+	EVT_SYS_COLOUR_CHANGED(InstanceCtrl::OnSysColourChanged)
 
 	EVT_INST_DRAG(wxID_ANY, InstanceCtrl::OnInstDragged)
 END_EVENT_TABLE()
@@ -104,6 +106,8 @@ void InstanceCtrl::Init()
 	m_itemMargin = wxINST_DEFAULT_MARGIN;
 	m_selectedItem = -1;
 	m_focusItem = -1;
+	m_paintCount = 0;
+	m_paintTime = 0;
 }
 
 /// Call Freeze to prevent refresh
@@ -370,39 +374,37 @@ void InstanceCtrl::OnPaint(wxPaintEvent& WXUNUSED(event))
 	
 	if (m_freezeCount > 0)
 		return;
-		
-	// Paint the background
-	PaintBackground(dc);
 	
-	if (GetCount() == 0)
-		return;
+	wxStopWatch timer;
 	
-	wxRegion dirtyRegion = GetUpdateRegion();
-	bool isFocused = (FindFocus() == this);
+	// Only the dirty part of the buffer gets blitted, so only repaint that.
+	wxRect dirtyRect = GetUpdateRegion().GetBox();
+	CalcUnscrolledPosition(dirtyRect.x, dirtyRect.y, & dirtyRect.x, & dirtyRect.y);
+	
+	// Paint the background
+	PaintBackground(dc, dirtyRect);
 	
 	int i;
 	int count = GetCount();
-	int style = 0;
-	wxRect rect, untransformedRect;
+	wxRect untransformedRect;
 	for (i = 0; i < count; i++)
 	{
-		GetGroupRect(i, rect);
+		GetGroupRect(i, untransformedRect, false);
+		if (!dirtyRect.Intersects(untransformedRect))
+			continue;
 		
-		wxRegionContain c = dirtyRegion.Contains(rect);
-		if (c != wxOutRegion)
-		{
-			style = 0;
-			GetGroupRect(i, untransformedRect, false);
-			GroupVisual & gv = m_groups[i];
-			gv.Draw(dc, this, untransformedRect,
-			        m_selectedItem.groupIndex == i, m_selectedItem.itemIndex,
-			        m_focusItem.groupIndex == i, m_focusItem.itemIndex, 
-					i == highlightedGroup.groupIndex);
-		}
+		GroupVisual & gv = m_groups[i];
+		gv.Draw(dc, this, untransformedRect, dirtyRect,
+		        m_selectedItem.groupIndex == i, m_selectedItem.itemIndex,
+		        m_focusItem.groupIndex == i, m_focusItem.itemIndex, 
+				i == highlightedGroup.groupIndex);
 	}
+	
+	m_paintCount++;
+	m_paintTime += timer.TimeInMicro();
 }
 
-void GroupVisual::Draw ( wxDC& dc, InstanceCtrl* parent, wxRect limitingRect, bool hasSelection, int selectionIndex, bool hasFocus, int focusIndex, bool highlight )
+void GroupVisual::Draw ( wxDC& dc, InstanceCtrl* parent, wxRect limitingRect, const wxRect& dirtyRect, bool hasSelection, int selectionIndex, bool hasFocus, int focusIndex, bool highlight )
 {
 	int i;
 	int count = items.size();
@@ -410,7 +412,8 @@ void GroupVisual::Draw ( wxDC& dc, InstanceCtrl* parent, wxRect limitingRect, bo
 	wxRect rect;
 	
 	// Draw the header
-	if(!no_header)
+	wxRect headerRect(limitingRect.x, y_position, limitingRect.width, header_height);
+	if(!no_header && dirtyRect.Intersects(headerRect))
 	{
 		wxColour textColor = wxSystemSettings::GetColour(wxSYS_COLOUR_WINDOWTEXT);
 
@@ -423,13 +426,15 @@ void GroupVisual::Draw ( wxDC& dc, InstanceCtrl* parent, wxRect limitingRect, bo
 		wxPen pen(textColor);
 		dc.SetBrush(brush);
 		dc.SetPen(pen);
-		wxSize sz = dc.GetTextExtent(GetName());
+		dc.SetFont(parent->GetFont());
+		if (header_text_width < 0)
+			header_text_width = dc.GetTextExtent(GetName()).x;
 		dc.SetTextForeground(textColor);
 		
 		dc.DrawText( GetName() , 20, y_position + 5 );
 		int atheight = y_position + header_height / 2;
-		if(sz.x + 30 < limitingRect.width - 10)
-			dc.DrawLine(sz.x + 30,atheight, limitingRect.width - 10, atheight);
+		if(header_text_width + 30 < limitingRect.width - 10)
+			dc.DrawLine(header_text_width + 30,atheight, limitingRect.width - 10, atheight);
 		
 		dc.SetBrush(*wxTRANSPARENT_BRUSH);
 		dc.SetPen(textColor);
@@ -446,11 +451,18 @@ void GroupVisual::Draw ( wxDC& dc, InstanceCtrl* parent, wxRect limitingRect, bo
 		}
 	}
 	
-	if(IsExpanded()) for (i = 0; i < count; i++)
+	if(!IsExpanded())
+		return;
+	
+	// only look at the rows that overlap the dirty rectangle
+	int firstRow = wxMax(RowAt(dirtyRect.GetTop()), 0);
+	int lastRow = RowAt(dirtyRect.GetBottom());
+	int last = wxMin((lastRow + 1) * per_row, count);
+	for (i = firstRow * per_row; i < last; i++)
 	{
 		parent->GetItemRect(VisualCoord(index,i), rect, false);
 
-		if (!limitingRect.Intersects(rect))
+		if (!dirtyRect.Intersects(rect))
 			continue;
 		style = 0;
 		if (hasSelection && selectionIndex == i)
@@ -466,14 +478,36 @@ void GroupVisual::Draw ( wxDC& dc, InstanceCtrl* parent, wxRect limitingRect, bo
 
 void InstanceCtrl::OnSetFocus(wxFocusEvent& WXUNUSED(event))
 {
-	if (GetCount() > 0)
-		Refresh();
+	// Focus only affects the selected item.
+	wxRect rect;
+	if (GetItemRect(m_selectedItem, rect))
+		RefreshRect(rect);
 }
 
 void InstanceCtrl::OnKillFocus(wxFocusEvent& WXUNUSED(event))
 {
-	if (GetCount() > 0)
-		Refresh();
+	wxRect rect;
+	if (GetItemRect(m_selectedItem, rect))
+		RefreshRect(rect);
+}
+
+void InstanceCtrl::OnSysColourChanged(wxSysColourChangedEvent& event)
+{
+	SetBackgroundColour(wxSystemSettings::GetColour(wxSYS_COLOUR_WINDOW));
+	InvalidateCache();
+	Refresh();
+	event.Skip();
+}
+
+void InstanceCtrl::InvalidateCache()
+{
+	for (unsigned i = 0; i < m_groups.size(); i++)
+	{
+		GroupVisual & gv = m_groups[i];
+		gv.header_text_width = -1;
+		for (unsigned j = 0; j < gv.items.size(); j++)
+			gv.items[j].InvalidateCache();
+	}
 }
 
 /// Left-click
@@ -639,7 +673,7 @@ bool InstanceCtrl::InstCtrlDropTarget::OnDropText(wxCoord x, wxCoord y, const wx
 				{
 					inst->SetGroup(gv->GetName());
 				}
-				m_parent->ReloadAll();
+				// the model tells the control about the change
 
 				return true;
 			}
@@ -1093,9 +1127,8 @@ void InstanceCtrl::ToggleGroup ( int index )
 {
 	GroupVisual & gv = m_groups[index];
 	gv.SetExpanded(!gv.IsExpanded());
-	ReflowAll();
-	SetupScrollbars();
-	Refresh();
+	ReflowGroup(index);
+	LayoutChanged(index);
 }
 
 /// Find the item under the given point
@@ -1115,40 +1148,47 @@ void InstanceCtrl::HitTest( const wxPoint& pt, VisualCoord& n )
 	unsigned rowPos = 0;
 	int actualY = pt.y + startY * ppuY;
 	
-	GroupVisual * found = nullptr;
-	unsigned grpIdx = 0;
-	for(; grpIdx < m_groups.size(); grpIdx++)
+	// groups are laid out top to bottom, so find the last one starting above the point
+	int lo = 0, hi = m_groups.size();
+	while (lo < hi)
 	{
-		GroupVisual & gv = m_groups[grpIdx];
-		if (actualY >= gv.y_position && actualY <= gv.y_position + gv.total_height)
+		int mid = (lo + hi) / 2;
+		if (m_groups[mid].y_position <= actualY)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	// it's not even a group
+	if (lo == 0)
+		return;
+	unsigned grpIdx = lo - 1;
+	GroupVisual * found = &m_groups[grpIdx];
+	if (actualY > found->y_position + found->total_height)
+		return;
+	
+	n.makeGroup(grpIdx);
+	if (!found->no_header && actualY <= found->y_position + found->header_height)
+	{
+		// it's a header
+		if(pt.x >= 5 && pt.x <= 15)
 		{
-			found = &gv;
-			n.makeGroup(grpIdx);
-			if (!gv.no_header && actualY <= gv.y_position + gv.header_height)
-			{
-				// it's a header
-				if(pt.x >= 5 && pt.x <= 15)
-				{
-					// it's the ticker thing
-					n.makeHeaderTicker(grpIdx);
-				}
-				else
-				{
-					// it's the header in general
-					n.makeHeader(grpIdx);
-				}
-				return;
-			}
-			break;
+			// it's the ticker thing
+			n.makeHeaderTicker(grpIdx);
 		}
+		else
+		{
+			// it's the header in general
+			n.makeHeader(grpIdx);
+		}
+		return;
 	}
-	// it's not even a group
-	if(!found)
+	if (!found->IsExpanded())
 		return;
 	
-	while (rowPos < found->row_ys.size() && found->y_position + found->row_ys[rowPos] < actualY)
-		rowPos++;
-	rowPos--;
+	int row = found->RowAt(actualY);
+	if (row < 0)
+		return;
+	rowPos = row;
 	
 	unsigned itemN = (rowPos * perRow + colPos);
 	if (itemN >= found->items.size())
@@ -1164,7 +1204,7 @@ void InstanceCtrl::HitTest( const wxPoint& pt, VisualCoord& n )
 }
 
 /// Paint the background
-void InstanceCtrl::PaintBackground(wxDC& dc)
+void InstanceCtrl::PaintBackground(wxDC& dc, const wxRect& rect)
 {
 	wxColour backgroundColour = GetBackgroundColour();
 	if (!backgroundColour.Ok())
@@ -1173,12 +1213,7 @@ void InstanceCtrl::PaintBackground(wxDC& dc)
 	// Clear the background
 	dc.SetBrush(wxBrush(backgroundColour));
 	dc.SetPen(*wxTRANSPARENT_PEN);
-	wxRect windowRect(wxPoint(0, 0), GetClientSize());
-	
-	// We need to shift the rectangle to take into account
-	// scrolling. Converting device to logical coordinates.
-	CalcUnscrolledPosition(windowRect.x, windowRect.y, & windowRect.x, & windowRect.y);
-	dc.DrawRectangle(windowRect);
+	dc.DrawRectangle(rect);
 }
 
 /// Recreate buffer bitmap if necessary
@@ -1199,6 +1234,7 @@ bool InstanceCtrl::RecreateBuffer(const wxSize& size)
 void GroupVisual::Reflow ( int perRow, int spacing, int margin, int lineHeight, int imageSize, int & progressive_y )
 {
 	y_position = progressive_y;
+	per_row = perRow;
 	int numitems = items.size();
 	int numrows = (numitems / perRow) + (numitems % perRow != 0);
 	row_ys.clear();
@@ -1248,6 +1284,20 @@ void GroupVisual::Reflow ( int perRow, int spacing, int margin, int lineHeight,
 	progressive_y += total_height;
 }
 
+int GroupVisual::RowAt ( int y ) const
+{
+	int lo = 0, hi = row_ys.size();
+	while (lo < hi)
+	{
+		int mid = (lo + hi) / 2;
+		if (y_position + row_ys[mid] <= y)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo - 1;
+}
+
 
 void InstanceCtrl::ReflowAll()
 {
@@ -1264,10 +1314,22 @@ void InstanceCtrl::ReflowAll()
  */
 void InstanceVisual::updateName()
 {
-	wxDC* dc = new wxScreenDC();
 	wxString raw_name = wxEmptyString;
 	if (m_inst)
 		raw_name = m_inst->GetName();
+	m_cacheName = raw_name;
+	m_cache = wxNullBitmap;
+	
+	WrappedLabel label;
+	if (m_ctrl->GetWrappedLabel(raw_name, label))
+	{
+		name_wrapped = label.text;
+		text_width = label.width;
+		text_lines = label.lines;
+		return;
+	}
+	
+	wxDC* dc = new wxScreenDC();
 	dc->SetFont(m_ctrl->GetFont());
 	wxArrayInt extents;
 	dc->GetPartialTextExtents(raw_name, extents);
@@ -1332,12 +1394,46 @@ void InstanceVisual::updateName()
 		text_lines++;
 	}
 	delete dc;
+	
+	label.text = name_wrapped;
+	label.width = text_width;
+	label.lines = text_lines;
+	m_ctrl->SetWrappedLabel(raw_name, label);
 }
 
 /// Draw the item
 bool InstanceVisual::Draw(wxDC& dc, const wxRect& rect, int style)
 {
-	wxColour backgroundColor = wxSystemSettings::GetColour(wxSYS_COLOUR_WINDOW);
+	// Focus isn't drawn, so only the selection counts.
+	style &= wxINST_SELECTED;
+	
+	// The label is wrapped in InstanceCtrl::InstanceRenamed, which also reflows
+	// the group. Doing it here could change the item height without a reflow.
+	if (!m_cache.IsOk() || m_cache.GetSize() != rect.GetSize() ||
+	    m_cacheStyle != style || m_cacheIcon != m_inst->GetIconKey())
+	{
+		Render(rect.GetSize(), style);
+	}
+	
+	dc.DrawBitmap(m_cache, rect.x, rect.y, false);
+	return true;
+}
+
+void InstanceVisual::Render(const wxSize& size, int style)
+{
+	m_cache = wxBitmap(size.x, size.y);
+	m_cacheStyle = style;
+	m_cacheIcon = m_inst->GetIconKey();
+	
+	wxMemoryDC dc(m_cache);
+	wxRect rect(size);
+	
+	wxColour backgroundColor = m_ctrl->GetBackgroundColour();
+	if (!backgroundColor.Ok())
+		backgroundColor = wxSystemSettings::GetColour(wxSYS_COLOUR_WINDOW);
+	dc.SetBackground(wxBrush(backgroundColor));
+	dc.Clear();
+	
 	wxColour textColor = wxSystemSettings::GetColour(wxSYS_COLOUR_WINDOWTEXT);
 	wxColour highlightTextColor = wxSystemSettings::GetColour(wxSYS_COLOUR_HIGHLIGHTTEXT);
 	wxColour focus_color = wxSystemSettings::GetColour(wxSYS_COLOUR_HIGHLIGHT);
@@ -1361,8 +1457,7 @@ bool InstanceVisual::Draw(wxDC& dc, const wxRect& rect, int style)
 	}
 	
 	// Draw the label
-	wxString name = m_inst->GetName();
-	if (!name.IsEmpty())
+	if (!m_cacheName.IsEmpty())
 	{
 		int margin = m_ctrl->GetItemMargin();
 		
@@ -1396,15 +1491,15 @@ bool InstanceVisual::Draw(wxDC& dc, const wxRect& rect, int style)
 	auto list = InstIconList::Instance();
 	wxImage icon;
 	if (style & wxINST_SELECTED)
-		icon = list->getHLImageForKey(m_inst->GetIconKey());
+		icon = list->getHLImageForKey(m_cacheIcon);
 	else
-		icon = list->getImageForKey(m_inst->GetIconKey());
+		icon = list->getImageForKey(m_cacheIcon);
 	wxBitmap bmap = wxBitmap(icon);
 	int x = imageRect.x + (imageRect.width - bmap.GetWidth()) / 2;
 	int y = imageRect.y + (imageRect.height - bmap.GetHeight()) / 2;
 	dc.DrawBitmap(bmap , x, y, true);
 	
-	return true;
+	dc.SelectObject(wxNullBitmap);
 }
 
 wxSize InstanceCtrl::DoGetBestSize() const
@@ -1454,10 +1549,15 @@ void InstanceCtrl::ReloadAll()
 	
 	int totalitems = m_instList->size();
 	
+	if (!m_filter.IsEmpty())
+		m_instList->Search(m_filter, m_filterMatches);
+	
 	/// sort items into groups
 	std::map<InstanceGroup *, InstanceItemArray> sorter;
 	for (int i = 0; i < totalitems ; i++)
 	{
+		if (!m_filter.IsEmpty() && !m_filterMatches[i])
+			continue;
 		auto inst = m_instList->operator[](i);
 		InstanceGroup *group =  m_instList->GetInstanceGroup(inst);
 
@@ -1474,7 +1574,8 @@ void InstanceCtrl::ReloadAll()
 		}
 	}
 	
-	m_itemIndexes.resize(totalitems);
+	// filtered out instances don't have an index
+	m_itemIndexes.assign(totalitems, VisualCoord());
 
 	// sort items in each group
 	auto iter = sorter.begin();
@@ -1515,6 +1616,14 @@ void InstanceCtrl::ReloadAll()
 	}
 	
 	int selectedIdx = m_instList->GetSelectedIndex();
+	bool selectionHidden = false;
+	if(selectedIdx != -1 && m_itemIndexes[selectedIdx].isVoid())
+	{
+		// the filter hides it, so nothing should act on it anymore
+		m_instList->CtrlSelectInstance(-1);
+		selectedIdx = -1;
+		selectionHidden = true;
+	}
 	if(selectedIdx == -1)
 	{
 		if(m_focusItem == m_selectedItem)
@@ -1545,9 +1654,258 @@ void InstanceCtrl::ReloadAll()
 	Refresh();
 	
 	// and reset the intended navigation column
-	int row, col;
+	int row = 0, col = 0;
 	GetRowCol(m_selectedItem, row, col);
 	m_intended_column = col;
+	
+	if (selectionHidden)
+	{
+		InstanceCtrlEvent eventDeselect(wxEVT_COMMAND_INST_ITEM_DESELECTED,GetId());
+		eventDeselect.SetEventObject(this);
+		eventDeselect.SetItemID(-1);
+		GetEventHandler()->ProcessEvent(eventDeselect);
+	}
+}
+
+void InstanceCtrl::InstanceAdded(int ID)
+{
+	// new instances are always appended to the model
+	Instance *inst = m_instList->at(ID);
+	int grp = inst ? FindGroup(m_instList->GetInstanceGroup(inst)) : -1;
+	if (grp < 0 || ID != (int)m_itemIndexes.size() || !m_filter.IsEmpty())
+	{
+		ReloadAll();
+		return;
+	}
+	
+	int focusID = IDFromIndex(m_focusItem);
+	GroupVisual & gv = m_groups[grp];
+	InstanceVisual item(this, inst, ID);
+	gv.items.Insert(item, SortedPosition(gv, item));
+	m_itemIndexes.push_back(VisualCoord());
+	UpdateGroupIndexes(grp);
+	RestoreSelection(focusID);
+	
+	ReflowGroup(grp);
+	LayoutChanged(grp);
+}
+
+void InstanceCtrl::InstanceRemoved(int ID)
+{
+	// the instance is already gone from the model, don't touch it
+	if (ID < 0 || ID >= (int)m_itemIndexes.size() || m_itemIndexes.size() != m_instList->size() + 1 || !m_filter.IsEmpty())
+	{
+		ReloadAll();
+		return;
+	}
+	VisualCoord coord = m_itemIndexes[ID];
+	GroupVisual & gv = m_groups[coord.groupIndex];
+	if (gv.items.size() == 1)
+	{
+		// the group goes away with it
+		ReloadAll();
+		return;
+	}
+	
+	int focusID = IDFromIndex(m_focusItem);
+	if (focusID == ID)
+		focusID = -1;
+	else if (focusID > ID)
+		focusID--;
+	
+	gv.items.RemoveAt(coord.itemIndex);
+	m_itemIndexes.erase(m_itemIndexes.begin() + ID);
+	
+	// IDs are model indexes, so everything after the removed instance moves down
+	for (unsigned i = 0; i < m_groups.size(); i++)
+	{
+		GroupVisual & grp = m_groups[i];
+		for (unsigned j = 0; j < grp.items.size(); j++)
+		{
+			InstanceVisual & iv = grp.items[j];
+			if (iv.GetID() > ID)
+				iv.SetID(iv.GetID() - 1);
+		}
+	}
+	UpdateGroupIndexes(coord.groupIndex);
+	RestoreSelection(focusID);
+	
+	ReflowGroup(coord.groupIndex);
+	LayoutChanged(coord.groupIndex);
+}
+
+void InstanceCtrl::InstanceRenamed(int ID)
+{
+	if (ID < 0 || ID >= (int)m_itemIndexes.size() || !m_filter.IsEmpty())
+	{
+		ReloadAll();
+		return;
+	}
+	VisualCoord coord = m_itemIndexes[ID];
+	GroupVisual & gv = m_groups[coord.groupIndex];
+	int focusID = IDFromIndex(m_focusItem);
+	
+	// re-wrap the label and move the item to its new place in the sort order
+	InstanceVisual item = gv.items[coord.itemIndex];
+	item.updateName();
+	gv.items.RemoveAt(coord.itemIndex);
+	gv.items.Insert(item, SortedPosition(gv, item));
+	UpdateGroupIndexes(coord.groupIndex);
+	RestoreSelection(focusID);
+	
+	ReflowGroup(coord.groupIndex);
+	LayoutChanged(coord.groupIndex);
+}
+
+void InstanceCtrl::InstanceGroupChanged(int ID)
+{
+	Instance *inst = m_instList->at(ID);
+	if (!inst || ID >= (int)m_itemIndexes.size() || !m_filter.IsEmpty())
+	{
+		ReloadAll();
+		return;
+	}
+	VisualCoord coord = m_itemIndexes[ID];
+	int newGrp = FindGroup(m_instList->GetInstanceGroup(inst));
+	if (newGrp == coord.groupIndex)
+		return;
+	// a group has to be created or goes away
+	if (newGrp < 0 || m_groups[coord.groupIndex].items.size() == 1)
+	{
+		ReloadAll();
+		return;
+	}
+	
+	int focusID = IDFromIndex(m_focusItem);
+	GroupVisual & oldGv = m_groups[coord.groupIndex];
+	GroupVisual & newGv = m_groups[newGrp];
+	InstanceVisual item = oldGv.items[coord.itemIndex];
+	oldGv.items.RemoveAt(coord.itemIndex);
+	newGv.items.Insert(item, SortedPosition(newGv, item));
+	UpdateGroupIndexes(coord.groupIndex);
+	UpdateGroupIndexes(newGrp);
+	RestoreSelection(focusID);
+	
+	ReflowGroup(coord.groupIndex);
+	ReflowGroup(newGrp);
+	LayoutChanged(wxMin(coord.groupIndex, newGrp));
+}
+
+void InstanceCtrl::SetFilter(const wxString& query)
+{
+	wxString filter = query;
+	filter.Trim(true).Trim(false);
+	if (filter == m_filter)
+		return;
+	m_filter = filter;
+	ReloadAll();
+}
+
+bool InstanceCtrl::GetWrappedLabel(const wxString& name, WrappedLabel& label) const
+{
+	auto found = m_wrappedLabels.find(name);
+	if (found == m_wrappedLabels.end())
+		return false;
+	label = found->second;
+	return true;
+}
+
+void InstanceCtrl::SetWrappedLabel(const wxString& name, const WrappedLabel& label)
+{
+	m_wrappedLabels[name] = label;
+}
+
+void InstanceCtrl::ReflowGroup(int index)
+{
+	GroupVisual & gv = m_groups[index];
+	int old_height = gv.total_height;
+	int progressive_y = gv.y_position;
+	gv.Reflow(m_itemsPerRow,m_spacing,m_itemMargin,m_itemTextHeight,m_ImageSize.GetHeight(), progressive_y);
+	
+	int delta = gv.total_height - old_height;
+	if (delta == 0)
+		return;
+	for (unsigned i = index + 1; i < m_groups.size(); i++)
+		m_groups[i].y_position += delta;
+}
+
+void InstanceCtrl::LayoutChanged(int index)
+{
+	if (m_freezeCount)
+		return;
+	
+	SetupScrollbars();
+	
+	wxRect rect;
+	if (!GetGroupRect(index, rect))
+	{
+		Refresh();
+		return;
+	}
+	wxSize clientSize = GetClientSize();
+	if (rect.y < 0)
+	{
+		rect.height += rect.y;
+		rect.y = 0;
+	}
+	rect.height = clientSize.y - rect.y;
+	if (rect.height > 0)
+		RefreshRect(rect);
+}
+
+int InstanceCtrl::FindGroup(InstanceGroup *group) const
+{
+	for (unsigned i = 0; i < m_groups.size(); i++)
+	{
+		if (m_groups[i].m_group == group)
+			return i;
+	}
+	return -1;
+}
+
+int InstanceCtrl::SortedPosition(GroupVisual& group, InstanceVisual& item) const
+{
+	InstanceVisual *itemPtr = &item;
+	// binary search, new items go after equal ones
+	int lo = 0, hi = group.items.size();
+	while (lo < hi)
+	{
+		int mid = (lo + hi) / 2;
+		InstanceVisual *midPtr = &group.items[mid];
+		int cmp;
+		if (settings->GetInstSortMode() == Sort_LastLaunch)
+			cmp = LastLaunchSort(&itemPtr, &midPtr);
+		else
+			cmp = NameSort(&itemPtr, &midPtr);
+		if (cmp < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return lo;
+}
+
+void InstanceCtrl::UpdateGroupIndexes(int index)
+{
+	GroupVisual & grp = m_groups[index];
+	for (unsigned j = 0; j < grp.items.size(); j++)
+	{
+		m_itemIndexes[grp.items[j].GetID()] = VisualCoord(index, j);
+	}
+}
+
+void InstanceCtrl::RestoreSelection(int focusID)
+{
+	int selectedIdx = m_instList->GetSelectedIndex();
+	if (selectedIdx < 0 || selectedIdx >= (int)m_itemIndexes.size())
+		m_selectedItem.makeVoid();
+	else
+		m_selectedItem = m_itemIndexes[selectedIdx];
+	
+	if (focusID < 0 || focusID >= (int)m_itemIndexes.size())
+		m_focusItem.makeVoid();
+	else
+		m_focusItem = m_itemIndexes[focusID];
 }
 
 void InstanceCtrl::HighlightGroup(const VisualCoord& coord)
@@ -1601,6 +1959,8 @@ GroupVisual::GroupVisual(InstanceGroup *group, bool no_header)
 	m_group = group;
 	total_height = 0;
 	header_height = 0;
+	header_text_width = -1;
+	per_row = 1;
 	y_position = 0;
 	index = -1;
 	always_show = false;
@@ -5,6 +5,7 @@
 
 #include "wx/dynarray.h"
 #include "wx/dnd.h"
+#include "wx/hashmap.h"
 #include <instance.h>
 #include <insticonlist.h>
 
@@ -45,6 +46,15 @@ class InstanceCtrl;
 
 class InstanceCtrlEvent;
 
+/// An instance name wrapped to fit under the icon
+struct WrappedLabel
+{
+	wxString text;
+	int width;
+	int lines;
+};
+WX_DECLARE_STRING_HASH_MAP(WrappedLabel, WrappedLabelMap);
+
 class InstanceVisual
 {
 	InstanceVisual();
@@ -53,6 +63,7 @@ public:
 	InstanceVisual(InstanceCtrl* ctrl, Instance* inst, int ID)
 	{
 		m_ctrl = ctrl;
+		m_cacheStyle = 0;
 		SetInstance(inst, ID);
 	}
 
@@ -65,6 +76,7 @@ public:
 	{
 		m_inst = inst;
 		m_id = ID;
+		m_cache = wxNullBitmap;
 		updateName();
 	}
 	
@@ -78,6 +90,12 @@ public:
 		return m_id;
 	}
 	
+	/// IDs are model indexes, so they move when an instance before this one is removed
+	void SetID(int ID)
+	{
+		m_id = ID;
+	}
+	
 	void updateName();
 	
 	int GetNumLines()
@@ -88,13 +106,28 @@ public:
 	/// Draw the item
 	bool Draw(wxDC& dc, const wxRect& rect, int style);
 	
+	/// Drop the cached bitmap, e.g. after a font or colour change
+	void InvalidateCache()
+	{
+		m_cache = wxNullBitmap;
+	}
+	
 protected:
+	/// Render the icon and label into the cached bitmap
+	void Render(const wxSize& size, int style);
+	
 	InstanceCtrl* m_ctrl;
 	Instance*   m_inst;
 	int         m_id;
 	int         text_width;
 	wxString    name_wrapped;
 	int         text_lines;
+	
+	/// The rendered item and what it was rendered from
+	wxBitmap    m_cache;
+	wxString    m_cacheName;
+	wxString    m_cacheIcon;
+	int         m_cacheStyle;
 };
 
 WX_DECLARE_OBJARRAY(InstanceVisual, InstanceItemArray);
@@ -170,7 +203,9 @@ struct GroupVisual
 {
 	GroupVisual(InstanceGroup *group, bool no_header = false);
 	void Reflow ( int perRow, int spacing, int margin, int lineHeight, int imageSize, int & progressive_y );
-	void Draw ( wxDC & dc, InstanceCtrl* parent, wxRect untransformedRect,
+	/// Index of the last row starting at or above the absolute y position, -1 if there's none
+	int RowAt ( int y ) const;
+	void Draw ( wxDC & dc, InstanceCtrl* parent, wxRect untransformedRect, const wxRect& dirtyRect,
 	            bool hasSelection, int selectionIndex,
 	            bool hasFocus, int focusIndex, bool highlight = false );
 	void SetIndex (int index)
@@ -202,12 +237,18 @@ struct GroupVisual
 	/// height of the header in pixels
 	int header_height;
 	
+	/// width of the header text, -1 until it's measured
+	int header_text_width;
+	
 	/// y positions where each row starts
 	wxArrayInt               row_ys;
 	
 	/// height of each row (spacing not included)
 	wxArrayInt               row_heights;
 	
+	/// items per row at the last reflow
+	int per_row;
+	
 	/// sorted index of this group
 	int index;
 };
@@ -241,6 +282,25 @@ public:
 	/// Reloads the items from the instance model
 	void ReloadAll();
 	
+	/// Incremental updates for a single instance (by model index).
+	/// These fall back to ReloadAll when a group has to be added or removed.
+	void InstanceAdded(int ID);
+	void InstanceRemoved(int ID);
+	void InstanceRenamed(int ID);
+	void InstanceGroupChanged(int ID);
+	
+	/// Only show the instances matching the search query (see InstanceModel::Search).
+	/// An empty query shows everything.
+	void SetFilter(const wxString &query);
+	wxString GetFilter() const
+	{
+		return m_filter;
+	}
+	
+	/// Wrapped labels by instance name, so rebuilding the items doesn't measure the text again
+	bool GetWrappedLabel(const wxString &name, WrappedLabel &label) const;
+	void SetWrappedLabel(const wxString &name, const WrappedLabel &label);
+	
 // Accessing items
 
 	/// Get the number of groups in the control
@@ -336,6 +396,17 @@ public:
 		}
 		return total;
 	}
+	
+	/// Number of paints and the total time spent in them, in microseconds
+	int GetPaintCount() const
+	{
+		return m_paintCount;
+	}
+	wxLongLong GetPaintTime() const
+	{
+		return m_paintTime;
+	}
+	
 // Event handlers
 
 	/// Painting
@@ -375,6 +446,9 @@ public:
 	/// Setting/losing focus
 	void OnSetFocus(wxFocusEvent& event);
 	void OnKillFocus(wxFocusEvent& event);
+	
+	/// System colours changed, drop the cached item bitmaps
+	void OnSysColourChanged(wxSysColourChangedEvent& event);
 
 	void HighlightGroup(const VisualCoord& coord);
 
@@ -385,7 +459,24 @@ private:
 
 	/// Update the row heights for layouting.
 	void ReflowAll( );
-	void ReflowGroup( GroupVisual & group );
+	
+	/// Reflow a single group and shift the groups below it by the height difference
+	void ReflowGroup( int index );
+	
+	/// Update the scrollbars and repaint everything from the given group down
+	void LayoutChanged( int index );
+	
+	/// Find the visual group for a model group, -1 if there's none
+	int FindGroup(InstanceGroup *group) const;
+	
+	/// Where an item goes in the group according to the sort mode
+	int SortedPosition(GroupVisual& group, InstanceVisual& item) const;
+	
+	/// Update the ID to index mapping for all items in the group
+	void UpdateGroupIndexes(int index);
+	
+	/// Take the selection from the model and the focus from the given ID
+	void RestoreSelection(int focusID);
 	
 	/// Set up scrollbars, e.g. after a resize
 	void SetupScrollbars();
@@ -440,8 +531,11 @@ private:
 	/// Toggle the expansion of a group (user input driven)
 	void ToggleGroup(int index);
 	
-	/// Paint the background
-	void PaintBackground(wxDC& dc);
+	/// Paint the background of the given rectangle (logical coordinates)
+	void PaintBackground(wxDC& dc, const wxRect& rect);
+	
+	/// Drop all cached item and header renderings
+	void InvalidateCache();
 	
 	/// Recreate buffer bitmap if necessary
 	bool RecreateBuffer(const wxSize& size = wxDefaultSize);
@@ -498,6 +592,17 @@ private:
 	
 	/// items per row - cached
 	int                      m_itemsPerRow;
+	
+	/// Paint statistics
+	int                      m_paintCount;
+	wxLongLong               m_paintTime;
+	
+	/// Current search query and which instances match it (by model index)
+	wxString                 m_filter;
+	std::vector<bool>        m_filterMatches;
+	
+	/// Label wrapping cache
+	WrappedLabelMap          m_wrappedLabels;
 };
 
 /*!
@@ -0,0 +1,148 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+
+#include "launchlogdialog.h"
+
+#include <wx/sizer.h>
+#include <wx/button.h>
+#include <wx/utils.h>
+#include <wx/filename.h>
+
+#include "instance.h"
+#include "launchlog.h"
+#include "utils/apputils.h"
+
+// Showing a log only shows its end, older lines can be found by searching.
+const int64_t shownLines = 5000;
+const size_t maxSearchResults = 1000;
+
+LaunchLogDialog::LaunchLogDialog(wxWindow *parent, Instance *inst)
+	: wxDialog(parent, wxID_ANY, _("Launch Logs"), wxDefaultPosition, wxSize(760, 480), 
+		wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER), m_inst(inst)
+{
+	SetAprilFonts(this);
+
+	wxBoxSizer *dlgSizer = new wxBoxSizer(wxVERTICAL);
+	SetSizer(dlgSizer);
+
+	wxBoxSizer *searchSz = new wxBoxSizer(wxHORIZONTAL);
+	searchBox = new wxTextCtrl(this, ID_SearchBox, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxTE_PROCESS_ENTER);
+	searchSz->Add(searchBox, wxSizerFlags(1).Border(wxRIGHT, 4).Expand());
+	searchSz->Add(new wxButton(this, ID_Search, _("&Search All")));
+	dlgSizer->Add(searchSz, wxSizerFlags(0).Border(wxALL, 8).Expand());
+
+	wxBoxSizer *mainSz = new wxBoxSizer(wxHORIZONTAL);
+	logList = new wxListBox(this, ID_LogList, wxDefaultPosition, wxSize(200, -1));
+	mainSz->Add(logList, wxSizerFlags(0).Border(wxRIGHT, 4).Expand());
+	logText = new wxTextCtrl(this, -1, wxEmptyString, wxDefaultPosition, wxDefaultSize, 
+		wxTE_MULTILINE | wxTE_READONLY | wxTE_DONTWRAP | wxHSCROLL);
+	mainSz->Add(logText, wxSizerFlags(1).Expand());
+	dlgSizer->Add(mainSz, wxSizerFlags(1).Border(wxLEFT | wxRIGHT, 8).Expand());
+
+	wxSizer *btnSz = CreateButtonSizer(wxOK);
+	dlgSizer->Add(btnSz, wxSizerFlags(0).Border(wxALL, 8).Align(wxALIGN_RIGHT));
+
+	LoadLogList();
+	if (!m_logs.IsEmpty())
+	{
+		logList->SetSelection(0);
+		ShowLog(0);
+	}
+	CenterOnParent();
+}
+
+void LaunchLogDialog::LoadLogList()
+{
+	m_logs = LaunchLogReader::ListLogs(m_inst->GetLaunchLogDir().GetFullPath());
+	logList->Clear();
+	for (size_t i = 0; i < m_logs.size(); i++)
+	{
+		// Only the index is read here, so this stays fast with big logs.
+		LaunchLogReader reader;
+		wxString label = wxFileName(m_logs[i]).GetName();
+		if (reader.Open(m_logs[i]) && reader.GetStartTime().IsValid())
+		{
+			label = wxString::Format(_("%s (%lld lines)"), 
+				reader.GetStartTime().Format("%Y-%m-%d %H:%M:%S").c_str(), (wxLongLong_t)reader.GetLineCount());
+		}
+		logList->Append(label);
+	}
+}
+
+void LaunchLogDialog::ShowLog(int index)
+{
+	if (index < 0 || index >= (int)m_logs.size())
+		return;
+
+	LaunchLogReader reader;
+	wxArrayString lines;
+	if (!reader.Open(m_logs[index]) || !reader.ReadTail(shownLines, lines))
+	{
+		logText->SetValue(_("Failed to read the log."));
+		return;
+	}
+
+	wxString text;
+	if (reader.GetLineCount() > shownLines)
+		text << wxString::Format(_("(Only the last %lld lines are shown.)"), (wxLongLong_t)shownLines) << "\n";
+	for (size_t i = 0; i < lines.size(); i++)
+		text << lines[i] << "\n";
+	logText->SetValue(text);
+	logText->ShowPosition(logText->GetLastPosition());
+}
+
+void LaunchLogDialog::OnLogSelected(wxCommandEvent &event)
+{
+	ShowLog(logList->GetSelection());
+}
+
+void LaunchLogDialog::OnSearch(wxCommandEvent &event)
+{
+	wxString query = searchBox->GetValue();
+	if (query.IsEmpty())
+		return;
+
+	wxBusyCursor busy;
+	wxString text;
+	size_t found = 0;
+	for (size_t i = 0; i < m_logs.size() && found < maxSearchResults; i++)
+	{
+		LaunchLogReader reader;
+		if (!reader.Open(m_logs[i]))
+			continue;
+
+		std::vector<LaunchLogReader::Match> matches;
+		reader.Search(query, matches, maxSearchResults - found);
+		for (size_t j = 0; j < matches.size(); j++)
+		{
+			text << logList->GetString(i) << ", " << wxString::Format(_("line %lld"), (wxLongLong_t)matches[j].line + 1)
+				<< ": " << matches[j].text << "\n";
+		}
+		found += matches.size();
+	}
+
+	if (found == 0)
+		text = wxString::Format(_("Nothing found for \"%s\"."), query.c_str());
+	logList->SetSelection(wxNOT_FOUND);
+	logText->SetValue(text);
+}
+
+BEGIN_EVENT_TABLE(LaunchLogDialog, wxDialog)
+	EVT_LISTBOX(ID_LogList, LaunchLogDialog::OnLogSelected)
+	EVT_BUTTON(ID_Search, LaunchLogDialog::OnSearch)
+	EVT_TEXT_ENTER(ID_SearchBox, LaunchLogDialog::OnSearch)
+END_EVENT_TABLE()
@@ -0,0 +1,54 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+
+#pragma once
+#include <wx/dialog.h>
+#include <wx/listbox.h>
+#include <wx/textctrl.h>
+
+class Instance;
+
+// Shows the logs of an instance's earlier launches and searches through them.
+class LaunchLogDialog : public wxDialog
+{
+public:
+	LaunchLogDialog(wxWindow *parent, Instance *inst);
+
+protected:
+	void LoadLogList();
+	void ShowLog(int index);
+
+	void OnLogSelected(wxCommandEvent &event);
+	void OnSearch(wxCommandEvent &event);
+
+	wxListBox *logList;
+	wxTextCtrl *searchBox;
+	wxTextCtrl *logText;
+
+	// paths of the logs in the list
+	wxArrayString m_logs;
+	Instance *m_inst;
+
+	enum
+	{
+		ID_LogList = 1,
+		ID_SearchBox,
+		ID_Search,
+	};
+
+	DECLARE_EVENT_TABLE()
+};
@@ -40,7 +40,9 @@
 #include "minecraftversiondialog.h"
 #include "lwjgldialog.h"
 #include "savemgrwindow.h"
+#include "launchlogdialog.h"
 #include "stdinstance.h"
+#include "trash.h"
 #include <mcversionlist.h>
 #include <mcprocess.h>
 #include "lwjglinstalltask.h"
@@ -109,6 +111,7 @@ MainWindow::MainWindow(void)
 	instActionsEnabled = true;
 	instMenu = nullptr;
 	instListCtrl = nullptr;
+	instLoadTask = nullptr;
 
 	instPanel = nullptr;
 	
@@ -157,6 +160,8 @@ MainWindow::MainWindow(void)
 		addInstMenu->Append(ID_ImportInst, _("Import existing .minecraft folder"));
 		addInstMenu->Append(ID_ImportCP, _("Import config pack"));
 		addInstMenu->Append(ID_ImportFTB, _("Import from FTB launcher."));
+		addInstMenu->AppendSeparator();
+		addInstMenu->Append(ID_RestoreInst, _("Restore deleted instance."));
 
 		auto tool = mainToolBar->AddTool(ID_AddInst, _("Add instance"), newInstIcon, _("Add a new instance."), wxITEM_DROPDOWN);
 		tool->SetDropdownMenu(addInstMenu);
@@ -212,6 +217,14 @@ MainWindow::MainWindow(void)
 		aboutIcon, wxNullBitmap, wxITEM_NORMAL,
 		_("About MultiMC"), _("About MultiMC"));
 	
+	// instance search, filters the instance list as you type
+	mainToolBar->AddStretchableSpace();
+	instSearch = new wxSearchCtrl(mainToolBar, ID_SearchInst, wxEmptyString, 
+		wxDefaultPosition, wxSize(180, -1));
+	instSearch->SetDescriptiveText(_("Search instances"));
+	instSearch->ShowCancelButton(true);
+	mainToolBar->AddControl(instSearch, _("Search"));
+	
 	mainToolBar->Realize();
 	
 	// Create the status bar
@@ -309,27 +322,12 @@ void MainWindow::OnStartup()
 		settings->SetJavaPath(FindJavaPath());
 	}
 
+	// If an instance should be launched, that happens once the instance list is loaded.
 	if(launchInstance.empty())
 	{
 		NewsCheckTask* task = new NewsCheckTask();
 		task->Start(this, false);
 	}
-	else
-	{
-		instItems.SelectInstanceByID(launchInstance);
-		Instance * inst = instItems.GetSelectedInstance();
-		if(inst == nullptr)
-		{
-			wxString output = _("Couldn't find the instance you tried to load: ");
-			output.append(launchInstance);
-			output.append(_(". Make sure it exists!"));
-			wxLogError(output);
-		}
-		else
-		{
-			LoginClicked();
-		}
-	}
 }
 
 void MainWindow::InitBasicGUI(wxBoxSizer *mainSz)
@@ -366,6 +364,7 @@ void MainWindow::InitInstMenu()
 	instMenu->Append(ID_ChangeLWJGL, _("Change LWJGL"), _("Use a different version of LWJGL with this instance."));
 	instMenu->Append(ID_RebuildJar, _("Re&build Jar"), _("Reinstall all the instance's jar mods."));
 	instMenu->Append(ID_ViewInstFolder, _("&View Folder"), _("Open the instance's folder."));
+	instMenu->Append(ID_ViewLaunchLogs, _("View &Launch Logs"), _("View and search the logs of earlier launches."));
 	instMenu->AppendSeparator();
 	instMenu->Append(ID_DeleteInst, _("Delete"), _("Delete this instance."));
 
@@ -514,6 +513,20 @@ void MainWindow::OnInstSelected(InstanceCtrlEvent &event)
 		UpdateInstPanel();
 }
 
+void MainWindow::OnInstDeselected(InstanceCtrlEvent &event)
+{
+	// Only matters when nothing else got selected, like when the search hides the selection.
+	if(instItems.GetSelectedInstance())
+		return;
+	if(GetGUIMode() == GUI_Fancy)
+		SaveNotesBox(false);
+	SetStatusText(wxEmptyString, 1);
+	SetStatusText(wxEmptyString);
+
+	if(GetGUIMode() == GUI_Fancy)
+		UpdateInstPanel();
+}
+
 void MainWindow::LoadInstanceList(wxFileName instDir)
 {
 	GetStatusBar()->PushStatusText(_("Loading instances..."), 0);
@@ -526,52 +539,68 @@ void MainWindow::LoadInstanceList(wxFileName instDir)
 			return;
 		}
 	}
+
+	// Whatever the previous load still finds is thrown away.
+	if (instLoadTask)
+		instLoadTask->Cancel();
 	
-	int ctr = 0;
-	instItems.Freeze();
-	{
-		instItems.Clear();
-		
-		wxDir dir(instDir.GetFullPath());
-		if (!dir.IsOpened())
-		{
-			return;
-		}
-		
-		Enable(false);
-		wxString subFolder;
-		
-		bool cont = dir.GetFirst(&subFolder, wxEmptyString, wxDIR_DIRS);
-		while (cont)
-		{
-			wxString dirName = Path::Combine(instDir, subFolder);
-			if (IsValidInstance(dirName))
-			{
-				Instance *inst = Instance::LoadInstance(dirName);
-				if (inst != NULL)
-				{
-					AddInstance(inst);
-				}
-				
-				ctr++;
-			}
-			cont = dir.GetNext(&subFolder);
-		}
+	instItems.Clear();
+	wxString groupFile = Path::Combine(settings->GetInstDir(), "instgroups.json");
+	instItems.SetGroupFile(groupFile);
 
+	// Instances are loaded in the background and show up as they are found.
+	instLoadTask = new LoadInstancesTask(instDir, groupFile);
+	instLoadTask->Start(this, false);
+}
 
-		wxString groupFile = Path::Combine(settings->GetInstDir(), "instgroups.json");
-		instItems.SetGroupFile(groupFile);
-		if (wxFileExists(groupFile))
-			instItems.LoadGroupInfo();
+void MainWindow::OnInstancesLoaded(InstancesLoadedEvent &event)
+{
+	// Stale results from a load that was replaced by another one.
+	if (event.m_task != instLoadTask)
+	{
+		for (unsigned i = 0; i < event.m_instances.size(); i++)
+			delete event.m_instances[i];
+		return;
 	}
+
+	instItems.Freeze();
+	if (event.m_hasGroupInfo)
+		instItems.SetGroupInfo(event.m_groupInfo);
+	for (unsigned i = 0; i < event.m_instances.size(); i++)
+		AddInstance(event.m_instances[i]);
 	instItems.Thaw();
-	GetStatusBar()->SetStatusText(wxString::Format(_("Loaded %i instances..."), ctr), 0);
-	Enable(true);
+}
+
+void MainWindow::OnInstanceListLoaded(LoadInstancesTask *task)
+{
+	if (task != instLoadTask)
+		return;
+	instLoadTask = nullptr;
+
+	GetStatusBar()->SetStatusText(wxString::Format(_("Loaded %i instances..."), task->GetInstanceCount()), 0);
 	
 	if (GetGUIMode() == GUI_Fancy)
 	{
 		UpdateInstPanel();
 	}
+
+	if(!launchInstance.empty())
+	{
+		instItems.SelectInstanceByID(launchInstance);
+		Instance * inst = instItems.GetSelectedInstance();
+		if(inst == nullptr)
+		{
+			wxString output = _("Couldn't find the instance you tried to load: ");
+			output.append(launchInstance);
+			output.append(_(". Make sure it exists!"));
+			wxLogError(output);
+		}
+		else
+		{
+			LoginClicked();
+		}
+		launchInstance.clear();
+	}
 	
 	//GetStatusBar()->PopStatusText(0);
 }
@@ -634,6 +663,9 @@ void MainWindow::OnAddInstClicked(wxCommandEvent& event)
 	addInstMenu->Append(ID_ImportInst, _("Import existing .minecraft folder"));
 	addInstMenu->Append(ID_ImportCP, _("Import config pack"));
 	addInstMenu->Append(ID_ImportFTB, _("Import from FTB launcher."));
+	addInstMenu->AppendSeparator();
+	addInstMenu->Append(ID_RestoreInst, _("Restore deleted instance."));
+	addInstMenu->Enable(ID_RestoreInst, !deletedInstances.empty());
 	PopupMenu(addInstMenu);
 	wxDELETE(addInstMenu);
 #endif
@@ -691,7 +723,9 @@ void MainWindow::OnImportMCFolder(wxCommandEvent& event)
 	Instance *inst = new StdInstance(instDirName);
 	inst->SetName(instName);
 	
-	auto task = new FileCopyTask(existingMCDir, inst->GetMCDir());
+	// The folder still belongs to another launcher, which may rewrite its files
+	// in place, so nothing is hard linked.
+	auto task = new FileCopyTask(existingMCDir, inst->GetMCDir(), FileCopyTask::COPY_CLONE);
 	StartTask(task);
 	delete task;
 	// FIXME: respond to errors in task.
@@ -749,7 +783,7 @@ void MainWindow::OnImportFTBClicked(wxCommandEvent& event)
 
 				// Copy the pack to its new instance folder.
 				FileCopyTask *copyTask = new FileCopyTask(
-					selDialog.GetSelectedFolder(), instDirName);
+					selDialog.GetSelectedFolder(), instDirName, FileCopyTask::COPY_CLONE);
 				StartTask(copyTask);
 				delete copyTask;
 				// FIXME: respond to errors in task.
@@ -1090,6 +1124,8 @@ void MainWindow::OnLoginComplete( const LoginResult& result )
 			}
 			if(GetGUIMode() == GUI_Fancy)
 				UpdateInstPanel();
+			// the jar version may have changed
+			instItems.InstanceInfoChanged(inst);
 		}
 		
 		if (inst->ShouldRebuild())
@@ -1221,7 +1257,8 @@ void MainWindow::OnCopyInstClicked(wxCommandEvent &event)
 
 	wxMkdir(instDirName);
 	// FIXME: respond to errors in task.
-	auto task = new FileCopyTask (currentInstance->GetRootDir().GetFullPath(), wxFileName::DirName(instDirName));
+	auto task = new FileCopyTask (currentInstance->GetRootDir().GetFullPath(), wxFileName::DirName(instDirName),
+		FileCopyTask::COPY_CLONE_LINK);
 	StartTask(task);
 	delete task;
 
@@ -1517,6 +1554,15 @@ void MainWindow::OnViewInstFolderClicked(wxCommandEvent& event)
 	Utils::OpenFolder(currentInstance->GetRootDir());
 }
 
+void MainWindow::OnViewLaunchLogsClicked(wxCommandEvent& event)
+{
+	auto currentInstance = instItems.GetSelectedInstance();
+	if(currentInstance == nullptr)
+		return;
+	LaunchLogDialog logDlg(this, currentInstance);
+	logDlg.ShowModal();
+}
+
 bool MainWindow::DeleteSelectedInstance()
 {
 	auto currentInstance = instItems.GetSelectedInstance();
@@ -1524,13 +1570,21 @@ bool MainWindow::DeleteSelectedInstance()
 		return false;
 
 	wxMessageDialog dlg(this, "Are you sure you want to delete this instance?\n"
-	                          "Deleted instances are lost FOREVER! (a really long time)",
+	                          "It can be restored from the Add instance menu for 15 minutes "
+	                          "or until MultiMC is closed, whichever comes first.",
 	                          "Confirm deletion.",
 	                          wxYES_NO | wxNO_DEFAULT | wxICON_QUESTION | wxCENTRE | wxSTAY_ON_TOP);
 	dlg.CenterOnParent();
 	if (dlg.ShowModal() == wxID_YES)
 	{
-		instItems.DeleteCurrent();
+		DeletedInstance deleted;
+		InstanceGroup *group = instItems.GetInstanceGroup(currentInstance);
+		if (group)
+			deleted.group = group->GetName();
+
+		instItems.DeleteCurrent(&deleted.trashID);
+		if (!deleted.trashID.IsEmpty())
+			deletedInstances.push_back(deleted);
 		
 		if(GetGUIMode() == GUI_Fancy)
 		{
@@ -1541,6 +1595,43 @@ bool MainWindow::DeleteSelectedInstance()
 	return false;
 }
 
+void MainWindow::OnRestoreInstClicked(wxCommandEvent& event)
+{
+	if (deletedInstances.empty())
+		return;
+
+	DeletedInstance deleted = deletedInstances.back();
+
+	wxString rootDir;
+	if (!Trash::Instance().Restore(deleted.trashID, &rootDir))
+	{
+		// Keep it if it's still in the trash, whatever is in the way may be moved.
+		if (Trash::Instance().Contains(deleted.trashID))
+		{
+			wxLogError(_("The instance can't be moved back to its folder right now."));
+			return;
+		}
+		deletedInstances.pop_back();
+		wxLogError(_("The instance can't be restored anymore."));
+		return;
+	}
+	deletedInstances.pop_back();
+
+	Instance *inst = Instance::LoadInstance(rootDir);
+	if (!inst)
+	{
+		wxLogError(_("The instance was restored to %s but couldn't be loaded."), rootDir.c_str());
+		return;
+	}
+
+	AddInstance(inst);
+	if (!deleted.group.IsEmpty())
+	{
+		instItems.SetInstanceGroup(inst, deleted.group);
+		instItems.SaveGroupInfo();
+	}
+}
+
 void MainWindow::OnInstDeleteKey ( InstanceCtrlEvent& event )
 {
 	DeleteSelectedInstance();
@@ -1603,7 +1694,11 @@ void MainWindow::OnTaskEnd(TaskEvent& event)
 
 	// Check the type of task.
 	const std::type_info& taskType = typeid(*t);
-	if (taskType == typeid(NewsCheckTask))
+	if (taskType == typeid(LoadInstancesTask))
+	{
+		OnInstanceListLoaded((LoadInstancesTask*) t);
+	}
+	else if (taskType == typeid(NewsCheckTask))
 	{
 		auto nTask = (NewsCheckTask*) t;
 
@@ -1636,6 +1731,17 @@ int MainWindow::StartTask ( Task* task )
 
 void MainWindow::OnWindowClosed(wxCloseEvent& event)
 {
+	// Don't let the instance loader post events to a dead window.
+	if (instLoadTask)
+	{
+		instLoadTask->Cancel();
+		instLoadTask->Wait();
+		// Its end event would be handled after it's gone, so drop it and delete the task here.
+		DeletePendingEvents();
+		delete instLoadTask;
+		instLoadTask = nullptr;
+	}
+
 	if(instNotesEditor)
 	{
 		// Save instance notes on exit.
@@ -1724,6 +1830,18 @@ void MainWindow::OnHideNewsClicked(wxCommandEvent& event)
 	newsPanel->Hide();
 }
 
+void MainWindow::OnSearchChanged(wxCommandEvent& event)
+{
+	if (instListCtrl)
+		instListCtrl->SetFilter(instSearch->GetValue());
+}
+
+void MainWindow::OnSearchCancelled(wxCommandEvent& event)
+{
+	// clearing the text sends a text event, which resets the filter
+	instSearch->Clear();
+}
+
 BEGIN_EVENT_TABLE(MainWindow, wxFrame)
 	EVT_TOOL(ID_AddInst, MainWindow::OnAddInstClicked)
 	EVT_TOOL(ID_ImportCP, MainWindow::OnImportCPClicked)
@@ -1744,6 +1862,7 @@ BEGIN_EVENT_TABLE(MainWindow, wxFrame)
 	EVT_MENU(ID_ImportInst, MainWindow::OnImportMCFolder)
 	EVT_MENU(ID_ImportCP, MainWindow::OnImportCPClicked)
 	EVT_MENU(ID_ImportFTB, MainWindow::OnImportFTBClicked)
+	EVT_MENU(ID_RestoreInst, MainWindow::OnRestoreInstClicked)
 
 	EVT_MENU(ID_Play, MainWindow::OnPlayMenuClicked)
 	
@@ -1760,6 +1879,7 @@ BEGIN_EVENT_TABLE(MainWindow, wxFrame)
 	EVT_MENU(ID_ChangeLWJGL, MainWindow::OnChangeLWJGLClicked)
 	EVT_MENU(ID_RebuildJar, MainWindow::OnRebuildJarClicked)
 	EVT_MENU(ID_ViewInstFolder, MainWindow::OnViewInstFolderClicked)
+	EVT_MENU(ID_ViewLaunchLogs, MainWindow::OnViewLaunchLogsClicked)
 
 	EVT_MENU(ID_DeleteInst, MainWindow::OnDeleteClicked)
 
@@ -1784,6 +1904,9 @@ BEGIN_EVENT_TABLE(MainWindow, wxFrame)
 
 	EVT_BUTTON(ID_HideNewsPanel, MainWindow::OnHideNewsClicked)
 	
+	EVT_TEXT(ID_SearchInst, MainWindow::OnSearchChanged)
+	EVT_SEARCHCTRL_CANCEL_BTN(ID_SearchInst, MainWindow::OnSearchCancelled)
+	
 	EVT_BUTTON(ID_DeleteInst, MainWindow::OnDeleteClicked)
 	
 	
@@ -1792,11 +1915,13 @@ BEGIN_EVENT_TABLE(MainWindow, wxFrame)
 	EVT_INST_RENAME(ID_InstListCtrl, MainWindow::OnInstRenameKey)
 	EVT_INST_MENU(ID_InstListCtrl, MainWindow::OnInstMenuOpened)
 	EVT_INST_ITEM_SELECTED(ID_InstListCtrl, MainWindow::OnInstSelected)
+	EVT_INST_ITEM_DESELECTED(ID_InstListCtrl, MainWindow::OnInstDeselected)
 	
 	EVT_TASK_END(MainWindow::OnTaskEnd)
 	EVT_TASK_ERRORMSG(MainWindow::OnTaskError)
 	
 	EVT_CHECK_UPDATE(MainWindow::OnCheckUpdateComplete)
+	EVT_INSTANCES_LOADED(MainWindow::OnInstancesLoaded)
 	
 	EVT_TEXT_ENTER(ID_InstNameEditor, MainWindow::OnRenameEnterPressed)
 
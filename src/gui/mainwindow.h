@@ -18,14 +18,17 @@
 #include <wx/wx.h>
 #include <wx/gbsizer.h>
 #include <wx/hyperlink.h>
+#include <wx/srchctrl.h>
 
 #include <queue>
+#include <vector>
 #include <functional>
 #include <map>
 
 #include "task.h"
 #include "logintask.h"
 #include "checkupdatetask.h"
+#include "loadinstancestask.h"
 
 #include "insticonlist.h"
 
@@ -49,6 +52,7 @@ public:
 	void OnAddInstClicked(wxCommandEvent& event);
 	void OnImportCPClicked(wxCommandEvent& event);
 	void OnImportFTBClicked(wxCommandEvent& event);
+	void OnRestoreInstClicked(wxCommandEvent& event);
 	void OnViewFolderClicked(wxCommandEvent& event);
 	void OnViewCMFolderClicked(wxCommandEvent& event);
 	void OnRefreshClicked(wxCommandEvent& event);
@@ -83,6 +87,7 @@ public:
 	void OnChangeLWJGLClicked(wxCommandEvent& event);
 	void OnRebuildJarClicked(wxCommandEvent& event);
 	void OnViewInstFolderClicked(wxCommandEvent& event);
+	void OnViewLaunchLogsClicked(wxCommandEvent& event);
 	
 	void OnDeleteClicked(wxCommandEvent& event);
 
@@ -97,12 +102,16 @@ public:
 	void OnTaskError(TaskErrorEvent &event);
 	void OnLoginComplete(const LoginResult &result);
 	void OnCheckUpdateComplete(CheckUpdateEvent &event);
+	void OnInstancesLoaded(InstancesLoadedEvent &event);
+	void OnInstanceListLoaded(LoadInstancesTask *task);
 	
 	// Other events
 	void OnInstMenuOpened(InstanceCtrlEvent& event);
 	void OnWindowClosed(wxCloseEvent& event);
 	void OnNotesLostFocus(wxFocusEvent& event);
 	void OnHideNewsClicked(wxCommandEvent& event);
+	void OnSearchChanged(wxCommandEvent& event);
+	void OnSearchCancelled(wxCommandEvent& event);
 
 	void OnExitApp(wxCommandEvent &event);
 	
@@ -203,6 +212,14 @@ public:
 protected:
 	wxMenu *instMenu;
 	wxMenu *groupMenu;
+
+	// Instances in the trash, the last deleted one at the back.
+	struct DeletedInstance
+	{
+		wxString trashID;
+		wxString group;
+	};
+	std::vector<DeletedInstance> deletedInstances;
 	
 	GUIMode m_guiMode;
 
@@ -231,6 +248,9 @@ protected:
 
 	// maps index in the used list control to an instance.
 	InstanceModel instItems;
+
+	// the task currently filling instItems, if any
+	LoadInstancesTask *instLoadTask;
 	
 	GUIMode GetGUIMode() const
 	{
@@ -242,11 +262,13 @@ protected:
 	void InitInstMenu();
 	
 	InstanceCtrl *instListCtrl;
+	wxSearchCtrl *instSearch;
 	
 	// Advanced GUI
 	void InitAdvancedGUI(wxBoxSizer *mainSz);
 	
 	void OnInstSelected(InstanceCtrlEvent &event);
+	void OnInstDeselected(InstanceCtrlEvent &event);
 
 	void UpdateInstPanel();
 	void UpdateInstNameLabel(Instance *inst);
@@ -306,6 +328,7 @@ enum
 	ID_ImportInst,
 	ID_ImportCP,
 	ID_ImportFTB,
+	ID_RestoreInst,
 	ID_ViewFolder,
 	ID_ViewCMFolder,
 	ID_ModsFolder,
@@ -337,6 +360,7 @@ enum
 	ID_ChangeLWJGL,
 	ID_RebuildJar,
 	ID_ViewInstFolder,
+	ID_ViewLaunchLogs,
 
 	ID_DeleteInst,
 
@@ -351,5 +375,6 @@ enum
 	ID_NotesCtrl,
 
 	ID_HideNewsPanel,
+	ID_SearchInst,
 };
 
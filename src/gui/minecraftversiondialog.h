@@ -34,6 +34,8 @@ protected:
 	void OnMCRewind(wxCommandEvent& event);
 	
 	// data
+	// keeps visibleIndexes and the selected version valid
+	MCVersionList::Holder holdList;
 	int typeColumnWidth;
 	std::vector<unsigned> visibleIndexes;
 	bool showOldSnapshots;
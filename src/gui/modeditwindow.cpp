@@ -212,6 +212,12 @@ ModEditWindow::ModEditWindow(MainWindow *parent, Instance *inst)
 	texturePackList->UpdateItems();
 }
 
+ModEditWindow::~ModEditWindow()
+{
+	// let the instance search see the new mods
+	m_inst->ModsChanged();
+}
+
 void ModEditWindow::LoadJarMods()
 {
 	jarModList->UpdateItems();
@@ -989,7 +995,7 @@ void ModEditWindow::CopyFiles(wxWindow *window, wxArrayString files, wxString de
 		}
 		else
 		{
-			wxCopyFile(*iter, dest.GetFullPath());
+			fsutils::LinkFile(*iter, dest.GetFullPath(), false);
 		}
 	}
 }
@@ -26,6 +26,7 @@ class ModEditWindow : public wxFrame
 {
 public:
 	ModEditWindow(MainWindow *parent, Instance *inst);
+	~ModEditWindow();
 	
 	virtual bool Show(bool show = true);
 	
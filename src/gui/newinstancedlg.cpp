@@ -104,7 +104,7 @@ int NewInstanceDialog::ShowModal()
 		LambdaTask::TaskFunc func = [&] (LambdaTask *task) -> wxThread::ExitCode
 		{
 			task->DoSetStatus(_("Loading version list..."));
-			return (wxThread::ExitCode) verList.LoadMojang();
+			return (wxThread::ExitCode) verList.LoadIfNeeded();
 		};
 
 		LambdaTask *lTask = new LambdaTask(func);
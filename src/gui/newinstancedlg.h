@@ -14,8 +14,8 @@
 #include <wx/button.h>
 #include <wx/dialog.h>
 #include <vector>
+#include "mcversionlist.h"
 
-class MCVersion;
 class ShadedTextEdit;
 ///////////////////////////////////////////////////////////////////////////
 
@@ -50,6 +50,8 @@ class NewInstanceDialog : public wxDialog
 		wxString m_name;
 		wxString m_username;
 		MCVersion * m_selectedVersion;
+		// keeps m_selectedVersion valid
+		MCVersionList::Holder m_holdVersions;
 		
 	protected:
 		void OnIcon(wxCommandEvent& event);
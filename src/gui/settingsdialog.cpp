@@ -262,6 +262,21 @@ SettingsDialog::SettingsDialog( wxWindow* parent, wxWindowID id, SettingsBase* s
 
 			networkSz->Add(box, staticBoxOuterFlags);
 		}
+
+		// Download settings box
+		{
+			auto box = new wxStaticBoxSizer(wxHORIZONTAL, networkPanel, _("Downloads"));
+
+			wxStaticText *dlConnectionsLabel = new wxStaticText(box->GetStaticBox(), 
+				-1, _("Simultaneous downloads:"));
+			box->Add(dlConnectionsLabel, itemsFlags);
+
+			dlConnectionsSpin = new wxSpinCtrl(box->GetStaticBox(), -1);
+			dlConnectionsSpin->SetRange(1, 16);
+			box->Add(dlConnectionsSpin, itemsFlags);
+
+			networkSz->Add(box, staticBoxOuterFlags);
+		}
 	}
 
 	// Console tab
@@ -278,6 +293,16 @@ SettingsDialog::SettingsDialog( wxWindow* parent, wxWindowID id, SettingsBase* s
 			box->Add(showConsoleCheck, itemFlags);
 			autoCloseConsoleCheck = new wxCheckBox(box->GetStaticBox(), -1, _("Automatically close console when the game quits."));
 			box->Add(autoCloseConsoleCheck, itemFlags);
+
+			auto maxLinesSz = new wxBoxSizer(wxHORIZONTAL);
+			wxStaticText *maxLinesLabel = new wxStaticText(box->GetStaticBox(), -1, 
+				_("Lines of scrollback to keep:"));
+			maxLinesSz->Add(maxLinesLabel, itemsFlags);
+			consoleMaxLinesSpin = new wxSpinCtrl(box->GetStaticBox(), -1);
+			consoleMaxLinesSpin->SetRange(1000, 1000000);
+			maxLinesSz->Add(consoleMaxLinesSpin, itemsFlags);
+			box->Add(maxLinesSz);
+
 			consoleSizer->Add(box, staticBoxOuterFlags);
 		}
 		// Console colors box
@@ -644,6 +669,7 @@ bool SettingsDialog::ApplySettings()
 		
 		currentSettings->SetShowConsole(showConsoleCheck->IsChecked());
 		currentSettings->SetAutoCloseConsole(autoCloseConsoleCheck->IsChecked());
+		currentSettings->SetConsoleMaxLines(consoleMaxLinesSpin->GetValue());
 		
 		currentSettings->SetAutoUpdate(autoUpdateCheck->IsChecked());
 		
@@ -724,6 +750,8 @@ Are you sure you want to use dev builds?"),
 
 		currentSettings->SetProxyUsername(proxyUserTextbox->GetValue());
 		currentSettings->SetProxyPassword(proxyPassTextbox->GetValue());
+
+		currentSettings->SetMaxDownloadConnections(dlConnectionsSpin->GetValue());
 	}
 	else
 	{
@@ -815,6 +843,7 @@ void SettingsDialog::LoadSettings()
 	{
 		showConsoleCheck->SetValue(currentSettings->GetShowConsole());
 		autoCloseConsoleCheck->SetValue(currentSettings->GetAutoCloseConsole());
+		consoleMaxLinesSpin->SetValue(currentSettings->GetConsoleMaxLines());
 
 		useDevBuildsCheck->SetValue(currentSettings->GetUseDevBuilds());
 		autoUpdateCheck->SetValue(currentSettings->GetAutoUpdate());
@@ -893,6 +922,8 @@ void SettingsDialog::LoadSettings()
 
 		proxyUserTextbox->SetValue(currentSettings->GetProxyUsername());
 		proxyPassTextbox->SetValue(currentSettings->GetProxyPassword());
+
+		dlConnectionsSpin->SetValue(currentSettings->GetMaxDownloadConnections());
 	}
 	else
 	{
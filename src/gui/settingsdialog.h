@@ -52,6 +52,7 @@ protected:
 	// console tab stuff
 	wxCheckBox *showConsoleCheck;
 	wxCheckBox *autoCloseConsoleCheck;
+	wxSpinCtrl *consoleMaxLinesSpin;
 	wxColourPickerCtrl *sysMsgColorCtrl;
 	wxColourPickerCtrl *stdoutColorCtrl;
 	wxColourPickerCtrl *stderrColorCtrl;
@@ -111,6 +112,8 @@ protected:
 
 	long proxyPortValue;
 
+	wxSpinCtrl *dlConnectionsSpin;
+
 
 	// Other stuff
 	bool m_shouldRestartMMC;
@@ -2,6 +2,9 @@
 #include "annotations.h"
 #include <sstream>
 
+// Nesting limit for annotation values, so broken classes can't blow the stack.
+const int max_element_depth = 64;
+
 namespace java
 {
 	std::string annotation::toString()
@@ -18,29 +21,40 @@ namespace java
 		return ss.str();
 	}
 
-	annotation * annotation::read (util::membuffer& input, constant_pool& pool)
+	annotation * annotation::read (util::membuffer& input, constant_pool& pool, int depth)
 	{
 		uint16_t type_index = 0;
-		input.read_be(type_index);
+		uint16_t num_pairs = 0;
+		input.require(4);
+		input.read_be_unchecked(type_index);
+		input.read_be_unchecked(num_pairs);
 		annotation * ann = new annotation(type_index,pool);
 		
-		uint16_t num_pairs = 0;
-		input.read_be(num_pairs);
-		while(num_pairs)
+		try
 		{
-			uint16_t name_idx = 0;
-			// read name index
-			input.read_be(name_idx);
-			auto elem = element_value::readElementValue(input,pool);
-			// read value
-			ann->add_pair(name_idx, elem);
-			num_pairs --;
+			while(num_pairs)
+			{
+				uint16_t name_idx = 0;
+				// read name index
+				input.read_be(name_idx);
+				auto elem = element_value::readElementValue(input,pool,depth + 1);
+				// read value
+				ann->add_pair(name_idx, elem);
+				num_pairs --;
+			}
+		}
+		catch(classfile_exception *)
+		{
+			delete ann;
+			throw;
 		}
 		return ann;
 	}
 	
-	element_value* element_value::readElementValue ( util::membuffer& input, java::constant_pool& pool )
+	element_value* element_value::readElementValue ( util::membuffer& input, java::constant_pool& pool, int depth )
 	{
+		if (depth > max_element_depth)
+			throw new java::classfile_exception();
 		element_value_type type = INVALID;
 		input.read(type);
 		uint16_t index = 0;
@@ -60,20 +74,30 @@ namespace java
 			input.read_be(index);
 			return new element_value_simple(type, index, pool);
 		case ENUM_CONSTANT:
-			input.read_be(index);
-			input.read_be(index2);
+			input.require(4);
+			input.read_be_unchecked(index);
+			input.read_be_unchecked(index2);
 			return new element_value_enum(type, index, index2, pool);
 		case CLASS: // Class
 			input.read_be(index);
 			return new element_value_class(type, index, pool);
 		case ANNOTATION: // Annotation
 			// FIXME: runtime visibility info needs to be passed from parent
-			return new element_value_annotation(ANNOTATION, annotation::read(input, pool), pool);
+			return new element_value_annotation(ANNOTATION, annotation::read(input, pool, depth), pool);
 		case ARRAY: // Array
 			input.read_be(index);
-			for (int i = 0; i < index; i++)
+			try
+			{
+				for (int i = 0; i < index; i++)
+				{
+					vals.push_back(element_value::readElementValue(input, pool, depth + 1));
+				}
+			}
+			catch(classfile_exception *)
 			{
-				vals.push_back(element_value::readElementValue(input, pool));
+				for (unsigned i = 0; i < vals.size(); i++)
+					delete vals[i];
+				throw;
 			}
 			return new element_value_array(ARRAY, vals, pool);
 		default:
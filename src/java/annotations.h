@@ -40,6 +40,7 @@ namespace java
 
 	public:
 		element_value(element_value_type type, constant_pool & pool): type(type), pool(pool) {};
+		virtual ~element_value() {};
 
 		element_value_type getElementValueType()
 		{
@@ -48,7 +49,7 @@ namespace java
 		
 		virtual std::string toString() = 0;
 
-		static element_value * readElementValue(util::membuffer & input, constant_pool & pool);
+		static element_value * readElementValue(util::membuffer & input, constant_pool & pool, int depth = 0);
 	};
 	
 	/**
@@ -102,7 +103,7 @@ namespace java
 			return name_val_pairs.cend();
 		}
 		std::string toString();
-		static annotation * read(util::membuffer & input, constant_pool & pool);
+		static annotation * read(util::membuffer & input, constant_pool & pool, int depth = 0);
 	};
 	typedef std::vector<annotation *> annotation_table;
 	
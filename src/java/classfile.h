@@ -11,27 +11,30 @@ namespace java
 	class classfile : public util::membuffer
 	{
 	public:
-		classfile(char * data, std::size_t size) : membuffer(data, size)
+		classfile(const char * data, std::size_t size) : membuffer(data, size)
 		{
 			valid = false;
 			is_synthetic = false;
-			read_be(magic);
+			require(8);
+			read_be_unchecked(magic);
 			if(magic != 0xCAFEBABE)
 				throw new classfile_exception();
-			read_be(minor_version);
-			read_be(major_version);
+			read_be_unchecked(minor_version);
+			read_be_unchecked(major_version);
 			constants.load(*this);
-			read_be(access_flags);
-			read_be(this_class);
-			read_be(super_class);
+			require(8);
+			read_be_unchecked(access_flags);
+			read_be_unchecked(this_class);
+			read_be_unchecked(super_class);
 			
 			// Interfaces
 			uint16_t iface_count = 0;
-			read_be(iface_count);
+			read_be_unchecked(iface_count);
+			require(iface_count * 2);
 			while (iface_count)
 			{
 				uint16_t iface;
-				read_be(iface);
+				read_be_unchecked(iface);
 				interfaces.push_back(iface);
 				iface_count --;
 			}
@@ -54,18 +57,12 @@ namespace java
 			while (field_count)
 			{
 				// skip field stuff
-				skip(6);
+				require(8);
+				skip_unchecked(6);
 				// and skip field attributes
 				uint16_t attr_count = 0;
-				read_be(attr_count);
-				while(attr_count)
-				{
-					skip(2);
-					uint32_t attr_length = 0;
-					read_be(attr_length);
-					skip(attr_length);
-					attr_count --;
-				}
+				read_be_unchecked(attr_count);
+				skip_attributes(attr_count);
 				field_count --;
 			}
 
@@ -84,18 +81,12 @@ namespace java
 			read_be(method_count);
 			while( method_count )
 			{
-				skip(6);
+				require(8);
+				skip_unchecked(6);
 				// and skip method attributes
 				uint16_t attr_count = 0;
-				read_be(attr_count);
-				while(attr_count)
-				{
-					skip(2);
-					uint32_t attr_length = 0;
-					read_be(attr_length);
-					skip(attr_length);
-					attr_count --;
-				}
+				read_be_unchecked(attr_count);
+				skip_attributes(attr_count);
 				method_count --;
 			}
 
@@ -113,29 +104,44 @@ namespace java
 			 */
 			uint16_t class_attr_count = 0;
 			read_be(class_attr_count);
-			while(class_attr_count)
+			try
 			{
-				uint16_t name_idx = 0;
-				read_be(name_idx);
-				uint32_t attr_length = 0;
-				read_be(attr_length);
-				
-				auto name = constants[name_idx];
-				if(name.str_data == "RuntimeVisibleAnnotations")
+				while(class_attr_count)
 				{
-					uint16_t num_annotations = 0;
-					read_be(num_annotations);
-					while (num_annotations)
+					uint16_t name_idx = 0;
+					uint32_t attr_length = 0;
+					require(6);
+					read_be_unchecked(name_idx);
+					read_be_unchecked(attr_length);
+					require(attr_length);
+					
+					auto name = constants[name_idx];
+					if(name.str_data == "RuntimeVisibleAnnotations")
 					{
-						visible_class_annotations.push_back(annotation::read(*this, constants));
-						num_annotations --;
+						uint16_t num_annotations = 0;
+						read_be(num_annotations);
+						while (num_annotations)
+						{
+							visible_class_annotations.push_back(annotation::read(*this, constants));
+							num_annotations --;
+						}
 					}
+					else skip(attr_length);
+					class_attr_count --;
 				}
-				else skip(attr_length);
-				class_attr_count --;
+			}
+			catch(classfile_exception *)
+			{
+				// the destructor doesn't run if the constructor throws
+				free_annotations();
+				throw;
 			}
 			valid = true;
 		};
+		~classfile()
+		{
+			free_annotations();
+		}
 		bool valid;
 		bool is_synthetic;
 		uint32_t magic;
@@ -147,7 +153,44 @@ namespace java
 		uint16_t super_class;
 		// interfaces this class implements ? must be. investigate.
 		std::vector<uint16_t> interfaces;
-		// FIXME: doesn't free up memory on delete
 		java::annotation_table visible_class_annotations;
+	private:
+		void free_annotations()
+		{
+			for(unsigned i = 0; i < visible_class_annotations.size(); i++)
+				delete visible_class_annotations[i];
+			visible_class_annotations.clear();
+		}
+		void skip_attributes(uint16_t attr_count)
+		{
+			while(attr_count)
+			{
+				uint32_t attr_length = 0;
+				require(6);
+				skip_unchecked(2);
+				read_be_unchecked(attr_length);
+				skip(attr_length);
+				attr_count --;
+			}
+		}
 	};
-}
\ No newline at end of file
+
+	/**
+	 * Look through the constants of a class file without parsing the rest of it.
+	 * visit is called for every constant and can return true to stop early.
+	 * Returns true if it was stopped.
+	 */
+	template <class F>
+	bool scan_constants(const char * data, std::size_t size, F visit)
+	{
+		util::membuffer buf(data, size);
+		uint32_t magic = 0;
+		buf.require(8);
+		buf.read_be_unchecked(magic);
+		if(magic != 0xCAFEBABE)
+			throw new classfile_exception();
+		// minor and major version
+		buf.skip_unchecked(4);
+		return constant_pool::scan(buf, visit);
+	}
+}
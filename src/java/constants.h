@@ -46,8 +46,9 @@ namespace java
 				case j_fieldref:
 				case j_methodref:
 				case j_interface_methodref:
-					buf.read_be(ref_type.class_idx);
-					buf.read_be(ref_type.name_and_type_idx);
+					buf.require(4);
+					buf.read_be_unchecked(ref_type.class_idx);
+					buf.read_be_unchecked(ref_type.name_and_type_idx);
 					break;
 				case j_string:
 					buf.read_be(index);
@@ -61,8 +62,9 @@ namespace java
 					buf.read_jstr(str_data);
 					break;
 				case j_nameandtype:
-					buf.read_be(name_and_type.name_index);
-					buf.read_be(name_and_type.descriptor_index);
+					buf.require(4);
+					buf.read_be_unchecked(name_and_type.name_index);
+					buf.read_be_unchecked(name_and_type.descriptor_index);
 					break;
 			}
 		}
@@ -115,7 +117,8 @@ namespace java
 			return ss.str();
 		}
 
-		std::string str_data; /** String data in 'modified utf-8'.*/
+		/// String data in 'modified utf-8'. Points into the class file buffer.
+		util::strview str_data;
 		// store everything here.
 		union
 		{
@@ -158,29 +161,43 @@ namespace java
 		 */
 		void load(util::membuffer & buf)
 		{
-			uint16_t length = 0;
-			buf.read_be(length);
-			length --;
-			uint16_t index = 1;
-			const constant * last_constant = nullptr;
-			while(length)
+			scan(buf, [this](const constant & cnst) -> bool
 			{
-				const constant & cnst = constant(buf);
 				constants.push_back(cnst);
-				last_constant = &constants[constants.size() - 1];
-				if(last_constant->type == constant::j_double || last_constant->type == constant::j_long)
+				if(cnst.type == constant::j_double || cnst.type == constant::j_long)
 				{
 					// push in a fake constant to preserve indexing
 					constants.push_back(constant(0));
-					length-=2;
-					index+=2;
 				}
+				return false;
+			});
+		};
+		/**
+		 * Walk a java constant pool without storing it.
+		 * visit is called for every constant and can return true to stop early.
+		 * Returns true if it was stopped.
+		 */
+		template <class F>
+		static bool scan(util::membuffer & buf, F visit)
+		{
+			uint16_t length = 0;
+			buf.read_be(length);
+			// the count is one more than the number of slots
+			if(length == 0)
+				throw new classfile_exception();
+			length --;
+			while(length)
+			{
+				const constant cnst(buf);
+				if(visit(cnst))
+					return true;
+				// longs and doubles take up two slots
+				if(cnst.type == constant::j_double || cnst.type == constant::j_long)
+					length -= length > 1 ? 2 : 1;
 				else
-				{
 					length--;
-					index++;
-				}
 			}
+			return false;
 		};
 		typedef std::vector<java::constant> container_type;
 		/**
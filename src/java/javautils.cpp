@@ -3,6 +3,7 @@
 #include "javautils.h"
 #include <wx/zipstrm.h>
 #include <memory>
+#include <vector>
 #include <wx/wfstream.h>
 #include "mcversionlist.h"
 
@@ -34,33 +35,27 @@ wxString GetMinecraftJarVersion(wxFileName jar)
 	
 	// we got the entry, read the data
 	std::size_t size = myentry->GetSize();
-	char *classdata = new char[size];
-	zipIn.Read(classdata,size);
+	std::vector<char> classdata(size);
+	if (size == 0 || zipIn.Read(&classdata[0], size).LastRead() != size)
+		return version;
+
+	// Only the constant pool is needed. Stop as soon as the version string shows up.
+	const char * lookfor = "Minecraft Minecraft "; // length = 20
 	try
 	{
-		char * temp = classdata;
-		java::classfile Minecraft_jar(temp,size);
-		auto cnst = Minecraft_jar.constants;
-		auto iter = cnst.begin();
-		while (iter != cnst.end())
+		java::scan_constants(&classdata[0], size, [&](const java::constant & constant) -> bool
 		{
-			const java::constant & constant = *iter;
-			if(constant.type != java::constant::j_string_data)
-			{
-				iter++;
-				continue;
-			}
-			auto & str = constant.str_data;
-			const char * lookfor = "Minecraft Minecraft "; // length = 20
-			if(str.compare(0,20,lookfor) == 0)
-			{
-				version = str.substr(20).data();
-				break;
-			}
-			iter++;
-		}
-	} catch(java::classfile_exception &){}
-	delete[] classdata;
+			if(constant.type != java::constant::j_string_data || !constant.str_data.starts_with(lookfor))
+				return false;
+			util::strview str = constant.str_data.substr(20);
+			version = wxString(str.data(), wxConvUTF8, str.size());
+			return true;
+		});
+	}
+	catch(java::classfile_exception * e)
+	{
+		delete e;
+	}
 	return version;
 }
 }
\ No newline at end of file
@@ -2,15 +2,21 @@
 #include <stdint.h>
 #include <string>
 #include <vector>
-#include <exception>
+#include <cstring>
 #include "endian.h"
+#include "errors.h"
+#include "strview.h"
 
 namespace util
 {
 	class membuffer
 	{
 	public:
-		membuffer(char * buffer, std::size_t size)
+		/**
+			* The buffer is not copied and has to outlive the membuffer
+			* and any string views read from it.
+			*/
+		membuffer(const char * buffer, std::size_t size)
 		{
 			current = start = buffer;
 			end = start + size;
@@ -20,14 +26,27 @@ namespace util
 			// maybe? possibly? left out to avoid confusion. for now.
 			//delete start;
 		}
+		/**
+			* Make sure there are at least N more bytes to read.
+			* Call this once for a whole structure and then use the unchecked reads below.
+			*/
+		void require(std::size_t N) const
+		{
+			if (N > remaining())
+				throw new java::classfile_exception();
+		}
+		std::size_t remaining() const
+		{
+			return end - current;
+		}
 		/**
 			* Read some value. That's all ;)
 			*/
 		template <class T>
 		void read(T& val)
 		{
-			val = *(T *)current;
-			current += sizeof(T);
+			require(sizeof(T));
+			read_unchecked(val);
 		}
 		/**
 			* Read a big-endian number
@@ -36,29 +55,59 @@ namespace util
 		template <class T>
 		void read_be(T& val)
 		{
-			val = util::bigswap(*(T *)current);
+			require(sizeof(T));
+			read_be_unchecked(val);
+		}
+		/**
+			* Same as above, without the bounds check. Only use these after require().
+			*/
+		template <class T>
+		void read_unchecked(T& val)
+		{
+			memcpy(&val, current, sizeof(T));
 			current += sizeof(T);
 		}
+		template <class T>
+		void read_be_unchecked(T& val)
+		{
+			read_unchecked(val);
+			val = util::bigswap(val);
+		}
 		/**
 			* Read a string in the format:
 			* 2B length (big endian, unsigned)
 			* length bytes data
 			*/
 		void read_jstr(std::string & str)
+		{
+			strview view;
+			read_jstr(view);
+			str.append(view.data(), view.size());
+		}
+		/**
+			* Same as above, but without copying the data.
+			*/
+		void read_jstr(strview & str)
 		{
 			uint16_t length = 0;
 			read_be(length);
-			str.append(current,length);
+			require(length);
+			str = strview(current, length);
 			current += length;
 		}
 		/**
 			* Skip N bytes
 			*/
 		void skip (std::size_t N)
+		{
+			require(N);
+			current += N;
+		}
+		void skip_unchecked (std::size_t N)
 		{
 			current += N;
 		}
 	private:
-		char * start, *end, *current;
+		const char * start, *end, *current;
 	};
 }
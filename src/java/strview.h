@@ -0,0 +1,62 @@
+#pragma once
+#include <cstring>
+#include <string>
+#include <ostream>
+
+namespace util
+{
+	/**
+	 * A non-owning view of a string inside some other buffer.
+	 * The buffer has to outlive the view.
+	 */
+	class strview
+	{
+	public:
+		strview() : ptr(nullptr), len(0) {}
+		strview(const char * data, std::size_t length) : ptr(data), len(length) {}
+
+		const char * data() const
+		{
+			return ptr;
+		}
+		std::size_t size() const
+		{
+			return len;
+		}
+		bool empty() const
+		{
+			return len == 0;
+		}
+		bool starts_with(const char * prefix) const
+		{
+			std::size_t plen = strlen(prefix);
+			return plen <= len && memcmp(ptr, prefix, plen) == 0;
+		}
+		strview substr(std::size_t pos) const
+		{
+			if (pos >= len)
+				return strview();
+			return strview(ptr + pos, len - pos);
+		}
+		std::string str() const
+		{
+			return std::string(ptr, len);
+		}
+		bool operator==(const char * other) const
+		{
+			return strlen(other) == len && memcmp(ptr, other, len) == 0;
+		}
+		bool operator!=(const char * other) const
+		{
+			return !(*this == other);
+		}
+	private:
+		const char * ptr;
+		std::size_t len;
+	};
+
+	inline std::ostream & operator<<(std::ostream & out, const strview & str)
+	{
+		return out.write(str.data(), str.size());
+	}
+}
@@ -3,33 +3,242 @@
 #include "annotations.h"
 #include <fstream>
 #include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <algorithm>
 
-int main(int argc, char* argv[])
+/*
+ * classtest <file.class>
+ *     Dump the class annotations.
+ * classtest --bench [-n iterations] <file.class>...
+ *     Parse the corpus over and over and report the speed in MB/s.
+ * classtest --fuzz [-n iterations] [-s seed] <file.class>...
+ *     Parse randomly damaged copies of the corpus. Broken classes have to
+ *     fail with a classfile_exception, anything else is a bug.
+ *
+ * Build with -DCLASSTEST_LIBFUZZER to get a libFuzzer entry point instead.
+ */
+
+typedef std::vector<char> filedata;
+
+static bool read_file(const char * path, filedata & data)
+{
+	std::ifstream file_in(path, std::ios::binary);
+	if(!file_in.is_open())
+		return false;
+	file_in.seekg(0, std::ios::end);
+	auto length = file_in.tellg();
+	file_in.seekg(0);
+	data.resize(length);
+	if(length > 0)
+		file_in.read(&data[0], length);
+	return file_in.good();
+}
+
+// Parse a class file the way MultiMC does. Returns false if it was rejected.
+static bool parse(const char * data, std::size_t size)
+{
+	try
+	{
+		java::classfile cf (data, size);
+		java::scan_constants(data, size, [](const java::constant &) -> bool
+		{
+			return false;
+		});
+		return cf.valid;
+	}
+	catch(java::classfile_exception * e)
+	{
+		delete e;
+		return false;
+	}
+}
+
+#ifdef CLASSTEST_LIBFUZZER
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t * data, std::size_t size)
+{
+	// copy so reads past the end are caught by the sanitizers
+	filedata copy(data, data + size);
+	parse(copy.empty() ? nullptr : &copy[0], copy.size());
+	return 0;
+}
+#else
+
+static int dump(const char * path)
+{
+	filedata data;
+	if(!read_file(path, data))
+	{
+		std::cerr << "Failed to open file : " << path << std::endl;
+		return 1;
+	}
+	try
+	{
+		java::classfile cf (&data[0], data.size());
+		java::annotation_table atable = cf.visible_class_annotations;
+		for(unsigned i = 0; i < atable.size(); i++)
+		{
+			std::cout << atable[i]->toString() << std::endl;
+		}
+	}
+	catch(java::classfile_exception * e)
+	{
+		delete e;
+		std::cerr << "Not a valid class file : " << path << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+static bool load_corpus(const std::vector<std::string> & paths, std::vector<filedata> & corpus)
+{
+	for(unsigned i = 0; i < paths.size(); i++)
+	{
+		filedata data;
+		if(!read_file(paths[i].c_str(), data))
+		{
+			std::cerr << "Failed to open file : " << paths[i] << std::endl;
+			return false;
+		}
+		corpus.push_back(data);
+	}
+	if(corpus.empty())
+	{
+		std::cerr << "No class files given." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+static int bench(const std::vector<filedata> & corpus, long iterations)
 {
-	if(argc > 1)
+	std::size_t total = 0;
+	for(unsigned i = 0; i < corpus.size(); i++)
+		total += corpus[i].size();
+
+	typedef std::chrono::high_resolution_clock clock;
+	auto run = [&](const char * name, bool (*fn)(const char *, std::size_t))
 	{
-		std::ifstream file_in(argv[1]);
-		if(file_in.is_open())
+		long failed = 0;
+		auto begin = clock::now();
+		for(long n = 0; n < iterations; n++)
 		{
-			file_in.seekg(0, std::_S_end);
-			auto length = file_in.tellg();
-			char * data = new char[length];
-			file_in.seekg(0);
-			file_in.read(data,length);
-			java::classfile cf (data, length);
-			java::annotation_table atable = cf.visible_class_annotations;
-			for(int i = 0; i < atable.size(); i++)
+			for(unsigned i = 0; i < corpus.size(); i++)
 			{
-				std::cout << atable[i]->toString() << std::endl;
+				if(corpus[i].empty() || !fn(&corpus[i][0], corpus[i].size()))
+					failed++;
 			}
-			return 0;
 		}
-		else
+		double secs = std::chrono::duration<double>(clock::now() - begin).count();
+		double mb = (double)total * iterations / (1024 * 1024);
+		std::cout << name << ": " << mb << " MB in " << secs << " s, " 
+			<< (secs > 0 ? mb / secs : 0) << " MB/s";
+		if(failed)
+			std::cout << " (" << failed / iterations << " invalid files)";
+		std::cout << std::endl;
+	};
+
+	std::cout << corpus.size() << " files, " << total << " bytes, " << iterations << " iterations" << std::endl;
+	run("full parse", [](const char * data, std::size_t size) -> bool
+	{
+		try
+		{
+			java::classfile cf (data, size);
+			return cf.valid;
+		}
+		catch(java::classfile_exception * e)
+		{
+			delete e;
+			return false;
+		}
+	});
+	run("constant scan", [](const char * data, std::size_t size) -> bool
+	{
+		try
+		{
+			java::scan_constants(data, size, [](const java::constant &) -> bool
+			{
+				return false;
+			});
+			return true;
+		}
+		catch(java::classfile_exception * e)
 		{
-			std::cerr << "Failed to open file : " << argv[1] << std::endl;
-			return 1;
+			delete e;
+			return false;
 		}
+	});
+	return 0;
+}
+
+static int fuzz(const std::vector<filedata> & corpus, long iterations, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	long rejected = 0;
+	for(long n = 0; n < iterations; n++)
+	{
+		filedata data = corpus[rng() % corpus.size()];
+		int mutations = 1 + rng() % 8;
+		for(int m = 0; m < mutations && !data.empty(); m++)
+		{
+			std::size_t pos = rng() % data.size();
+			switch(rng() % 4)
+			{
+			case 0: // flip a bit
+				data[pos] ^= 1 << (rng() % 8);
+				break;
+			case 1: // random byte
+				data[pos] = (char)rng();
+				break;
+			case 2: // huge length or count
+				data[pos] = (char)0xFF;
+				break;
+			case 3: // truncate
+				data.resize(pos);
+				break;
+			}
+		}
+		if(!parse(data.empty() ? nullptr : &data[0], data.size()))
+			rejected++;
 	}
-	std::cerr << "No file to open :(" << std::endl;
-	return 1;
-}
\ No newline at end of file
+	std::cout << iterations << " runs, seed " << seed << ", " << rejected << " rejected, no crashes" << std::endl;
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc < 2)
+	{
+		std::cerr << "No file to open :(" << std::endl;
+		return 1;
+	}
+
+	std::string mode = argv[1];
+	if(mode != "--bench" && mode != "--fuzz")
+		return dump(argv[1]);
+
+	long iterations = mode == "--bench" ? 100 : 100000;
+	unsigned seed = std::random_device()();
+	std::vector<std::string> paths;
+	for(int i = 2; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if(arg == "-n" && i + 1 < argc)
+			iterations = std::max(1L, atol(argv[++i]));
+		else if(arg == "-s" && i + 1 < argc)
+			seed = strtoul(argv[++i], nullptr, 10);
+		else
+			paths.push_back(arg);
+	}
+
+	std::vector<filedata> corpus;
+	if(!load_corpus(paths, corpus))
+		return 1;
+	if(mode == "--bench")
+		return bench(corpus, iterations);
+	return fuzz(corpus, iterations, seed);
+}
+#endif
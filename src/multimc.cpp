@@ -36,6 +36,7 @@
 #include "filedownloadtask.h"
 
 #include "taskprogressdialog.h"
+#include "trash.h"
 
 #ifdef wx29
 #include <wx/persist/toplevel.h>
@@ -149,6 +150,9 @@ bool MultiMC::OnInit()
 		settings->GetModsDir().Mkdir();
 	if (!settings->GetLwjglDir().DirExists())
 		settings->GetLwjglDir().Mkdir();
+
+	if (startMode != START_INSTALL_UPDATE)
+		Trash::Instance().Start();
 	
 	switch (startMode)
 	{
@@ -374,6 +378,7 @@ int MultiMC::OnExit()
 		proc.Detach();
 	}
 
+	Trash::Instance().Shutdown();
 	delete settings;
 	
 	return wxApp::OnExit();
@@ -32,14 +32,12 @@
 #endif
 
 #ifdef _WIN32
-	#include <sys/types.h>
-	#define ssize_t size_t
+	#include <windows.h>
 #else
 	#include <unistd.h>
-#endif
-
-#if defined __APPLE__ && defined __MACH__
-	typedef unsigned char u_char;
+	#include <pthread.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
 #endif
 
 #include "bzlib.h"
@@ -49,9 +47,18 @@
 #include <string.h>
 #include <fcntl.h>
 
-static off_t offtin(u_char *buf)
+typedef long long bs_off;
+
+/* Decoded bytes buffered for each of the three streams. Together with the
+   bzip2 decoder state this bounds the memory used, whatever the file size. */
+#define PIPE_SIZE (1024 * 1024)
+
+/* Bytes decoded or written at a time. */
+#define CHUNK_SIZE (256 * 1024)
+
+static bs_off offtin(const unsigned char *buf)
 {
-	off_t y;
+	bs_off y;
 
 	y=buf[7]&0x7F;
 	y=y*256;y+=buf[6];
@@ -67,28 +74,376 @@ static off_t offtin(u_char *buf)
 	return y;
 }
 
-int bspatch(const char * oldfile, const char * newfile, const char * patchfile)
+/*
+ * One of the bzip2 streams in the patch, decompressed on its own thread into
+ * a ring buffer that the patch loop reads from.
+ */
+typedef struct
 {
-	FILE * f, * cpf, * dpf, * epf;
-	BZFILE * cpfbz2, * dpfbz2, * epfbz2;
-	int cbz2err, dbz2err, ebz2err;
-	FILE * temp;
-	ssize_t oldsize,newsize;
-	ssize_t bzctrllen,bzdatalen;
-	unsigned char header[32],buf[8];
-	unsigned char *old_contents;
-	unsigned char *new_contents;
-	off_t oldpos,newpos;
-	off_t ctrl[3];
-	off_t lenread;
-	off_t i;
-
-	/* Open patch file */
-	if ((f = fopen(patchfile, "rb")) == NULL)
+	FILE *file;
+	BZFILE *bz;
+	unsigned char *buf;
+
+	/* Ring buffer state, protected by lock. */
+	size_t start;
+	size_t used;
+	int eof;
+	int error;
+	int cancelled;
+
+	int syncInit;
+	int threadStarted;
+#ifdef _WIN32
+	CRITICAL_SECTION lock;
+	/* Auto-reset event, set whenever the state changes. Only one side can be
+	   waiting at a time, either for data or for space. */
+	HANDLE changed;
+	HANDLE thread;
+#else
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+	pthread_t thread;
+#endif
+} bz_pipe;
+
+static void pipe_lock(bz_pipe *p)
+{
+#ifdef _WIN32
+	EnterCriticalSection(&p->lock);
+#else
+	pthread_mutex_lock(&p->lock);
+#endif
+}
+
+static void pipe_unlock(bz_pipe *p)
+{
+#ifdef _WIN32
+	LeaveCriticalSection(&p->lock);
+#else
+	pthread_mutex_unlock(&p->lock);
+#endif
+}
+
+/* Call with the lock held. */
+static void pipe_wait(bz_pipe *p)
+{
+#ifdef _WIN32
+	LeaveCriticalSection(&p->lock);
+	WaitForSingleObject(p->changed, INFINITE);
+	EnterCriticalSection(&p->lock);
+#else
+	pthread_cond_wait(&p->changed, &p->lock);
+#endif
+}
+
+/* Call with the lock held. */
+static void pipe_notify(bz_pipe *p)
+{
+#ifdef _WIN32
+	SetEvent(p->changed);
+#else
+	pthread_cond_signal(&p->changed);
+#endif
+}
+
+/* Runs on the pipe's thread until the stream ends or the reader gives up. */
+static void pipe_produce(bz_pipe *p)
+{
+	int bzerr = BZ_OK;
+	size_t end, space;
+	int n;
+
+	pipe_lock(p);
+	while (!p->cancelled)
 	{
-		//err(1, "fopen(%s)", argv[3]);
-		return ERR_OTHER;
+		if (p->used == PIPE_SIZE)
+		{
+			pipe_wait(p);
+			continue;
+		}
+
+		/* Decode straight into the free space up to the end of the ring. The
+		   reader never looks past start + used, so this is done unlocked. */
+		end = (p->start + p->used) % PIPE_SIZE;
+		space = end >= p->start ? PIPE_SIZE - end : p->start - end;
+		if (space > CHUNK_SIZE)
+			space = CHUNK_SIZE;
+
+		pipe_unlock(p);
+		n = BZ2_bzRead(&bzerr, p->bz, p->buf + end, (int)space);
+		pipe_lock(p);
+
+		if (n > 0)
+		{
+			p->used += n;
+			pipe_notify(p);
+		}
+		if (bzerr != BZ_OK)
+		{
+			if (bzerr != BZ_STREAM_END)
+				p->error = 1;
+			break;
+		}
+	}
+	p->eof = 1;
+	pipe_notify(p);
+	pipe_unlock(p);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI pipe_thread(LPVOID arg)
+{
+	pipe_produce((bz_pipe *)arg);
+	return 0;
+}
+#else
+static void *pipe_thread(void *arg)
+{
+	pipe_produce((bz_pipe *)arg);
+	return NULL;
+}
+#endif
+
+/* Reads exactly len decoded bytes. Returns 0 if the stream ends before that. */
+static int pipe_read(bz_pipe *p, unsigned char *dest, size_t len)
+{
+	size_t n;
+
+	pipe_lock(p);
+	while (len > 0)
+	{
+		if (p->used == 0)
+		{
+			if (p->eof)
+				break;
+			pipe_wait(p);
+			continue;
+		}
+
+		n = p->used;
+		if (n > len)
+			n = len;
+		if (n > PIPE_SIZE - p->start)
+			n = PIPE_SIZE - p->start;
+
+		/* The writer doesn't touch buffered bytes, so copy them unlocked. */
+		pipe_unlock(p);
+		memcpy(dest, p->buf + p->start, n);
+		pipe_lock(p);
+
+		p->start = (p->start + n) % PIPE_SIZE;
+		p->used -= n;
+		dest += n;
+		len -= n;
+		pipe_notify(p);
+	}
+	pipe_unlock(p);
+	return len == 0;
+}
+
+/* Starts decompressing the stream at offset in the patch file. */
+static int pipe_open(bz_pipe *p, const char *patchfile, bs_off offset)
+{
+	int bzerr;
+
+	if ((p->file = fopen(patchfile, "rb")) == NULL)
+		return 0;
+	if (fseek(p->file, (long)offset, SEEK_SET))
+		return 0;
+	if ((p->bz = BZ2_bzReadOpen(&bzerr, p->file, 0, 0, NULL, 0)) == NULL)
+		return 0;
+	if ((p->buf = malloc(PIPE_SIZE)) == NULL)
+		return 0;
+
+#ifdef _WIN32
+	InitializeCriticalSection(&p->lock);
+	if ((p->changed = CreateEvent(NULL, FALSE, FALSE, NULL)) == NULL)
+	{
+		DeleteCriticalSection(&p->lock);
+		return 0;
+	}
+	p->syncInit = 1;
+	if ((p->thread = CreateThread(NULL, 0, pipe_thread, p, 0, NULL)) == NULL)
+		return 0;
+#else
+	pthread_mutex_init(&p->lock, NULL);
+	pthread_cond_init(&p->changed, NULL);
+	p->syncInit = 1;
+	if (pthread_create(&p->thread, NULL, pipe_thread, p) != 0)
+		return 0;
+#endif
+	p->threadStarted = 1;
+	return 1;
+}
+
+/* Stops the pipe's thread and frees everything. Safe on a half opened pipe. */
+static void pipe_close(bz_pipe *p)
+{
+	int bzerr;
+
+	if (p->threadStarted)
+	{
+		pipe_lock(p);
+		p->cancelled = 1;
+		pipe_notify(p);
+		pipe_unlock(p);
+#ifdef _WIN32
+		WaitForSingleObject(p->thread, INFINITE);
+		CloseHandle(p->thread);
+#else
+		pthread_join(p->thread, NULL);
+#endif
+	}
+	if (p->syncInit)
+	{
+#ifdef _WIN32
+		CloseHandle(p->changed);
+		DeleteCriticalSection(&p->lock);
+#else
+		pthread_cond_destroy(&p->changed);
+		pthread_mutex_destroy(&p->lock);
+#endif
+	}
+	if (p->bz)
+		BZ2_bzReadClose(&bzerr, p->bz);
+	if (p->file)
+		fclose(p->file);
+	free(p->buf);
+	memset(p, 0, sizeof(*p));
+}
+
+/*
+ * The old file, memory mapped so only the parts the patch refers to are read,
+ * and only by the OS. Read into memory if it can't be mapped.
+ */
+typedef struct
+{
+	const unsigned char *data;
+	bs_off size;
+	unsigned char *alloc;
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#else
+	void *map;
+	size_t mapSize;
+#endif
+} old_file;
+
+static int old_read(old_file *o, const char *path)
+{
+	FILE *f;
+	long size;
+
+	if ((f = fopen(path, "rb")) == NULL)
+		return 0;
+	if (fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0)
+	{
+		fclose(f);
+		return 0;
+	}
+	rewind(f);
+	if ((o->alloc = malloc(size + 1)) == NULL || (size > 0 && fread(o->alloc, size, 1, f) != 1))
+	{
+		fclose(f);
+		return 0;
 	}
+	fclose(f);
+	o->data = o->alloc;
+	o->size = size;
+	return 1;
+}
+
+static int old_open(old_file *o, const char *path)
+{
+#ifdef _WIN32
+	LARGE_INTEGER size;
+
+	o->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (o->file == INVALID_HANDLE_VALUE)
+	{
+		o->file = NULL;
+		return 0;
+	}
+	if (!GetFileSizeEx(o->file, &size))
+		return 0;
+	o->size = size.QuadPart;
+	if (o->size == 0)
+		return 1;
+
+	o->mapping = CreateFileMappingA(o->file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (o->mapping)
+		o->data = (const unsigned char *)MapViewOfFile(o->mapping, FILE_MAP_READ, 0, 0, 0);
+	if (o->data)
+		return 1;
+#else
+	struct stat st;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY)) < 0)
+		return 0;
+	if (fstat(fd, &st) != 0)
+	{
+		close(fd);
+		return 0;
+	}
+	o->size = st.st_size;
+	if (o->size == 0)
+	{
+		close(fd);
+		return 1;
+	}
+
+	o->map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (o->map != MAP_FAILED)
+	{
+		o->mapSize = (size_t)st.st_size;
+		o->data = (const unsigned char *)o->map;
+		return 1;
+	}
+	o->map = NULL;
+#endif
+
+	return old_read(o, path);
+}
+
+static void old_close(old_file *o)
+{
+#ifdef _WIN32
+	if (o->data && !o->alloc)
+		UnmapViewOfFile(o->data);
+	if (o->mapping)
+		CloseHandle(o->mapping);
+	if (o->file)
+		CloseHandle(o->file);
+#else
+	if (o->map)
+		munmap(o->map, o->mapSize);
+#endif
+	free(o->alloc);
+	memset(o, 0, sizeof(*o));
+}
+
+int bspatch(const char * oldfile, const char * newfile, const char * patchfile)
+{
+	FILE * f, * out = NULL;
+	bz_pipe ctrlPipe, diffPipe, extraPipe;
+	old_file old;
+	unsigned char header[32], buf[24];
+	unsigned char *chunk = NULL;
+	bs_off bzctrllen, bzdatalen, newsize;
+	bs_off oldpos, newpos, ctrl[3];
+	bs_off left, from, to, j;
+	size_t n;
+	int i;
+	int created = 0;
+	int result = ERR_OTHER;
+
+	memset(&ctrlPipe, 0, sizeof(ctrlPipe));
+	memset(&diffPipe, 0, sizeof(diffPipe));
+	memset(&extraPipe, 0, sizeof(extraPipe));
+	memset(&old, 0, sizeof(old));
 
 	/*
 	File format:
@@ -102,202 +457,118 @@ int bspatch(const char * oldfile, const char * newfile, const char * patchfile)
 	with control block a set of triples (x,y,z) meaning "add x bytes
 	from oldfile to x bytes from the diff block; copy y bytes from the
 	extra block; seek forwards in oldfile by z bytes".
+
+	The three blocks are decompressed on their own threads while the new
+	file is written out as it is produced, so neither file is held in memory.
 	*/
 
 	/* Read header */
+	if ((f = fopen(patchfile, "rb")) == NULL)
+		return ERR_OTHER;
 	if (fread(header, 1, 32, f) < 32)
 	{
-		if (feof(f))
-		{
-			//errx(1, "Corrupt patch\n");
-			return ERR_CORRUPT_PATCH;
-		}
-		//err(1, "fread(%s)", argv[3]);
-		return ERR_OTHER;
+		result = feof(f) ? ERR_CORRUPT_PATCH : ERR_OTHER;
+		fclose(f);
+		return result;
 	}
+	fclose(f);
 
 	/* Check for appropriate magic */
 	if (memcmp(header, "BSDIFF40", 8) != 0)
-	{
-		//errx(1, "Corrupt patch\n");
 		return ERR_CORRUPT_PATCH;
-	}
 
 	/* Read lengths from header */
 	bzctrllen=offtin(header+8);
 	bzdatalen=offtin(header+16);
 	newsize=offtin(header+24);
 	if((bzctrllen<0) || (bzdatalen<0) || (newsize<0))
-	{
-		//errx(1,"Corrupt patch\n");
 		return ERR_CORRUPT_PATCH;
-	}
 
-	/* Close patch file and re-open it via libbzip2 at the right places */
-	if (fclose(f))
-	{
-		//err(1, "fclose(%s)", argv[3]);
-		return ERR_OTHER;
-	}
-	if ((cpf = fopen(patchfile, "rb")) == NULL)
-	{
-		//err(1, "fopen(%s)", argv[3]);
-		return ERR_OTHER;
-	}
-	if (fseek(cpf, 32, SEEK_SET))
-	{
-		// err(1, "fseeko(%s, %lld)", argv[3], (long long)32);
-		return ERR_OTHER;
-	}
-	if ((cpfbz2 = BZ2_bzReadOpen(&cbz2err, cpf, 0, 0, NULL, 0)) == NULL)
-	{
-		//errx(1, "BZ2_bzReadOpen, bz2err = %d", cbz2err);
-		return ERR_OTHER;
-	}
-	if ((dpf = fopen(patchfile, "rb")) == NULL)
-	{
-		//err(1, "fopen(%s)", argv[3]);
-		return ERR_OTHER;
-	}
-	if (fseek(dpf, 32 + bzctrllen, SEEK_SET))
-	{
-		//err(1, "fseeko(%s, %lld)", argv[3], (long long)(32 + bzctrllen));
-		return ERR_OTHER;
-	}
-	if ((dpfbz2 = BZ2_bzReadOpen(&dbz2err, dpf, 0, 0, NULL, 0)) == NULL)
-	{
-		//errx(1, "BZ2_bzReadOpen, bz2err = %d", dbz2err);
-		return ERR_OTHER;
-	}
-	if ((epf = fopen(patchfile, "rb")) == NULL)
-	{
-		//err(1, "fopen(%s)", argv[3]);
-		return ERR_OTHER;
-	}
-	if (fseek(epf, 32 + bzctrllen + bzdatalen, SEEK_SET))
-	{
-		//err(1, "fseeko(%s, %lld)", argv[3], (long long)(32 + bzctrllen + bzdatalen));
-		return ERR_OTHER;
-	}
-	if ((epfbz2 = BZ2_bzReadOpen(&ebz2err, epf, 0, 0, NULL, 0)) == NULL)
-	{
-		//errx(1, "BZ2_bzReadOpen, bz2err = %d", ebz2err);
-		return ERR_OTHER;
-	}
+	if (!pipe_open(&ctrlPipe, patchfile, 32) ||
+		!pipe_open(&diffPipe, patchfile, 32 + bzctrllen) ||
+		!pipe_open(&extraPipe, patchfile, 32 + bzctrllen + bzdatalen))
+		goto done;
 
-	if((temp=fopen(oldfile,"rb")) == NULL)
-	{
-		return ERR_OTHER;
-	}
-	if((fseek(temp,0,SEEK_END))!=0)
-	{
-		return ERR_OTHER;
-	}
-	oldsize = ftell(temp);
-	if((old_contents=malloc(oldsize+1))==NULL)
-	{
-		return ERR_OTHER;
-	}
-	rewind(temp);
-	if(fread(old_contents,oldsize,1,temp)!=1)
-	{
-		return ERR_OTHER;
-	}
-	if(fclose(temp)==EOF)
-	{
-		return ERR_OTHER;
-	}
-	if((new_contents=malloc(newsize+1))==NULL)
-	{
-		//err(1,NULL);
-		return ERR_OTHER;
-	}
+	if (!old_open(&old, oldfile))
+		goto done;
+	if ((chunk = malloc(CHUNK_SIZE)) == NULL)
+		goto done;
+	if ((out = fopen(newfile, "wb")) == NULL)
+		goto done;
+	created = 1;
 
 	oldpos=0;newpos=0;
 	while(newpos<newsize)
 	{
 		/* Read control data */
-		for(i=0;i<=2;i++) {
-			lenread = BZ2_bzRead(&cbz2err, cpfbz2, buf, 8);
-			if ((lenread < 8) || ((cbz2err != BZ_OK) && (cbz2err != BZ_STREAM_END)))
-			{
-				//errx(1, "Corrupt patch\n");
-				return ERR_CORRUPT_PATCH;
-			}
-			ctrl[i]=offtin(buf);
-		};
-
-		/* Sanity-check */
-		if(newpos+ctrl[0]>newsize)
+		if (!pipe_read(&ctrlPipe, buf, 24))
 		{
-			//errx(1,"Corrupt patch\n");
-			return ERR_CORRUPT_PATCH;
+			result = ERR_CORRUPT_PATCH;
+			goto done;
 		}
+		for(i=0;i<=2;i++)
+			ctrl[i]=offtin(buf + i * 8);
 
-		/* Read diff string */
-		lenread = BZ2_bzRead(&dbz2err, dpfbz2, new_contents + newpos, ctrl[0]);
-		if ((lenread < ctrl[0]) || ((dbz2err != BZ_OK) && (dbz2err != BZ_STREAM_END)))
+		/* Sanity-check */
+		if(ctrl[0]<0 || ctrl[1]<0 || newpos+ctrl[0]+ctrl[1]>newsize)
 		{
-			//errx(1, "Corrupt patch\n");
-			return ERR_CORRUPT_PATCH;
+			result = ERR_CORRUPT_PATCH;
+			goto done;
 		}
 
-		/* Add old data to diff string */
-		for(i=0;i<ctrl[0];i++)
+		/* Read the diff string, add old data to it and write it out */
+		for(left=ctrl[0];left>0;left-=n)
 		{
-			if((oldpos+i>=0) && (oldpos+i<oldsize))
+			n = left > CHUNK_SIZE ? CHUNK_SIZE : (size_t)left;
+			if (!pipe_read(&diffPipe, chunk, n))
 			{
-				new_contents[newpos+i]+=old_contents[oldpos+i];
+				result = ERR_CORRUPT_PATCH;
+				goto done;
 			}
-		}
 
-		/* Adjust pointers */
-		newpos+=ctrl[0];
-		oldpos+=ctrl[0];
+			/* Only the part that lies within the old file */
+			from = oldpos < 0 ? -oldpos : 0;
+			to = oldpos + (bs_off)n > old.size ? old.size - oldpos : (bs_off)n;
+			for(j=from;j<to;j++)
+				chunk[j]+=old.data[oldpos+j];
 
-		/* Sanity-check */
-		if(newpos+ctrl[1]>newsize)
-		{
-			//errx(1,"Corrupt patch\n");
-			return ERR_CORRUPT_PATCH;
+			if (fwrite(chunk, 1, n, out) != n)
+				goto done;
+			oldpos+=n;
+			newpos+=n;
 		}
 
-		/* Read extra string */
-		lenread = BZ2_bzRead(&ebz2err, epfbz2, new_contents + newpos, ctrl[1]);
-		if ((lenread < ctrl[1]) || ((ebz2err != BZ_OK) && (ebz2err != BZ_STREAM_END)))
+		/* Copy the extra string */
+		for(left=ctrl[1];left>0;left-=n)
 		{
-			//errx(1, "Corrupt patch\n");
-			return ERR_CORRUPT_PATCH;
+			n = left > CHUNK_SIZE ? CHUNK_SIZE : (size_t)left;
+			if (!pipe_read(&extraPipe, chunk, n))
+			{
+				result = ERR_CORRUPT_PATCH;
+				goto done;
+			}
+			if (fwrite(chunk, 1, n, out) != n)
+				goto done;
+			newpos+=n;
 		}
 
 		/* Adjust pointers */
-		newpos+=ctrl[1];
 		oldpos+=ctrl[2];
 	};
 
-	/* Clean up the bzip2 reads */
-	BZ2_bzReadClose(&cbz2err, cpfbz2);
-	BZ2_bzReadClose(&dbz2err, dpfbz2);
-	BZ2_bzReadClose(&ebz2err, epfbz2);
-	if (fclose(cpf) || fclose(dpf) || fclose(epf))
-	{
-		//err(1, "fclose(%s)", argv[3]);
-		return ERR_OTHER;
-	}
-
-	/* Write the new file */
-	if(
-		((temp=fopen(newfile,"wb"))==NULL) ||
-		(fwrite(new_contents,newsize,1,temp)==0) ||
-		(fclose(temp)==EOF)
-	)
-	{
-		//err(1,"%s",argv[2]);
-		return ERR_OTHER;
-	}
-
-	free(new_contents);
-	free(old_contents);
+	if (fclose(out) == 0)
+		result = ERR_NONE;
+	out = NULL;
 
-	return ERR_NONE;
+done:
+	pipe_close(&ctrlPipe);
+	pipe_close(&diffPipe);
+	pipe_close(&extraPipe);
+	old_close(&old);
+	free(chunk);
+	if (out)
+		fclose(out);
+	if (created && result != ERR_NONE)
+		remove(newfile);
+	return result;
 }
@@ -14,6 +14,8 @@ enum BSPatchError
 
 /**
  * patch oldfile by using patchfile and write the output to newfile.
+ * oldfile is memory mapped and newfile is written as it is produced, so memory
+ * use doesn't grow with the file sizes. newfile is removed if patching fails.
  *
  * Returns ERR_NONE if successful
  */
@@ -0,0 +1,111 @@
+/*
+ * bspatchbench <oldfile> <patchfile> [-n runs] [-c expected]
+ *     Applies the patch the given number of times, each run in its own child
+ *     process, and reports the wall time and peak resident set size of each.
+ *     With -c, the output is also compared against the expected new file.
+ *
+ * POSIX only. Build it at an older revision to compare implementations.
+ */
+
+#include "bspatch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+static double now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static int same_files(const char *a, const char *b)
+{
+	FILE *fa, *fb;
+	int ca, cb;
+
+	if ((fa = fopen(a, "rb")) == NULL)
+		return 0;
+	if ((fb = fopen(b, "rb")) == NULL)
+	{
+		fclose(fa);
+		return 0;
+	}
+	do
+	{
+		ca = getc(fa);
+		cb = getc(fb);
+	} while (ca == cb && ca != EOF);
+	fclose(fa);
+	fclose(fb);
+	return ca == cb;
+}
+
+int main(int argc, char **argv)
+{
+	const char *oldfile = NULL, *patchfile = NULL, *expected = NULL;
+	const char *newfile = "bspatchbench.out";
+	int runs = 5, i, status;
+	double start, elapsed, best = 0, total = 0;
+	long maxrss = 0;
+	struct rusage usage;
+	pid_t pid;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			runs = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+			expected = argv[++i];
+		else if (!oldfile)
+			oldfile = argv[i];
+		else if (!patchfile)
+			patchfile = argv[i];
+	}
+	if (!oldfile || !patchfile || runs < 1)
+	{
+		fprintf(stderr, "usage: %s <oldfile> <patchfile> [-n runs] [-c expected]\n", argv[0]);
+		return 2;
+	}
+
+	for (i = 0; i < runs; i++)
+	{
+		start = now();
+		if ((pid = fork()) == 0)
+			_exit(bspatch(oldfile, newfile, patchfile) == ERR_NONE ? 0 : 1);
+		if (pid < 0 || wait4(pid, &status, 0, &usage) != pid)
+		{
+			perror("fork");
+			return 1;
+		}
+		elapsed = now() - start;
+
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		{
+			fprintf(stderr, "run %d: patching failed\n", i + 1);
+			return 1;
+		}
+
+		/* ru_maxrss is in kilobytes on Linux. */
+		printf("run %d: %.3f s, peak RSS %ld KB\n", i + 1, elapsed, usage.ru_maxrss);
+		if (i == 0 || elapsed < best)
+			best = elapsed;
+		total += elapsed;
+		if (usage.ru_maxrss > maxrss)
+			maxrss = usage.ru_maxrss;
+	}
+	printf("best %.3f s, average %.3f s, peak RSS %ld KB\n", best, total / runs, maxrss);
+
+	if (expected && !same_files(newfile, expected))
+	{
+		fprintf(stderr, "output differs from %s\n", expected);
+		return 1;
+	}
+	remove(newfile);
+	return 0;
+}
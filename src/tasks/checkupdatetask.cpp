@@ -18,13 +18,10 @@
 #include "utils/httputils.h"
 #include "utils/apputils.h"
 #include "utils/osutils.h"
+#include "utils/feedparser.h"
 #include "config.h"
 #include "appsettings.h"
 
-#include <boost/property_tree/json_parser.hpp>
-
-#include <sstream>
-
 DEFINE_EVENT_TYPE(wxEVT_CHECK_UPDATE)
 
 const wxString ciURL = _(JENKINS_JOB_URL);
@@ -60,18 +57,20 @@ wxThread::ExitCode CheckUpdateTask::TaskStart()
 	if (!jobURL.EndsWith("/"))
 		jobURL.Append("/");
 
-	wxString mainPageJSON;
-	if (!DownloadString(jobURL + "api/json", &mainPageJSON))
+	// Determine the latest stable build.
+	int buildNumber = -1;
+	if (!GetBuildNumber(jobURL + "api/json", &buildNumber))
 	{
 		wxLogError(_("Failed to check for updates. Please check your internet connection."));
 		return (ExitCode)0;
 	}
-	
-	// Determine the latest stable build.
-	int buildNumber = GetBuildNumber(mainPageJSON);
 
 	if(buildNumber == -1)
 	{
+		// The JSON wasn't kept around, so get it again for the dump.
+		wxString mainPageJSON;
+		DownloadString(jobURL + "api/json", &mainPageJSON);
+
 		wxFileName fname("JsonDUMP.txt");
 		fname.MakeAbsolute();
 		wxFile dump("JsonDUMP.txt",wxFile::write);
@@ -120,23 +119,22 @@ wxThread::ExitCode CheckUpdateTask::TaskStart()
 	return (ExitCode)1;
 }
 
-int CheckUpdateTask::GetBuildNumber(const wxString &mainPageJSON)
+bool CheckUpdateTask::GetBuildNumber(const wxString &apiURL, int *buildNumber)
 {
-	using namespace boost::property_tree;
-	
-	try
-	{
-		ptree pt;
-		std::stringstream inStream(stdStr(mainPageJSON), std::ios::in);
-		read_json(inStream, pt);
-		
-		return pt.get<int>("number");
-	}
-	catch (json_parser_error e)
+	// The number is near the top, so stop reading once it's there.
+	JsonStreamParser parser;
+	parser.onValue = [&] (const std::string &path, const std::string &value)
 	{
-		return -1;
-	}
-	
+		long number;
+		if (path == "number" && wxStr(value).ToLong(&number))
+		{
+			*buildNumber = number;
+			parser.Stop();
+		}
+	};
+
+	*buildNumber = -1;
+	return DownloadParsed(apiURL, parser) || parser.HasError();
 }
 
 void CheckUpdateTask::OnCheckComplete(int buildNumber, wxString downloadURL)
@@ -31,7 +31,8 @@ public:
 	wxString m_downloadURL;
 	
 protected:
-	int GetBuildNumber(const wxString &mainPageJSON);
+	// Returns false if the download failed. buildNumber is -1 if it wasn't in the JSON.
+	bool GetBuildNumber(const wxString &apiURL, int *buildNumber);
 	
 	void OnCheckComplete(int buildNumber, wxString downloadURL);
 };
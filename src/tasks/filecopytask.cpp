@@ -1,12 +1,12 @@
-// 
+//
 //  Copyright 2012 MultiMC Contributors
-// 
+//
 //    Licensed under the Apache License, Version 2.0 (the "License");
 //    you may not use this file except in compliance with the License.
 //    You may obtain a copy of the License at
-// 
+//
 //        http://www.apache.org/licenses/LICENSE-2.0
-// 
+//
 //    Unless required by applicable law or agreed to in writing, software
 //    distributed under the License is distributed on an "AS IS" BASIS,
 //    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
@@ -18,79 +18,243 @@
 
 #include "utils/apputils.h"
 #include "utils/fsutils.h"
+#include "utils/parallel.h"
 
 #include <wx/string.h>
 #include <wx/dir.h>
 
-FileCopyTask::FileCopyTask(const wxFileName &src, const wxFileName &dest)
+#include <deque>
+
+FileCopyTask::FileCopyTask(const wxFileName &src, const wxFileName &dest, CopyMode mode)
 	: Task()
 {
 	m_src = src;
 	m_dest = dest;
+	m_mode = mode;
 }
 
-wxThread::ExitCode FileCopyTask::TaskStart()
+// Instance folders whose jars and zips are only ever replaced as a whole.
+static const char *linkedArchiveDirs[] = 
+	{ "instMods", "minecraft/mods", "minecraft/coremods", "minecraft/bin", "minecraft/texturepacks" };
+// Instance folders whose contents are only ever replaced as a whole.
+// (minecraft/resources isn't one, old versions update it in place.)
+static const char *linkedDirs[] = { "minecraft/bin/natives" };
+
+bool FileCopyTask::IsImmutable(const wxFileName &relPath)
 {
-	SetStatus(_("Discovering files..."));
+	const wxArrayString &dirs = relPath.GetDirs();
+	wxString ext = relPath.GetExt().Lower();
+	bool isArchive = ext == "jar" || ext == "zip";
 
-	wxArrayString copyFiles;
-	if (!DiscoverFiles(m_src.GetFullPath(), copyFiles))
+	// Only exact locations in the instance count, a "mods" or "natives" folder 
+	// somewhere in a config or world folder may be written to.
+	wxString dir;
+	for (size_t i = 0; i < dirs.size(); i++)
 	{
-		EmitErrorMessage(_("Failed to read source directory."));
-		return (ExitCode)0;
+		if (i == 0 && dirs[i] == ".minecraft")
+			dir = "minecraft";
+		else
+			dir << (i > 0 ? "/" : "") << dirs[i];
 	}
 
-	SetStatus(wxString::Format(_("Copying %i files..."), copyFiles.size()));
-	int ctr = 0;
-	for (wxArrayString::iterator iter = copyFiles.begin(); iter != copyFiles.end(); ++iter, ctr++)
+	for (size_t j = 0; j < sizeof(linkedDirs) / sizeof(linkedDirs[0]); j++)
 	{
-		wxFileName file(*iter);
-
-		wxFileName destFile(file);
-		destFile.MakeRelativeTo(m_src.GetFullPath());
-		destFile.Normalize(wxPATH_NORM_ALL, m_dest.GetFullPath());
+		wxString linked = linkedDirs[j];
+		if (dir == linked || dir.StartsWith(linked + "/"))
+			return true;
+	}
 
-		if (!wxDirExists(destFile.GetPath(true)))
+	if (isArchive)
+	{
+		for (size_t j = 0; j < sizeof(linkedArchiveDirs) / sizeof(linkedArchiveDirs[0]); j++)
 		{
-			if (!fsutils::CreateAllDirs(wxFileName::DirName(destFile.GetPath(true))))
-				return (ExitCode)0;
+			if (dir == linkedArchiveDirs[j])
+				return true;
 		}
-
-		wxCopyFile(file.GetFullPath(), destFile.GetFullPath());
-		SetProgress(((float)ctr / (float)copyFiles.size()) * 100);
 	}
-	return (ExitCode)1;
+	return false;
 }
 
-bool FileCopyTask::DiscoverFiles(const wxString &path, wxArrayString &fileList)
+// Files found by the walker, waiting to be copied by the workers.
+class FileCopyTask::CopyQueue
 {
-	if (wxDirExists(path))
+public:
+	struct Item
 	{
-		wxDir subDir(path);
+		wxString src;
+		wxString dest;
+		wxULongLong_t size;
+		bool allowHardLink;
+	};
 
-		if (!subDir.IsOpened())
-		{
+	CopyQueue()
+		: m_cond(m_mutex), m_walkDone(false), m_fileCount(0), m_failed(0),
+		  m_totalBytes(0), m_copiedBytes(0) {}
+
+	void Push(const Item &item)
+	{
+		wxMutexLocker lock(m_mutex);
+		// The workers get their own copies of the strings.
+		m_items.push_back(item);
+		m_items.back().src = item.src.Clone();
+		m_items.back().dest = item.dest.Clone();
+		m_fileCount++;
+		m_totalBytes += item.size;
+		m_cond.Signal();
+	}
+
+	void FinishWalk()
+	{
+		wxMutexLocker lock(m_mutex);
+		m_walkDone = true;
+		m_cond.Broadcast();
+	}
+
+	// Waits for the next item. Returns false once the walk is done and
+	// everything has been handed out.
+	bool Pop(Item *item)
+	{
+		wxMutexLocker lock(m_mutex);
+		while (m_items.empty() && !m_walkDone)
+			m_cond.Wait();
+		if (m_items.empty())
 			return false;
-		}
+		*item = m_items.front();
+		m_items.pop_front();
+		return true;
+	}
 
-		wxString currentFile;
-		if (subDir.GetFirst(&currentFile))
+	void Done(const Item &item, bool success)
+	{
+		wxMutexLocker lock(m_mutex);
+		m_copiedBytes += item.size;
+		if (!success)
+			m_failed++;
+	}
+
+	// Progress in percent of bytes, or -1 while the total isn't known yet.
+	int GetProgress()
+	{
+		wxMutexLocker lock(m_mutex);
+		if (!m_walkDone)
+			return -1;
+		if (m_totalBytes == 0)
+			return 100;
+		return (int)(m_copiedBytes * 100 / m_totalBytes);
+	}
+
+	int GetFileCount()
+	{
+		wxMutexLocker lock(m_mutex);
+		return m_fileCount;
+	}
+
+	int GetFailedCount()
+	{
+		wxMutexLocker lock(m_mutex);
+		return m_failed;
+	}
+
+protected:
+	wxMutex m_mutex;
+	wxCondition m_cond;
+	std::deque<Item> m_items;
+	bool m_walkDone;
+	int m_fileCount;
+	int m_failed;
+	wxULongLong_t m_totalBytes;
+	wxULongLong_t m_copiedBytes;
+};
+
+wxThread::ExitCode FileCopyTask::TaskStart()
+{
+	SetStatus(_("Copying files..."));
+
+	CopyQueue queue;
+	bool walkOK = true;
+
+	// Index 0 walks the tree and is always handed out first. The others copy
+	// whatever it has found so far, so walking and copying overlap.
+	int workers = GetIOThreadCount();
+	ParallelFor(workers + 1, workers + 1, [&] (size_t i)
+	{
+		if (i == 0)
 		{
-			do 
-			{
-				currentFile = Path::Combine(subDir.GetName(), currentFile);
-
-				if (wxFileExists(currentFile) || wxDirExists(currentFile))
-				{
-					if (!DiscoverFiles(currentFile, fileList))
-						return false;
-				}
-			} while (subDir.GetNext(&currentFile));
+			walkOK = WalkDir(m_src.GetFullPath(), m_dest.GetFullPath(), wxEmptyString, queue);
+			queue.FinishWalk();
+			SetStatus(wxString::Format(_("Copying %i files..."), queue.GetFileCount()));
+			SetProgress(queue.GetProgress());
 		}
+		else
+		{
+			CopyFiles(queue);
+		}
+	});
+
+	if (!walkOK)
+	{
+		EmitErrorMessage(_("Failed to read source directory."));
+		return (ExitCode)0;
+	}
+	if (queue.GetFailedCount() > 0)
+	{
+		EmitErrorMessage(wxString::Format(_("Failed to copy %i files."), queue.GetFailedCount()));
+		return (ExitCode)0;
 	}
-	else if (wxFileExists(path))
+	return (ExitCode)1;
+}
+
+bool FileCopyTask::WalkDir(const wxString &srcDir, const wxString &destDir, const wxString &relDir, CopyQueue &queue)
+{
+	if (!wxDirExists(destDir) && !fsutils::CreateAllDirs(wxFileName::DirName(destDir)))
+		return false;
+
+	wxDir dir(srcDir);
+	if (!dir.IsOpened())
+		return false;
+
+	wxString name;
+	if (dir.GetFirst(&name))
 	{
-		fileList.Add(path);
+		do
+		{
+			wxString srcPath = Path::Combine(srcDir, name);
+			wxString destPath = Path::Combine(destDir, name);
+
+			if (wxDirExists(srcPath))
+			{
+				if (!WalkDir(srcPath, destPath, Path::Combine(relDir, name), queue))
+					return false;
+			}
+			else if (wxFileExists(srcPath))
+			{
+				CopyQueue::Item item;
+				item.src = srcPath;
+				item.dest = destPath;
+				wxULongLong size = wxFileName::GetSize(srcPath);
+				item.size = size == wxInvalidSize ? 0 : size.GetValue();
+				item.allowHardLink = m_mode == COPY_CLONE_LINK && IsImmutable(wxFileName(relDir, name));
+				queue.Push(item);
+			}
+		} while (dir.GetNext(&name));
 	}
 	return true;
 }
+
+void FileCopyTask::CopyFiles(CopyQueue &queue)
+{
+	CopyQueue::Item item;
+	while (queue.Pop(&item))
+	{
+		bool success;
+		if (m_mode == COPY_FULL)
+			success = fsutils::CopySingleFile(item.src, item.dest);
+		else
+			success = fsutils::LinkFile(item.src, item.dest, item.allowHardLink);
+
+		queue.Done(item, success);
+		int progress = queue.GetProgress();
+		if (progress >= 0)
+			SetProgress(progress);
+	}
+}
@@ -22,13 +22,37 @@
 class FileCopyTask : public Task
 {
 public:
-	FileCopyTask(const wxFileName &src, const wxFileName &dest);
+	enum CopyMode
+	{
+		// Every file gets its own copy of the data.
+		COPY_FULL,
+
+		// Files are reflinked where the filesystem supports it.
+		COPY_CLONE,
+
+		// Like COPY_CLONE, but files that MultiMC only ever replaces (and never 
+		// rewrites in place) are hard linked if they can't be reflinked.
+		COPY_CLONE_LINK,
+	};
+
+	FileCopyTask(const wxFileName &src, const wxFileName &dest, CopyMode mode = COPY_FULL);
 
 	virtual ExitCode TaskStart();
 
+	// True if the file at relPath (relative to the instance folder being copied) 
+	// is never modified in place, so sharing it with a hard link is safe.
+	static bool IsImmutable(const wxFileName &relPath);
+
 protected:
-	bool DiscoverFiles(const wxString &path, wxArrayString &fileList);
+	class CopyQueue;
+
+	// Creates destDir and queues every file under srcDir for copying.
+	bool WalkDir(const wxString &srcDir, const wxString &destDir, const wxString &relDir, CopyQueue &queue);
+
+	// Copies queued files until the walk is done and the queue is empty.
+	void CopyFiles(CopyQueue &queue);
 
 	wxFileName m_src;
 	wxFileName m_dest;
+	CopyMode m_mode;
 };
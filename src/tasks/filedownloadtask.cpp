@@ -17,8 +17,13 @@
 #include "filedownloadtask.h"
 #include "utils/curlutils.h"
 #include "utils/apputils.h"
+#include "utils/httputils.h"
+#include "utils/partialdownload.h"
 #include <wx/wfstream.h>
 
+// Retries resume from where the last attempt stopped.
+const int maxDownloadTries = 5;
+
 FileDownloadTask::FileDownloadTask(const wxString &src, const wxFileName &dest, const wxString &message)
 	: Task()
 {
@@ -60,13 +65,19 @@ wxThread::ExitCode FileDownloadTask::TaskStart()
 	curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, true);
 	curl_easy_setopt(curl, CURLOPT_MAXREDIRS, 20);
 	
-	size_t downloadedSize = 0;
-	wxFFileOutputStream outStream(m_dest.GetFullPath());
+	PartialDownload partFile(m_dest);
+	if (!partFile.Open(m_etag))
+	{
+		curl_easy_cleanup(curl);
+		EmitErrorMessage(_("Failed to create ") + m_dest.GetFullPath());
+		successful = false;
+		return (ExitCode)0;
+	}
+
 	CurlLambdaCallbackFunction curlWrite = [&] (void *buffer, size_t size) -> size_t
 	{
-		outStream.Write(buffer, size);
-		size_t lastwrite = outStream.LastWrite();
-		downloadedSize += lastwrite;
+		size_t written = partFile.Write(curl, buffer, size);
+		double downloadedSize = partFile.GetOffset();
 		int progress = ((double)downloadedSize / (double)downloadSize) * 100;
 		SetProgress(progress);
 
@@ -84,14 +95,22 @@ wxThread::ExitCode FileDownloadTask::TaskStart()
 		wxString sDownloadSize = wxString::Format(wxT("%.0f"), (float)(downloadSize / 1000));
 		SetStatus(wxString::Format(_("%s (%skB/%skB)"), 
 			m_message.c_str(), sDownloadedSize.c_str(), sDownloadSize.c_str()));
-		return outStream.LastWrite();
+		return written;
 	};
 	curl_easy_setopt(curl, CURLOPT_WRITEDATA, &curlWrite);
 	
-	int curlErr = curl_easy_perform(curl);
+	int curlErr = 0;
+	for (int tries = 0; tries < maxDownloadTries; tries++)
+	{
+		partFile.SetupCurl(curl);
+		curlErr = curl_easy_perform(curl);
+		if (curlErr == 0)
+			break;
+		partFile.SaveState();
+	}
 	curl_easy_cleanup(curl);
 	
-	if (curlErr != 0)
+	if (curlErr != 0 || !partFile.Commit())
 	{
 		EmitErrorMessage(_("Download failed."));
 		successful = false;
@@ -108,14 +127,26 @@ double FileDownloadTask::GetDownloadSize()
 {
 	CURL *curl = InitCurlHandle();
 	
+	wxString headers;
+	CurlLambdaCallbackFunction curlWriteHeaders = [&] (void *buffer, size_t size) -> size_t
+	{
+		headers.Append(wxString((const char*)buffer, wxConvUTF8, size));
+		return size;
+	};
+
 	curl_easy_setopt(curl, CURLOPT_URL, TOASCII(m_src));
 	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlBlankCallback);
+	curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, CurlLambdaCallback);
+	curl_easy_setopt(curl, CURLOPT_HEADERDATA, &curlWriteHeaders);
 	curl_easy_setopt(curl, CURLOPT_NOBODY, true);
 	curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, true);
 	curl_easy_setopt(curl, CURLOPT_MAXREDIRS, 20);
 	
 	if (curl_easy_perform(curl) != 0)
+	{
+		curl_easy_cleanup(curl);
 		return -1;
+	}
 	
 	long responseCode = 0;
 	double contentLen = 0;
@@ -124,6 +155,9 @@ double FileDownloadTask::GetDownloadSize()
 	
 	curl_easy_cleanup(curl);
 	
+	// A part file is only resumed if the file on the server is still the same.
+	m_etag = GetETagFromHeaders(headers);
+	
 	if (responseCode == 404 || responseCode == 403 || responseCode == 500)
 		return -responseCode;
 	else
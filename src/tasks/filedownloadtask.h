@@ -35,6 +35,7 @@ protected:
 	
 	wxString m_src;
 	wxFileName m_dest;
+	wxString m_etag;
 	
 	bool successful;
 };
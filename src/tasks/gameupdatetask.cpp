@@ -22,6 +22,8 @@
 #include <wx/zipstrm.h>
 #include <wx/regex.h>
 
+#include <memory>
+
 #include <boost/property_tree/ini_parser.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/foreach.hpp>
@@ -32,15 +34,25 @@
 #include "utils/curlutils.h"
 #include "utils/apputils.h"
 #include "utils/httputils.h"
+#include "utils/fsutils.h"
+#include "utils/partialdownload.h"
+#include "utils/pipestream.h"
 #include <mcversionlist.h>
+#include <librarycache.h>
 
 const wxString mcrwIndexURL = "http://mcrw.forkk.net/index.json";
 const wxString mcrwPatchBaseURL = "http://mcrw.forkk.net/patches/";
 
 DEFINE_EVENT_TYPE(wxEVT_GAME_UPDATE_COMPLETE)
 
-GameUpdateTask::GameUpdateTask(Instance *inst, int64_t latestVersion, bool forceUpdate)
-	: Task(), m_inst(inst), m_latestVersion(latestVersion), m_forceUpdate(forceUpdate) {}
+GameUpdateTask::GameUpdateTask(Instance *inst, int64_t latestVersion, bool forceUpdate,
+	const wxString &jarBaseURL)
+	: Task(), m_inst(inst), m_latestVersion(latestVersion), m_forceUpdate(forceUpdate), 
+	m_jarBaseURL(jarBaseURL)
+{
+	if (!m_jarBaseURL.IsEmpty() && !m_jarBaseURL.EndsWith("/"))
+		m_jarBaseURL << "/";
+}
 
 GameUpdateTask::~GameUpdateTask() {}
 
@@ -58,36 +70,39 @@ wxThread::ExitCode GameUpdateTask::TaskStart()
 	MCVersionList & vlist = MCVersionList::Instance();
 	vlist.LoadIfNeeded();
 	
-	MCVersion * ver = vlist.GetVersion(intendedVersion);
+	// Copies, the lists can be swapped out while this runs.
+	MCVersion ver;
 	
-	if(!ver)
+	if(!vlist.FindVersion(intendedVersion, ver))
 	{
 		vlist.SetNeedsMCRW();
 		vlist.LoadIfNeeded();
-		ver = vlist.GetVersion(intendedVersion);
-		if(!ver)
+		// The lists may have come from an outdated cache.
+		if(!vlist.FindVersion(intendedVersion, ver) &&
+			!(vlist.Reload() && vlist.FindVersion(intendedVersion, ver)))
 			return (ExitCode)0;
 	}
 	
 	bool do_patching = false;
 	
-	MCVersion * real_ver;
+	MCVersion real_ver;
 	wxString patch_version;
 	wxString patchBaseURL;
 	using namespace boost::property_tree;
 	ptree mcrw_checksum_data;
 	
 	// get the MCRewind stuff (optionally) and determine what version of MC do we actually want
-	if(ver->GetVersionType() == MCRewind)
+	if(ver.GetVersionType() == MCRewind)
 	{
 		do_patching = true;
-		patch_version = ver->GetDescriptor();
+		patch_version = ver.GetDescriptor();
 		if (!DownloadPatches(patch_version))
 			return (ExitCode)false;
 
 		SetProgress(2);
 
-		real_ver = vlist.GetVersion(ver->GetPatchTargetVersion());
+		if(!vlist.FindVersion(ver.GetPatchTargetVersion(), real_ver))
+			return (ExitCode)0;
 	}
 	else
 	{
@@ -95,8 +110,11 @@ wxThread::ExitCode GameUpdateTask::TaskStart()
 	}
 	
 	wxString mojangURL ("http://s3.amazonaws.com/MinecraftDownload/");
+	wxString mcJarURL = real_ver.GetDLUrl();
+	if (!m_jarBaseURL.IsEmpty())
+		mojangURL = mcJarURL = m_jarBaseURL;
 	jarURLs.clear();
-	jarURLs.push_back(real_ver->GetDLUrl() + "minecraft.jar");
+	jarURLs.push_back(mcJarURL + "minecraft.jar");
 	jarURLs.push_back(mojangURL + "lwjgl_util.jar");
 	jarURLs.push_back(mojangURL + "jinput.jar");
 	jarURLs.push_back(mojangURL + "lwjgl.jar");
@@ -119,10 +137,10 @@ wxThread::ExitCode GameUpdateTask::TaskStart()
 	if (!binDir.DirExists())
 		binDir.Mkdir();
 
-	if(real_ver->GetVersionType() == CurrentStable)
+	if(real_ver.GetVersionType() == CurrentStable)
 		m_inst->WriteVersionFile(m_latestVersion);
 	else
-		m_inst->WriteVersionFile(real_ver->GetTimestamp() * 1000);
+		m_inst->WriteVersionFile(real_ver.GetTimestamp() * 1000);
 	DownloadJars();
 	ExtractNatives();
 	wxRemoveFile(Path::Combine(m_inst->GetBinDir(), wxFileName(jarURLs[jarURLs.size() - 1]).GetFullName()));
@@ -132,13 +150,13 @@ wxThread::ExitCode GameUpdateTask::TaskStart()
 	bool success = true;
 	if(do_patching)
 	{
-		if(!ApplyPatches(ver->GetDescriptor()))
+		if(!ApplyPatches(ver.GetDescriptor()))
 		{
 			wxLogError(_("Something went terribly wrong while patching the jar with MCRewind."));
 			success = false;
 		}
 
-		if (!VerifyPatchedFiles(ver))
+		if (!VerifyPatchedFiles(&ver))
 		{
 			wxLogError(_("Something went terribly wrong while patching the jar with MCRewind."));
 			success = false;
@@ -149,6 +167,113 @@ wxThread::ExitCode GameUpdateTask::TaskStart()
 	return (ExitCode)success;
 }
 
+static bool ExtractNativesStream(wxInputStream &jarStream, const wxFileName &nativesDir)
+{
+	wxZipInputStream zipStream(jarStream);
+	
+	std::auto_ptr<wxZipEntry> entry;
+	while (entry.reset(zipStream.GetNextEntry()), entry.get() != NULL)
+	{
+		if (entry->IsDir() || entry->GetInternalName().Contains("META-INF"))
+			continue;
+		wxFileName destFile(Path::Combine(nativesDir, entry->GetName()));
+		if (destFile.FileExists())
+			wxRemoveFile(destFile.GetFullPath());
+		wxFileOutputStream outStream(destFile.GetFullPath());
+		outStream.Write(zipStream);
+		if (!outStream.IsOk() || !outStream.Close())
+			return false;
+	}
+	return zipStream.Eof();
+}
+
+// Unpacks the natives jar while it is being downloaded, so it never has to be 
+// written to disk and read back.
+class NativesExtractThread : public wxThread
+{
+public:
+	NativesExtractThread(const wxFileName &destDir)
+		: wxThread(wxTHREAD_JOINABLE), m_destDir(destDir), m_success(false)
+	{
+		MD5Init(&m_md5ctx);
+	}
+
+	// Passes downloaded data on to the extractor.
+	bool Write(const void *buffer, size_t size)
+	{
+		MD5Update(&m_md5ctx, (unsigned char*)buffer, size);
+		return m_pipe.Feed(buffer, size);
+	}
+
+	// Waits for the extractor to finish. Returns false if extraction failed.
+	bool Finish(wxString *md5)
+	{
+		m_pipe.CloseWrite();
+		Wait();
+
+		unsigned char md5digest[16];
+		MD5Final(md5digest, &m_md5ctx);
+		*md5 = Utils::BytesToString(md5digest);
+		return m_success;
+	}
+
+	void Abort()
+	{
+		m_pipe.Abort();
+		Wait();
+	}
+
+protected:
+	virtual ExitCode Entry()
+	{
+		m_success = ExtractNativesStream(m_pipe, m_destDir);
+		if (m_success)
+		{
+			// Eat the central directory so the writer doesn't block on it.
+			char buffer[4096];
+			while (m_pipe.Read(buffer, sizeof(buffer)).LastRead() > 0);
+		}
+		else
+		{
+			m_pipe.Abort();
+		}
+		return 0;
+	}
+
+	PipeInputStream m_pipe;
+	wxFileName m_destDir;
+	MD5Context m_md5ctx;
+	bool m_success;
+};
+
+// State of a single jar download in DownloadJars.
+struct JarDownload
+{
+	wxString url;
+	wxFileName dest;
+
+	CURL *curl;
+	struct curl_slist *headers;
+	std::unique_ptr<PartialDownload> part;
+	wxString headerContent;
+	wxString etag;
+
+	// MD5 sum of the file, if known. Used as the key in the library cache.
+	wxString md5;
+
+	int fileSize;
+	int downloadedSize;
+	int tries;
+	bool skip;
+
+	CurlLambdaCallbackFunction curlWrite;
+	CurlLambdaCallbackFunction curlWriteHeaders;
+
+	// Set while the natives are unpacked straight from the download.
+	std::unique_ptr<NativesExtractThread> extractor;
+	wxFileName extractDir;
+};
+
 void GameUpdateTask::DownloadJars()
 {
 	using namespace boost::property_tree;
@@ -169,50 +294,99 @@ void GameUpdateTask::DownloadJars()
 	}
 	
 	SetState(STATE_DOWNLOADING);
+
+	const int maxConnections = settings->GetMaxDownloadConnections();
+	LibraryCache &libCache = LibraryCache::Instance();
 	
+	std::vector<JarDownload> downloads(jarURLs.size());
+	std::vector<CURL*> handles;
 	int totalDownloadSize = 0;
-	int *fileSizes = new int[jarURLs.size()];
-	bool *skip = new bool[jarURLs.size()];
+
+	// md5sums has the jar names without the extension as keys
+	auto etagKey = [] (const wxString &url) -> std::string
+	{
+		return stdStr(wxFileName(wxURL(url).GetPath()).GetName());
+	};
 	
 	// Compare ETags and skip ones that match.
+	// All the HEAD requests go out at the same time.
 	for (size_t i = 0; i < jarURLs.size(); i++)
 	{
-		wxString etagOnDisk = wxStr(etag_store.get<std::string>(
-			stdStr(wxURL(jarURLs[i]).GetPath()), ""));
+		JarDownload &dl = downloads[i];
+		dl.url = jarURLs[i];
+		dl.dest = wxFileName(m_inst->GetBinDir().GetFullPath(), 
+			wxFileName(wxURL(dl.url).GetPath()).GetFullName());
+		dl.fileSize = 0;
+		dl.downloadedSize = 0;
+		dl.tries = 0;
+		dl.skip = false;
+
+		wxString etagOnDisk = wxStr(etag_store.get<std::string>(etagKey(dl.url), ""));
 		
-		struct curl_slist *headers = NULL;
-		headers = curl_slist_append(headers, stdStr("If-None-Match: " + etagOnDisk).c_str());
+		// Only ask whether it changed if there's a file that could still be used.
+		dl.headers = NULL;
+		if (!etagOnDisk.IsEmpty() && dl.dest.FileExists())
+			dl.headers = curl_slist_append(dl.headers, stdStr("If-None-Match: \"" + etagOnDisk + "\"").c_str());
 		
-		CURL *curl = InitCurlHandle();
-		curl_easy_setopt(curl, CURLOPT_HEADER, true);
-		curl_easy_setopt(curl, CURLOPT_URL, TOASCII(jarURLs[i]));
-		curl_easy_setopt(curl, CURLOPT_NOBODY, true);
+		dl.curl = InitCurlHandle();
+		curl_easy_setopt(dl.curl, CURLOPT_HEADER, true);
+		curl_easy_setopt(dl.curl, CURLOPT_URL, TOASCII(dl.url));
+		curl_easy_setopt(dl.curl, CURLOPT_HTTPHEADER, dl.headers);
+		curl_easy_setopt(dl.curl, CURLOPT_NOBODY, true);
 		
 #ifdef HTTPDEBUG
-		curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
+		curl_easy_setopt(dl.curl, CURLOPT_WRITEFUNCTION, NULL);
 #else
-		curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlBlankCallback);
+		curl_easy_setopt(dl.curl, CURLOPT_WRITEFUNCTION, CurlBlankCallback);
 #endif
-		
-		if (curl_easy_perform(curl) != 0)
+
+		JarDownload *pdl = &dl;
+		dl.curlWriteHeaders = [pdl] (void *buffer, size_t size) -> size_t
 		{
-			
-		}
-		
+			pdl->headerContent.Append(wxString((const char*)buffer, wxConvUTF8, size));
+			return size;
+		};
+		curl_easy_setopt(dl.curl, CURLOPT_HEADERFUNCTION, CurlLambdaCallback);
+		curl_easy_setopt(dl.curl, CURLOPT_HEADERDATA, &dl.curlWriteHeaders);
+
+		handles.push_back(dl.curl);
+	}
+
+	CurlMultiPerform(handles, maxConnections, [&] (CURL *handle, CURLcode result) -> bool
+	{
 		long response = 0;
 		double contentLen = 0;
-		curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response);
-		curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &contentLen);
-		
-		if (response == 300 && !m_forceUpdate)
-			skip[i] = true;
-		else
-			skip[i] = false;
-		
-		fileSizes[i] = contentLen;
-		totalDownloadSize += contentLen;
-		
-		curl_easy_cleanup(curl);
+		curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &response);
+		curl_easy_getinfo(handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &contentLen);
+
+		for (size_t i = 0; i < downloads.size(); i++)
+		{
+			JarDownload &dl = downloads[i];
+			if (dl.curl != handle)
+				continue;
+
+			if (response == 304 && !m_forceUpdate)
+				dl.skip = true;
+			
+			dl.fileSize = contentLen > 0 ? contentLen : 0;
+			totalDownloadSize += dl.fileSize;
+
+			// S3 ETags are MD5 sums. When offline, fall back to the last 
+			// known sum so files can still come from the library cache.
+			dl.etag = GetETagFromHeaders(dl.headerContent);
+			if (LibraryCache::IsMD5(dl.etag))
+				dl.md5 = dl.etag;
+			else if (result != CURLE_OK)
+				dl.md5 = libCache.GetURLHash(dl.url);
+		}
+		return false;
+	});
+
+	for (size_t i = 0; i < downloads.size(); i++)
+	{
+		curl_easy_cleanup(downloads[i].curl);
+		curl_slist_free_all(downloads[i].headers);
+		downloads[i].curl = nullptr;
 	}
 	
 	int initialProgress = 10;
@@ -220,120 +394,225 @@ void GameUpdateTask::DownloadJars()
 	
 	// Download jars
 	int totalDownloadedSize = 0;
-	for (size_t i = 0; i < jarURLs.size(); i++)
+	const int maxDownloadTries = 5;
+
+	auto updateProgress = [&] ()
+	{
+		if (totalDownloadSize <= 0)
+			return;
+		SetProgress(initialProgress + 
+			((double)totalDownloadedSize / (double)totalDownloadSize) * 
+			(100 - initialProgress - 10));
+	};
+
+	auto storeETag = [&] (const JarDownload &dl, const wxString &etag)
+	{
+		std::string key = etagKey(dl.url);
+		// ASCII is fine. it's lower case letters and numbers
+		std::string value (TOASCII(etag));
+		etag_store.put<std::string>(key, value);
+		std::ofstream out;
+		out.open(md5File.GetFullPath().mb_str());
+		write_ini(out, etag_store);
+		out.flush();
+		out.close();
+	};
+
+	// (Re)starts a download from where the part file ends.
+	auto startDownload = [&] (JarDownload &dl) -> bool
 	{
+		if (dl.tries >= maxDownloadTries)
+		{
+			EmitErrorMessage(_("Failed to download ") + dl.url);
+			return false;
+		}
+		dl.tries++;
+
+		dl.headerContent.Empty();
+		dl.part->SetupCurl(dl.curl);
+
+		totalDownloadedSize += dl.part->GetOffset() - dl.downloadedSize;
+		dl.downloadedSize = dl.part->GetOffset();
+		return true;
+	};
+
+	handles.clear();
+	for (size_t i = 0; i < downloads.size(); i++)
+	{
+		JarDownload &dl = downloads[i];
+
 		// Skip this file because we already have it.
-		if (skip[i])
+		if (dl.skip)
 		{
-			SetProgress(initialProgress + fileSizes[i] * 
-				initialProgress / totalDownloadSize);
+			totalDownloadedSize += dl.fileSize;
+			continue;
 		}
-		else
+
+		if (dl.url.Contains("minecraft.jar") && m_inst->GetMCBackup().FileExists())
 		{
-			wxURL currentFile = jarURLs[i];
+			wxRemoveFile(m_inst->GetMCBackup().GetFullPath());
+		}
 
-			SetState(STATE_DOWNLOADING, wxFileName(currentFile.GetPath()).GetFullName());
+		bool isNatives = i == downloads.size() - 1;
 
-			wxFileName dlDest(m_inst->GetBinDir().GetFullPath(), 
-							  wxFileName(currentFile.GetPath()).GetFullName());
-			
-			if (currentFile.GetURL().Contains("minecraft.jar") && 
-				m_inst->GetMCBackup().FileExists())
-			{
-				wxRemoveFile(m_inst->GetMCBackup().GetFullPath());
-			}
-			
-			const int maxDownloadTries = 5;
-			int downloadTries = 0;
-		DownloadFile:
-			if (downloadTries >= maxDownloadTries)
-			{
-				EmitErrorMessage(_("Failed to download ") + currentFile.GetURL());
-				return;
-			}
-			
-			downloadTries++;
-			
-			unsigned char md5digest[16];
-			int currentDownloadedSize = 0;
-			
-			CURL *curl = InitCurlHandle();
-			curl_easy_setopt(curl, CURLOPT_URL, TOASCII(currentFile.GetURL()));
-			curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlLambdaCallback);
-			curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, CurlLambdaCallback);
-			
-			wxFileOutputStream outStream(dlDest.GetFullPath());
-			MD5Context md5ctx;
-			MD5Init(&md5ctx);
-			
-			bool cancel = false;
-			CurlLambdaCallbackFunction curlWrite = [&] (void *buffer, size_t size) -> size_t
+		// The natives are already unpacked in the library cache, the jar isn't needed.
+		if (isNatives && !m_forceUpdate && libCache.HasNatives(dl.md5))
+		{
+			totalDownloadedSize += dl.fileSize;
+			continue;
+		}
+
+		// Another instance already downloaded this exact file.
+		if (!m_forceUpdate && libCache.LinkFile(dl.md5, dl.dest.GetFullName(), dl.dest.GetFullPath()))
+		{
+			totalDownloadedSize += dl.fileSize;
+			continue;
+		}
+
+		// Whatever an earlier attempt left behind is picked up again.
+		// The finished file replaces dest only after it has been verified.
+		dl.part.reset(new PartialDownload(dl.dest));
+		if (!dl.part->Open(dl.etag))
+		{
+			EmitErrorMessage(_("Failed to download ") + dl.url);
+			continue;
+		}
+
+		// If there's nothing to resume and we know what the natives jar should 
+		// hash to, unpack it into the library cache as it comes in.
+		if (isNatives && LibraryCache::IsMD5(dl.md5) && dl.part->GetOffset() == 0)
+		{
+			dl.extractDir = libCache.BeginNatives(dl.md5);
+			dl.extractor.reset(new NativesExtractThread(dl.extractDir));
+			if (dl.extractor->Run() != wxTHREAD_NO_ERROR)
+				dl.extractor.reset();
+		}
+
+		JarDownload *pdl = &dl;
+		dl.curlWrite = [pdl, &totalDownloadedSize, &updateProgress] (void *buffer, size_t size) -> size_t
+		{
+			if (pdl->extractor)
 			{
-				currentDownloadedSize += size;
+				long response = 0;
+				curl_easy_getinfo(pdl->curl, CURLINFO_RESPONSE_CODE, &response);
+				if (response != 200 || !pdl->extractor->Write(buffer, size))
+					return 0;
+
+				pdl->downloadedSize += size;
 				totalDownloadedSize += size;
-				
-				outStream.Write(buffer, size);
-				MD5Update(&md5ctx, (unsigned char*)buffer, size);
-				
-				SetProgress(initialProgress + 
-					((double)totalDownloadedSize / (double)totalDownloadSize) * 
-					(100 - initialProgress - 10));
-				
-				return outStream.LastWrite();
-			};
-			curl_easy_setopt(curl, CURLOPT_WRITEDATA, &curlWrite);
-			
-			wxString headerContent;
-			wxStringOutputStream headerStream(&headerContent);
-			CurlLambdaCallbackFunction curlWriteHeaders = [&] (void *buffer, size_t size) -> size_t
-			{
-				headerStream.Write(buffer, size);
-				return headerStream.LastWrite();
-			};
-			curl_easy_setopt(curl, CURLOPT_HEADERDATA, &curlWriteHeaders);
-			
-			int errorCode = curl_easy_perform(curl);
-			curl_easy_cleanup(curl);
-			
-			MD5Final(md5digest, &md5ctx);
-			
-// 			printf("MD5 for file %s: %s\n", 
-// 				   stdStr(currentFile.GetURL()).c_str(),
-// 				   stdStr(Utils::BytesToString(md5digest)).c_str());
-			
-			// Find the "ETag" in the headers
-			const wxString etagHeader = "ETag: \"";
-			
-			size_t etagStart = headerContent.find(etagHeader) + etagHeader.Len();
-			size_t etagEnd = headerContent.find("\"", etagStart) - 1;
-			wxString etag = headerContent.SubString(etagStart, etagEnd);
-			
-			wxString md5sum = Utils::BytesToString(md5digest);
-			
-			// does the etag *look* like an md5 sum?
-			wxRegEx lwjglRegex("^[0-9a-f]{32}$");
-			bool skip_md5_check = !lwjglRegex.Matches(etag);
-			// if it doesn't, we continue, otherwise we compare the etag with the md5sum we calculated
-			if (skip_md5_check || md5sum.IsSameAs(etag, false))
-			{
-				wxString keystr = wxFileName(currentFile.GetPath()).GetName();
-				std::string key(TOASCII(keystr));
-				// ASCII is fine. it's lower case letters and numbers
-				std::string value (TOASCII(etag));
-				etag_store.put<std::string>(key, value);
-				std::ofstream out;
-				out.open(md5File.GetFullPath().mb_str());
-				write_ini(out, etag_store);
-				out.flush();
-				out.close();
+				updateProgress();
+				return size;
 			}
+
+			size_t oldOffset = pdl->part->GetOffset();
+			size_t written = pdl->part->Write(pdl->curl, buffer, size);
+
+			// The part file may have been started over.
+			totalDownloadedSize += pdl->part->GetOffset() - oldOffset;
+			pdl->downloadedSize = pdl->part->GetOffset();
+			updateProgress();
+
+			return written;
+		};
+		dl.curl = InitCurlHandle();
+		curl_easy_setopt(dl.curl, CURLOPT_URL, TOASCII(dl.url));
+		curl_easy_setopt(dl.curl, CURLOPT_WRITEFUNCTION, CurlLambdaCallback);
+		curl_easy_setopt(dl.curl, CURLOPT_WRITEDATA, &dl.curlWrite);
+		curl_easy_setopt(dl.curl, CURLOPT_HEADERFUNCTION, CurlLambdaCallback);
+		curl_easy_setopt(dl.curl, CURLOPT_HEADERDATA, &dl.curlWriteHeaders);
+
+		if (startDownload(dl))
+			handles.push_back(dl.curl);
+	}
+	updateProgress();
+
+	SetState(STATE_DOWNLOADING, wxString::Format(_("%i files"), (int)handles.size()));
+
+	CurlMultiPerform(handles, maxConnections, [&] (CURL *handle, CURLcode result) -> bool
+	{
+		JarDownload *found = nullptr;
+		for (size_t i = 0; i < downloads.size() && !found; i++)
+		{
+			if (downloads[i].curl == handle)
+				found = &downloads[i];
+		}
+		if (!found)
+			return false;
+		JarDownload &dl = *found;
+
+		if (dl.extractor)
+		{
+			wxString md5sum;
+			bool extracted = false;
+			if (result == CURLE_OK)
+				extracted = dl.extractor->Finish(&md5sum) && md5sum.IsSameAs(dl.md5, false);
 			else
+				dl.extractor->Abort();
+			dl.extractor.reset();
+
+			if (extracted && libCache.CommitNatives(dl.md5, dl.extractDir))
+			{
+				dl.part->Discard();
+				storeETag(dl, dl.md5);
+				libCache.SetURLHash(dl.url, dl.md5);
+				return false;
+			}
+
+			// Fall back to downloading the jar to disk, which can be resumed.
+			fsutils::RecursiveDelete(dl.extractDir.GetFullPath());
+			return startDownload(dl);
+		}
+
+		// Keep what we have and continue from there.
+		if (result != CURLE_OK)
+		{
+			dl.part->SaveState();
+			return startDownload(dl);
+		}
+
+		dl.part->Finish();
+
+		wxString etag = GetETagFromHeaders(dl.headerContent);
+		if (etag.IsEmpty())
+			etag = dl.etag;
+		wxString md5sum = dl.part->GetMD5();
+		
+		// does the etag *look* like an md5 sum?
+		wxRegEx lwjglRegex("^[0-9a-f]{32}$");
+		bool skip_md5_check = !lwjglRegex.Matches(etag);
+		// if it doesn't, we continue, otherwise we compare the etag with the md5sum we calculated
+		if ((skip_md5_check || md5sum.IsSameAs(etag, false)) && dl.part->Commit())
+		{
+			storeETag(dl, etag);
+
+			// Only files with a verified checksum go into the library cache.
+			if (!skip_md5_check)
 			{
-				totalDownloadedSize -= currentDownloadedSize;
-				goto DownloadFile;
+				dl.md5 = md5sum.Lower();
+				libCache.AddFile(dl.md5, dl.dest.GetFullPath());
+				libCache.SetURLHash(dl.url, dl.md5);
 			}
+			return false;
+		}
+
+		// The file is corrupt. Try again from the start.
+		dl.part->Reset();
+		return startDownload(dl);
+	});
+
+	for (size_t i = 0; i < downloads.size(); i++)
+	{
+		if (downloads[i].extractor)
+		{
+			downloads[i].extractor->Abort();
+			fsutils::RecursiveDelete(downloads[i].extractDir.GetFullPath());
 		}
+		if (downloads[i].curl)
+			curl_easy_cleanup(downloads[i].curl);
 	}
+
+	// The natives jar is always the last one.
+	m_nativesMD5 = downloads.empty() ? wxString() : downloads.back().md5;
 }
 
 void GameUpdateTask::ExtractNatives()
@@ -348,20 +627,56 @@ void GameUpdateTask::ExtractNatives()
 	
 	if (!nativesDir.DirExists())
 		nativesDir.Mkdir();
-	
+
+	// Natives are extracted into the library cache once and linked from there.
+	LibraryCache &libCache = LibraryCache::Instance();
+	if (LibraryCache::IsMD5(m_nativesMD5))
+	{
+		if (!libCache.HasNatives(m_nativesMD5) && nativesJar.FileExists())
+		{
+			wxFileName extractDir = libCache.BeginNatives(m_nativesMD5);
+			if (ExtractNativesTo(nativesJar, extractDir))
+				libCache.CommitNatives(m_nativesMD5, extractDir);
+			else
+				fsutils::RecursiveDelete(extractDir.GetFullPath());
+		}
+
+		if (libCache.LinkNatives(m_nativesMD5, nativesDir))
+			return;
+	}
+
+	ExtractNativesTo(nativesJar, nativesDir);
+}
+
+bool GameUpdateTask::ExtractNativesTo(const wxFileName &nativesJar, const wxFileName &nativesDir)
+{
 	wxFileInputStream jarFileStream(nativesJar.GetFullPath());
-	wxZipInputStream zipStream(jarFileStream);
-	
-	std::auto_ptr<wxZipEntry> entry;
-	while (entry.reset(zipStream.GetNextEntry()), entry.get() != NULL)
+	if (!jarFileStream.IsOk())
+		return false;
+	SetState(STATE_EXTRACTING_PACKAGES, nativesJar.GetFullName());
+	return ExtractNativesStream(jarFileStream, nativesDir);
+}
+
+// Returns the MD5 sum of the given file or an empty string if it can't be read.
+static wxString FileMD5(const wxString &path)
+{
+	wxFFileInputStream fileIn(path);
+	if (!fileIn.IsOk())
+		return wxEmptyString;
+
+	MD5Context md5ctx;
+	MD5Init(&md5ctx);
+
+	char buf[64 * 1024];
+	while (!fileIn.Eof())
 	{
-		if (entry->IsDir() || entry->GetInternalName().Contains("META-INF"))
-			continue;
-		SetState(STATE_EXTRACTING_PACKAGES, entry->GetName());
-		wxFileName destFile(Path::Combine(nativesDir, entry->GetName()));
-		wxFileOutputStream outStream(destFile.GetFullPath());
-		outStream.Write(zipStream);
+		fileIn.Read(buf, sizeof(buf));
+		MD5Update(&md5ctx, (unsigned char*)buf, fileIn.LastRead());
 	}
+
+	unsigned char md5digest[16];
+	MD5Final(md5digest, &md5ctx);
+	return Utils::BytesToString(md5digest);
 }
 
 bool GameUpdateTask::DownloadPatches(const wxString& mcVersion)
@@ -387,7 +702,19 @@ bool GameUpdateTask::DownloadPatches(const wxString& mcVersion)
 	curl_easy_setopt(curl, CURLOPT_URL, TOASCII(downloadURL));
 	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlLambdaCallback);
 
-	wxFFileOutputStream outStream(dest);
+	// Patches don't change once published, so only fetch it again if the
+	// server has a newer one than what we got last time.
+	wxDateTime lastModified;
+	bool haveOld = wxFileExists(dest) && wxFileName(dest).GetTimes(nullptr, &lastModified, nullptr);
+	if (haveOld)
+	{
+		curl_easy_setopt(curl, CURLOPT_TIMECONDITION, (long)CURL_TIMECOND_IFMODSINCE);
+		curl_easy_setopt(curl, CURLOPT_TIMEVALUE, (long)lastModified.GetTicks());
+	}
+
+	// Write to a temporary file so a failed download doesn't clobber the old patch.
+	wxString tmpDest = dest + ".tmp";
+	wxFFileOutputStream outStream(tmpDest);
 	CurlLambdaCallbackFunction curlWrite = [&] (void *buffer, size_t size) -> size_t
 	{
 		outStream.Write(buffer, size);
@@ -401,19 +728,36 @@ bool GameUpdateTask::DownloadPatches(const wxString& mcVersion)
 	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
 
 	curl_easy_cleanup(curl);
+	outStream.Close();
 
 	if (curlErr != 0)
 	{
+		wxRemoveFile(tmpDest);
 		wxLogError(_("Failed to download patch %s."), patchFilename.c_str());
 		return false;
 	}
 
+	// Not modified, the patch we already have is fine.
+	if (haveOld && responseCode == 304)
+	{
+		wxRemoveFile(tmpDest);
+		return true;
+	}
+
 	// If the response code isn't between 200 and 300
-	if (responseCode < 200 || responseCode >= 400)
+	if (responseCode < 200 || responseCode >= 300)
 	{
+		wxRemoveFile(tmpDest);
 		wxLogError(_("Patch %s failed to download with HTTP response code %i."), patchFilename.c_str(), responseCode);
+		return false;
 	}
 
+	if (!wxRenameFile(tmpDest, dest, true))
+	{
+		wxRemoveFile(tmpDest);
+		wxLogError(_("Failed to save patch %s."), patchFilename.c_str());
+		return false;
+	}
 	return true;
 }
 
@@ -436,28 +780,39 @@ bool GameUpdateTask::ApplyPatches(wxString versionID)
 	if (wxFileExists(patchDest))
 		wxRemoveFile(patchDest);
 
-	int err = bspatch(patchSrc.char_str(), patchDest.char_str(), patchFile.char_str());
+	// Patching the same jar with the same patch always gives the same jar, so
+	// if any instance has done this before, just link in what it got.
+	LibraryCache &libCache = LibraryCache::Instance();
+	wxString srcMD5 = FileMD5(patchSrc);
+	wxString patchMD5 = FileMD5(patchFile);
+	wxString resultMD5 = libCache.GetPatchResult(srcMD5, patchMD5);
 
-	if (err == ERR_NONE)
+	if (!libCache.LinkFile(resultMD5, "minecraft.jar", patchDest))
 	{
-		wxRemoveFile(patchSrc);
-		wxRename(patchDest, patchSrc);
-	}
-	else
-	{
-		switch (err)
+		int err = bspatch(patchSrc.char_str(), patchDest.char_str(), patchFile.char_str());
+		if (err != ERR_NONE)
 		{
-		case ERR_CORRUPT_PATCH:
-			wxLogError(_("Failed to patch %s.jar. Patch is corrupt."), file.c_str());
-			break;
+			switch (err)
+			{
+			case ERR_CORRUPT_PATCH:
+				wxLogError(_("Failed to patch %s.jar. Patch is corrupt."), file.c_str());
+				break;
 
-		default:
-			wxLogError(_("Failed to patch %s.jar. Unknown error %i."), file.c_str(), err);
-			break;
+			default:
+				wxLogError(_("Failed to patch %s.jar. Unknown error %i."), file.c_str(), err);
+				break;
+			}
+			return false;
 		}
-		return false;
+
+		resultMD5 = FileMD5(patchDest);
+		if (libCache.AddFile(resultMD5, patchDest, "minecraft.jar"))
+			libCache.SetPatchResult(srcMD5, patchMD5, resultMD5);
 	}
 
+	wxRemoveFile(patchSrc);
+	wxRename(patchDest, patchSrc);
+	m_patchedMD5 = resultMD5;
 	return true;
 }
 
@@ -483,23 +838,14 @@ bool GameUpdateTask::VerifyPatchedFiles(MCVersion *ver)
 			cFileName = "mcbackup";
 		wxString checkFile = Path::Combine(m_inst->GetBinDir(), cFileName + ".jar");
 
-		// Verify the file's MD5 sum.
-		MD5Context md5ctx;
-		MD5Init(&md5ctx);
-
-		char buf[1024];
-		wxFFileInputStream fileIn(checkFile);
-
-		while (!fileIn.Eof())
-		{
-			fileIn.Read(buf, 1024);
-			MD5Update(&md5ctx, (unsigned char*)buf, fileIn.LastRead());
-		}
-
-		unsigned char md5digest[16];
-		MD5Final(md5digest, &md5ctx);
+		// Verify the file's MD5 sum. ApplyPatches already knows it for the jar it produced.
+		wxString md5;
+		if (patchFiles[i] == "minecraft")
+			md5 = m_patchedMD5;
+		if (md5.IsEmpty())
+			md5 = FileMD5(checkFile);
 
-		if (!Utils::BytesToString(md5digest).IsSameAs(ver->GetEtag()), false)
+		if (!md5.IsSameAs(ver->GetEtag(), false))
 		{
 			wxLogWarning(_("The MD5 sum of %s didn't match what it was supposed to be after patching!"), 
 				wxFileName(checkFile).GetFullName().c_str());
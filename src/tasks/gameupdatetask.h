@@ -41,21 +41,32 @@ enum UpdateState
 class GameUpdateTask : public Task
 {
 public:
-	GameUpdateTask(Instance *inst, int64_t latestVersion, bool forceUpdate);
+	// The jars are downloaded from jarBaseURL if it's given, and from Mojang's servers 
+	// otherwise. Used to test against a local server (see tools/test/jarserver.py).
+	GameUpdateTask(Instance *inst, int64_t latestVersion, bool forceUpdate,
+		const wxString &jarBaseURL = wxEmptyString);
 	virtual ~GameUpdateTask();
 	
 protected:
 	Instance *m_inst;
 	int64_t m_latestVersion;
 	bool m_forceUpdate;
+	wxString m_jarBaseURL;
 	
 	bool m_shouldUpdate;
 	
 	std::vector<wxString> jarURLs;
+
+	// MD5 sum of the natives jar, if it could be determined.
+	wxString m_nativesMD5;
+
+	// MD5 sum of the jar produced by ApplyPatches.
+	wxString m_patchedMD5;
 	
 	virtual ExitCode TaskStart();
 	virtual void DownloadJars();
 	virtual void ExtractNatives();
+	bool ExtractNativesTo(const wxFileName &nativesJar, const wxFileName &nativesDir);
 	
 	bool RetrievePatchBaseURL(const wxString& mcVersion, wxString *patchURL);
 	bool DownloadPatches(const wxString& mcVersion);
@@ -0,0 +1,157 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "loadinstancestask.h"
+#include "instance.h"
+#include "instanceindex.h"
+#include "utils/apputils.h"
+#include "utils/parallel.h"
+
+#include <wx/dir.h>
+#include <wx/time.h>
+#include <wx/filefn.h>
+
+DEFINE_EVENT_TYPE(wxEVT_INSTANCES_LOADED)
+
+// Send a batch once it has this many instances or is this old (in ms).
+const size_t maxBatchSize = 32;
+const wxLongLong maxBatchAge = 100;
+
+LoadInstancesTask::LoadInstancesTask(const wxFileName &instDir, const wxString &groupFile)
+	: Task(), m_instDir(instDir), m_groupFile(groupFile), m_instCount(0), m_cancelled(false)
+{
+	
+}
+
+wxThread::ExitCode LoadInstancesTask::TaskStart()
+{
+	SetStatus(_("Loading instances..."));
+
+	// The index lets us skip reading the group file and every unchanged instance.cfg.
+	wxString indexPath = Path::Combine(m_instDir, "instindex");
+	InstanceIndex oldIndex;
+	bool haveIndex = wxFileExists(indexPath) && oldIndex.Load(indexPath);
+	InstanceIndex newIndex;
+	bool indexChanged = !haveIndex;
+
+	// Groups go first, so instances land in the right group as they show up.
+	InstancesLoadedEvent groupEvent(this, InstVector());
+	int64_t groupMTime = wxFileExists(m_groupFile) ? wxFileModificationTime(m_groupFile) : -1;
+	if (haveIndex && groupMTime == oldIndex.GetGroupFileMTime())
+	{
+		groupEvent.m_hasGroupInfo = groupMTime != -1;
+		groupEvent.m_groupInfo = oldIndex.GetGroupInfo();
+	}
+	else
+	{
+		groupEvent.m_hasGroupInfo = groupMTime != -1 && 
+			InstanceModel::ReadGroupInfo(m_groupFile, groupEvent.m_groupInfo);
+		indexChanged = true;
+	}
+	newIndex.SetGroupInfo(groupEvent.m_groupInfo, groupMTime);
+	m_evtHandler->AddPendingEvent(groupEvent);
+
+	wxArrayString instDirs;
+	wxDir dir(m_instDir.GetFullPath());
+	if (!dir.IsOpened())
+		return (ExitCode)0;
+
+	wxString subFolder;
+	bool cont = dir.GetFirst(&subFolder, wxEmptyString, wxDIR_DIRS);
+	while (cont)
+	{
+		instDirs.Add(Path::Combine(m_instDir, subFolder));
+		cont = dir.GetNext(&subFolder);
+	}
+
+	m_lastSendTime = wxGetLocalTimeMillis();
+	ParallelFor(instDirs.size(), GetIOThreadCount(), [&] (size_t i)
+	{
+		if (IsCancelled() || !IsValidInstance(instDirs[i]))
+			return;
+
+		InstanceMetadata meta;
+		meta.Stat(instDirs[i]);
+		const InstanceMetadata *cached = oldIndex.Find(meta.id);
+		bool upToDate = cached && meta.SameFiles(*cached);
+
+		Instance *inst = Instance::LoadInstance(instDirs[i], upToDate ? cached : nullptr);
+		if (inst == NULL)
+			return;
+
+		// Read the metadata before the main thread gets the instance. The index
+		// keeps its own copy, the instance's strings belong to the main thread.
+		if (!upToDate)
+			meta = inst->GetMetadata().Clone();
+
+		{
+			wxMutexLocker lock(m_indexLock);
+			newIndex.Set(upToDate ? *cached : meta);
+			if (!upToDate)
+				indexChanged = true;
+		}
+		AddLoaded(inst);
+	});
+
+	{
+		wxMutexLocker lock(m_batchLock);
+		SendBatch();
+	}
+
+	// Instances that were removed drop out of the index too.
+	if (!IsCancelled() && (indexChanged || newIndex.GetInstanceCount() != oldIndex.GetInstanceCount()))
+		newIndex.Save(indexPath);
+	return (ExitCode)1;
+}
+
+void LoadInstancesTask::AddLoaded(Instance *inst)
+{
+	wxMutexLocker lock(m_batchLock);
+	m_batch.push_back(inst);
+	m_instCount++;
+
+	if (m_batch.size() >= maxBatchSize || wxGetLocalTimeMillis() - m_lastSendTime >= maxBatchAge)
+		SendBatch();
+}
+
+void LoadInstancesTask::SendBatch()
+{
+	if (m_batch.empty())
+		return;
+
+	InstancesLoadedEvent event(this, m_batch);
+	m_evtHandler->AddPendingEvent(event);
+
+	m_batch.clear();
+	m_lastSendTime = wxGetLocalTimeMillis();
+}
+
+void LoadInstancesTask::Cancel()
+{
+	wxMutexLocker lock(m_batchLock);
+	m_cancelled = true;
+}
+
+bool LoadInstancesTask::IsCancelled()
+{
+	wxMutexLocker lock(m_batchLock);
+	return m_cancelled;
+}
+
+int LoadInstancesTask::GetInstanceCount() const
+{
+	return m_instCount;
+}
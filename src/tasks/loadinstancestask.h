@@ -0,0 +1,79 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#pragma once
+#include "task.h"
+#include "instancemodel.h"
+
+#include <wx/filename.h>
+
+DECLARE_EVENT_TYPE(wxEVT_INSTANCES_LOADED, -1)
+
+// Finds and loads all instances in the instance folder on a pool of worker threads.
+// Loaded instances are sent to the event handler in batches as they come in.
+class LoadInstancesTask : public Task
+{
+public:
+	LoadInstancesTask(const wxFileName &instDir, const wxString &groupFile);
+	
+	virtual ExitCode TaskStart();
+	
+	// Stop loading. Instances that are already loaded are still sent.
+	void Cancel();
+	bool IsCancelled();
+
+	int GetInstanceCount() const;
+	
+protected:
+	// Queue a loaded instance, sending the batch if it's big or old enough.
+	void AddLoaded(Instance *inst);
+	void SendBatch();
+
+	wxFileName m_instDir;
+	wxString m_groupFile;
+	int m_instCount;
+	bool m_cancelled;
+
+	wxMutex m_batchLock;
+	wxMutex m_indexLock;
+	InstVector m_batch;
+	wxLongLong m_lastSendTime;
+};
+
+struct InstancesLoadedEvent : TaskEvent
+{
+	InstancesLoadedEvent(Task *task, const InstVector &instances)
+		: TaskEvent(wxEVT_INSTANCES_LOADED, task), m_instances(instances), m_hasGroupInfo(false) {}
+	
+	// Instances loaded since the last event. The receiver owns them.
+	InstVector m_instances;
+
+	// The first event carries the parsed group file.
+	bool m_hasGroupInfo;
+	InstanceGroupInfo m_groupInfo;
+	
+	// The group names are used on the main thread, so they are cloned.
+	virtual wxEvent *Clone() const
+	{
+		InstancesLoadedEvent *event = new InstancesLoadedEvent(*this);
+		event->m_groupInfo = m_groupInfo.Clone();
+		return event;
+	}
+};
+
+typedef void (wxEvtHandler::*InstancesLoadedEventFunction)(InstancesLoadedEvent&);
+
+#define EVT_INSTANCES_LOADED(fn) EVT_TASK_CUSTOM(wxEVT_INSTANCES_LOADED, fn, InstancesLoadedEventFunction)
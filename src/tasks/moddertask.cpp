@@ -38,6 +38,7 @@ wxThread::ExitCode ModderTask::TaskStart()
 	wxFileName mcBin = m_inst->GetBinDir();
 	wxFileName mcJar = m_inst->GetMCJar();
 	wxFileName mcBackup = m_inst->GetMCBackup();
+	wxFileName manifestFile = m_inst->GetMCJarManifest();
 	
 	// Nothing to do if there are no jar mods to install, no backup and just the mc jar
 	if(mcJar.FileExists() && !mcBackup.FileExists() && modList->empty())
@@ -53,95 +54,190 @@ wxThread::ExitCode ModderTask::TaskStart()
 		return (ExitCode)0;
 	}
 	
-	if (mcJar.FileExists() && !wxRemoveFile(mcJar.GetFullPath()))
-	{
-		OnFail(_("Failed to delete old minecraft.jar"));
-		return (ExitCode)0;
-	}
-	
 	// TODO: good spot for user cancel check? or not...
 	
 	TaskStep(); // STEP 1
-	SetStatus(_("Installing mods - Opening minecraft.jar"));
+	SetStatus(_("Installing mods - Checking for changes..."));
 
-	wxFFileOutputStream jarStream(mcJar.GetFullPath());
-	wxZipOutputStream zipOut(jarStream);
+	// Entries of the current minecraft.jar can only be reused if it is
+	// still the jar the manifest was written for.
+	JarManifest oldManifest;
+	if (!mcJar.FileExists() || !oldManifest.Load(manifestFile.GetFullPath()) ||
+		!oldManifest.MatchesJar(mcJar))
+	{
+		oldManifest.sources.clear();
+	}
 
-	// Files already added to the jar.
-	// These files will be skipped.
-	std::set<wxString> addedFiles;
+	// Mods later in the list override earlier ones and the backup comes last.
+	JarManifest newManifest;
+	for (ModList::const_reverse_iterator iter = modList->rbegin(); iter != modList->rend(); iter++)
+	{
+		wxFileName modFileName = iter->GetFileName();
+		if (iter->GetModType() == Mod::ModType::MOD_ZIPFILE)
+		{
+			JarManifest::Source src(JarManifest::SOURCE_ZIPFILE, modFileName.GetFullPath());
+			if (ReadSource(src, oldManifest))
+				newManifest.sources.push_back(src);
+		}
+		else
+		{
+			wxFileName destFileName = modFileName;
+			destFileName.MakeRelativeTo(m_inst->GetInstModsDir().GetFullPath());
+
+			JarManifest::Source src(JarManifest::SOURCE_SINGLEFILE, modFileName.GetFullPath());
+			if (ReadSource(src, oldManifest, destFileName.GetFullPath()))
+				newManifest.sources.push_back(src);
+		}
+	}
+
+	{
+		JarManifest::Source src(JarManifest::SOURCE_BACKUP, mcBackup.GetFullPath());
+		if (!ReadSource(src, oldManifest))
+		{
+			OnFail(_("Failed to read mcbackup.jar"));
+			return (ExitCode)0;
+		}
+		newManifest.sources.push_back(src);
+	}
+
+	JarManifest::OwnerMap newOwners = newManifest.GetEntryOwners();
+	JarManifest::OwnerMap oldOwners = oldManifest.GetEntryOwners();
+
+	// An entry is copied over from the current jar if it still comes from
+	// the same source and that source's copy of it didn't change.
+	std::set<wxString> reusedFiles;
+	for (auto iter = newOwners.begin(); iter != newOwners.end(); ++iter)
+	{
+		auto oldIter = oldOwners.find(iter->first);
+		if (oldIter == oldOwners.end())
+			continue;
+
+		const JarManifest::Source &newSrc = newManifest.sources[iter->second.source];
+		const JarManifest::Source &oldSrc = oldManifest.sources[oldIter->second.source];
+		if (newSrc.path != oldSrc.path)
+			continue;
+
+		const JarManifest::Entry *newEntry = iter->second.entry;
+		const JarManifest::Entry *oldEntry = oldIter->second.entry;
+		if (newSrc.SameFile(oldSrc) || (newSrc.type != JarManifest::SOURCE_SINGLEFILE &&
+			newEntry->crc == oldEntry->crc && newEntry->size == oldEntry->size))
+		{
+			reusedFiles.insert(iter->first);
+		}
+	}
 
 	// Modify the jar
 	TaskStep(); // STEP 2
 	SetStatus(_("Installing mods - Adding mod files..."));
-	for (ModList::const_reverse_iterator iter = modList->rbegin(); iter != modList->rend(); iter++)
+
+	wxString tmpJar = mcJar.GetFullPath() + ".tmp";
+	bool success = true;
 	{
-		wxFileName modFileName = iter->GetFileName();
-		SetStatus(_("Installing mods - Adding ") + modFileName.GetFullName());
-		if (iter->GetModType() == Mod::ModType::MOD_ZIPFILE)
+		wxFFileOutputStream jarStream(tmpJar);
+		wxZipOutputStream zipOut(jarStream);
+
+		// Files already added to the jar.
+		// These files will be skipped.
+		std::set<wxString> addedFiles;
+
+		// Unchanged entries are copied without recompressing them.
+		if (!reusedFiles.empty())
 		{
-			wxFFileInputStream modStream(modFileName.GetFullPath());
-			wxZipInputStream zipStream(modStream);
+			wxFFileInputStream inStream(mcJar.GetFullPath());
+			wxZipInputStream zipIn(inStream);
+
 			std::unique_ptr<wxZipEntry> entry;
-			while (entry.reset(zipStream.GetNextEntry()), entry.get() != NULL)
+			while (success && (entry.reset(zipIn.GetNextEntry()), entry.get() != NULL))
 			{
-				if (entry->IsDir())
-					continue;
-
 				wxString name = entry->GetName();
-				if (addedFiles.count(name) == 0)
+				if (reusedFiles.count(name) != 0 && addedFiles.count(name) == 0)
 				{
-					if (!zipOut.CopyEntry(entry.release(), zipStream))
-						break;
+					success = zipOut.CopyEntry(entry.release(), zipIn);
 					addedFiles.insert(name);
 				}
 			}
 		}
-		else
+
+		// Everything else is read from the sources that own it.
+		for (size_t i = 0; success && i < newManifest.sources.size(); i++)
 		{
-			wxFileName destFileName = modFileName;
-			destFileName.MakeRelativeTo(m_inst->GetInstModsDir().GetFullPath());
-			wxString destFile = destFileName.GetFullPath();
+			const JarManifest::Source &src = newManifest.sources[i];
 
-			if (addedFiles.count(destFile) == 0)
+			std::set<wxString> missingFiles;
+			for (auto entry = src.entries.begin(); entry != src.entries.end(); ++entry)
 			{
-				wxFFileInputStream input(modFileName.GetFullPath());
-				zipOut.PutNextEntry(destFile);
-				zipOut.Write(input);
+				if (newOwners[entry->name].source == i && addedFiles.count(entry->name) == 0)
+					missingFiles.insert(entry->name);
+			}
 
-				addedFiles.insert(destFile);
+			if (missingFiles.empty())
+				continue;
+
+			SetStatus(_("Installing mods - Adding ") + wxFileName(src.path).GetFullName());
+			if (src.type == JarManifest::SOURCE_SINGLEFILE)
+			{
+				wxFFileInputStream input(src.path);
+				zipOut.PutNextEntry(src.entries[0].name);
+				zipOut.Write(input);
+				addedFiles.insert(src.entries[0].name);
+			}
+			else
+			{
+				wxFFileInputStream modStream(src.path);
+				wxZipInputStream zipStream(modStream);
+				std::unique_ptr<wxZipEntry> entry;
+				while (success && (entry.reset(zipStream.GetNextEntry()), entry.get() != NULL))
+				{
+					wxString name = entry->GetName();
+					if (missingFiles.count(name) != 0 && addedFiles.count(name) == 0)
+					{
+						success = zipOut.CopyEntry(entry.release(), zipStream);
+						addedFiles.insert(name);
+					}
+				}
 			}
 		}
+
+		if (!zipOut.Close() || !jarStream.Close())
+			success = false;
 	}
 
+	if (!success)
 	{
-		wxFFileInputStream inStream(mcBackup.GetFullPath());
-		wxZipInputStream zipIn(inStream);
-
-		std::auto_ptr<wxZipEntry> entry;
-		while (entry.reset(zipIn.GetNextEntry()), entry.get() != NULL)
-		{
-			wxString name = entry->GetName();
+		wxRemoveFile(tmpJar);
+		OnFail(_("Failed to write minecraft.jar"));
+		return (ExitCode)0;
+	}
 
-			if (!name.Matches("META-INF*") &&
-				addedFiles.count(name) == 0)
-			{
-				if (!zipOut.CopyEntry(entry.release(), zipIn))
-					break;
-				addedFiles.insert(name);
-			}
-		}
+	if (!wxRenameFile(tmpJar, mcJar.GetFullPath(), true))
+	{
+		wxRemoveFile(tmpJar);
+		OnFail(_("Failed to replace old minecraft.jar"));
+		return (ExitCode)0;
 	}
 	
-	// Recompress the jar
 	TaskStep(); // STEP 3
-	SetStatus(_("Installing mods - Recompressing jar..."));
+	SetStatus(_("Installing mods - Saving jar manifest..."));
+
+	newManifest.SetJar(mcJar);
+	if (!newManifest.Save(manifestFile.GetFullPath()))
+		wxRemoveFile(manifestFile.GetFullPath());
 
 	m_inst->SetNeedsRebuild(false);
 	m_inst->UpdateVersion(true);
 	return (ExitCode)1;
 }
 
+bool ModderTask::ReadSource(JarManifest::Source &src, const JarManifest &oldManifest, const wxString &entryName)
+{
+	const JarManifest::Source *oldSrc = oldManifest.FindSource(src.path);
+	if (oldSrc != nullptr && src.Stat() && oldSrc->SameFile(src))
+	{
+		src.entries = oldSrc->entries;
+		return true;
+	}
+	return src.Scan(entryName);
+}
 
 void ModderTask::TaskStep()
 {
@@ -17,6 +17,7 @@
 #pragma once
 #include "task.h"
 #include <instance.h>
+#include <jarmanifest.h>
 
 class ModderTask : public Task
 {
@@ -30,6 +31,9 @@ protected:
 	
 	void OnFail(const wxString &errorMsg);
 
+	// Fills in the source's entries, taking them from the old manifest if the file didn't change.
+	bool ReadSource(JarManifest::Source &src, const JarManifest &oldManifest, const wxString &entryName = wxEmptyString);
+
 	void TaskStep();
 	int step;
 };
\ No newline at end of file
@@ -16,13 +16,9 @@
 
 #include "newschecktask.h"
 
-#include <boost/property_tree/xml_parser.hpp>
-#include <boost/foreach.hpp>
-
-#include <sstream>
-
 #include "utils/httputils.h"
 #include "utils/apputils.h"
+#include "utils/feedparser.h"
 
 const wxString rssURL = "http://news.forkk.net/feed/rss2";
 
@@ -37,47 +33,42 @@ wxThread::ExitCode NewsCheckTask::TaskStart()
 	m_latestPostTitle = _("Failed to load news RSS feed. Click here to go to the dev blog's homepage.");
 	m_latestPostURL = _("http://forkk.net/mmcnews.php");
 
-	// Attempt to get the RSS feed.
-	wxString rssXML = wxEmptyString;
-	bool failed = false;
-	if (!DownloadString(rssURL, &rssXML))
+	// Only the first item is needed, so stop reading the feed once it's there.
+	XmlStreamParser parser;
+	std::string title;
+	std::string link;
+	int fields = 0;
+	bool found = false;
+	parser.onStartElement = [&] (const std::string &path)
 	{
-		failed = true;
-	}
-	using namespace boost::property_tree;
-	if (!failed)
-		try
+		if (path == "rss/channel/item")
+			fields = 0;
+	};
+	parser.onEndElement = [&] (const std::string &path, const std::string &text)
 	{
-		ptree pt;
-		std::stringstream inStream(stdStr(rssXML), std::ios::in);
-		read_xml(inStream, pt);
-
-		if (pt.count("rss")) BOOST_FOREACH(const ptree::value_type& v, pt.get_child("rss.channel"))
+		if (path == "rss/channel/item/title")
 		{
-			if (v.first == "item")
-			{
-				auto _title = v.second.get_optional<std::string>("title");
-				auto _link = v.second.get_optional<std::string>("link");
-				if (!_title || !_link)
-					continue;
-
-				m_latestPostTitle = wxStr(_title.get());
-				m_latestPostURL = wxStr(_link.get());
-
-				break;
-			}
+			title = text;
+			fields |= 1;
 		}
-		else
+		else if (path == "rss/channel/item/link")
 		{
-			failed = true;
+			link = text;
+			fields |= 2;
 		}
-	}
-	catch (ptree_error)
-	{
-		failed = true;
-	}
+		else if (path == "rss/channel/item" && fields == 3)
+		{
+			found = true;
+			parser.Stop();
+		}
+	};
+
+	if (!DownloadParsed(rssURL, parser) || !found)
+		return (ExitCode) true;
 
-	return (ExitCode) failed;
+	m_latestPostTitle = wxStr(title);
+	m_latestPostURL = wxStr(link);
+	return (ExitCode) false;
 }
 
 wxString NewsCheckTask::GetLatestPostTitle() const
@@ -19,11 +19,26 @@
 #include <wx/wfstream.h>
 #include <wx/dir.h>
 
+#include <wx/mstream.h>
+
 #include "utils/apputils.h"
 #include "utils/fsutils.h"
+#include "utils/parallel.h"
 
 #include <set>
 #include <memory>
+#include <vector>
+#include <algorithm>
+
+// Extensions of files that are already compressed. These are stored as they are.
+static const char *storedExtensions[] = { "png", "jpg", "zip", "jar", "gz", "ogg", "mp3" };
+
+// Files are zipped in parallel in batches of at most this many files and bytes.
+const size_t maxBatchFiles = 256;
+const wxULongLong maxBatchSize = 128 * 1024 * 1024;
+
+// Bigger files are zipped one by one on the task thread.
+const wxULongLong maxParallelFileSize = 32 * 1024 * 1024;
 
 ZipTask::ZipTask(wxOutputStream *out, const wxString &path)
 {
@@ -64,6 +79,42 @@ bool ZipTask::DiscoverFiles(const wxString &path, wxArrayString &fileList)
 	return true;
 }
 
+bool ZipTask::IsCompressed(const wxString &file)
+{
+	wxString ext = wxFileName(file).GetExt().Lower();
+	for (size_t i = 0; i < sizeof(storedExtensions) / sizeof(storedExtensions[0]); i++)
+	{
+		if (ext == storedExtensions[i])
+			return true;
+	}
+	return false;
+}
+
+wxString ZipTask::GetEntryName(const wxString &file) const
+{
+	wxFileName destFile(file);
+	destFile.MakeRelativeTo(m_path);
+	return destFile.GetFullPath();
+}
+
+wxZipEntry *ZipTask::MakeEntry(const wxString &file, const wxString &name)
+{
+	wxZipEntry *entry = new wxZipEntry(name);
+	// Deflating these again costs a lot of time and saves nothing.
+	if (IsCompressed(file))
+		entry->SetMethod(wxZIP_METHOD_STORE);
+	return entry;
+}
+
+void ZipTask::CompressEntry(const wxString &file, const wxString &name, wxMemoryOutputStream &out)
+{
+	wxZipOutputStream zipStream(out);
+	zipStream.PutNextEntry(MakeEntry(file, name));
+	wxFFileInputStream inStream(file);
+	zipStream.Write(inStream);
+	zipStream.Close();
+}
+
 wxThread::ExitCode ZipTask::TaskStart()
 {
 	SetStatus("Searching for files...");
@@ -72,21 +123,72 @@ wxThread::ExitCode ZipTask::TaskStart()
 	if (!DiscoverFiles(m_path, fileList))
 		return (ExitCode)0;
 	
-	int ctr = 0;
 	wxZipOutputStream zipStream(*m_out);
-	for (wxArrayString::iterator iter = fileList.begin(); iter != fileList.end(); ++iter, ctr++)
+
+	// Files are compressed in batches on a worker pool, each into its own in-memory zip.
+	// The finished entries are then copied into the real zip in the original order,
+	// without being compressed again. Big files are streamed straight into the zip
+	// so memory use stays bounded.
+	size_t done = 0;
+	while (done < fileList.size())
 	{
-		wxFileName file(*iter);
+		size_t batchEnd = done;
+		wxULongLong batchSize = 0;
+		while (batchEnd < fileList.size() && batchEnd - done < maxBatchFiles && batchSize < maxBatchSize)
+		{
+			wxULongLong size = wxFileName::GetSize(fileList[batchEnd]);
+			if (size == wxInvalidSize || size > maxParallelFileSize)
+				break;
+			batchSize += size;
+			batchEnd++;
+		}
+
+		if (batchEnd == done)
+		{
+			// A big file. Zip it on this thread.
+			wxString name = GetEntryName(fileList[done]);
+			SetStatus(wxT("Zipping ") + name);
+
+			zipStream.PutNextEntry(MakeEntry(fileList[done], name));
+			wxFFileInputStream inStream(fileList[done]);
+			zipStream.Write(inStream);
+			done++;
+			SetProgress(((float)done / (float)fileList.size()) * 100);
+			continue;
+		}
 
-		wxFileName destFile(file);
-		destFile.MakeRelativeTo(m_path);
+		SetStatus(wxString::Format(wxT("Zipping %i files..."), (int)(batchEnd - done)));
 
-		zipStream.PutNextEntry(destFile.GetFullPath());
+		// The workers get their own copies of the strings, wxString's sharing isn't thread safe.
+		std::vector<wxString> files, names;
+		for (size_t i = done; i < batchEnd; i++)
+		{
+			files.push_back(fileList[i].Clone());
+			names.push_back(GetEntryName(fileList[i]).Clone());
+		}
+
+		std::vector<std::unique_ptr<wxMemoryOutputStream>> compressed(batchEnd - done);
+		ParallelFor(compressed.size(), std::max(1, wxThread::GetCPUCount()), [&] (size_t i)
+		{
+			compressed[i].reset(new wxMemoryOutputStream());
+			CompressEntry(files[i], names[i], *compressed[i]);
+		});
+
+		for (size_t i = 0; i < compressed.size(); i++)
+		{
+			wxMemoryInputStream memIn(*compressed[i]);
+			wxZipInputStream entryIn(memIn);
+			wxZipEntry *entry = entryIn.GetNextEntry();
+			if (entry == nullptr || !zipStream.CopyEntry(entry, entryIn))
+			{
+				EmitErrorMessage(_("Failed to add a file to the zip."));
+				return (ExitCode)0;
+			}
+			compressed[i].reset();
+		}
 
-		SetStatus(wxT("Zipping ") + destFile.GetFullPath());
-		wxFFileInputStream inStream(file.GetFullPath());
-		zipStream.Write(inStream);
-		SetProgress(((float)ctr / (float)fileList.size()) * 100);
+		done = batchEnd;
+		SetProgress(((float)done / (float)fileList.size()) * 100);
 	}
 
 	return (ExitCode)1;
@@ -20,6 +20,7 @@
 #include <wx/string.h>
 #include <wx/stream.h>
 #include <wx/zipstrm.h>
+#include <wx/mstream.h>
 
 class ZipTask : public Task
 {
@@ -33,4 +34,16 @@ protected:
 	wxOutputStream *m_out;
 
 	bool DiscoverFiles(const wxString &path, wxArrayString &fileList);
+
+	// True for files that don't get any smaller when deflated.
+	static bool IsCompressed(const wxString &file);
+
+	// Name of the file's zip entry, relative to m_path.
+	wxString GetEntryName(const wxString &file) const;
+
+	// Makes the zip entry for the file. Touches no members, so workers can call it.
+	static wxZipEntry *MakeEntry(const wxString &file, const wxString &name);
+
+	// Writes a zip with just the given file's entry to out.
+	static void CompressEntry(const wxString &file, const wxString &name, wxMemoryOutputStream &out);
 };
\ No newline at end of file
@@ -17,6 +17,9 @@
 #include "appsettings.h"
 #include "curlutils.h"
 
+#include <deque>
+#include <set>
+
 size_t CurlBlankCallback(void* buffer, size_t size, size_t nmemb, void* userp)
 {
 	return size * nmemb;
@@ -79,3 +82,59 @@ int CurlLambdaProgressCallback(void *clientp, double dltotal, double dlnow, doub
 	auto func = (CurlLambdaProgressCallbackFunction*) clientp;
 	return func->operator()(dltotal, dlnow, ultotal, ulnow);
 }
+
+bool CurlMultiPerform(const std::vector<CURL*> &handles, int maxConnections, CurlMultiDoneFunction onDone)
+{
+	if (maxConnections < 1)
+		maxConnections = 1;
+
+	CURLM *multi = curl_multi_init();
+	if (multi == nullptr)
+		return false;
+
+	std::deque<CURL*> queue(handles.begin(), handles.end());
+	std::set<CURL*> active;
+	bool ok = true;
+	while (ok && (!queue.empty() || !active.empty()))
+	{
+		// Keep the pipe full, up to the connection limit.
+		while (!queue.empty() && (int)active.size() < maxConnections)
+		{
+			curl_multi_add_handle(multi, queue.front());
+			active.insert(queue.front());
+			queue.pop_front();
+		}
+
+		int running = 0;
+		if (curl_multi_perform(multi, &running) != CURLM_OK)
+		{
+			ok = false;
+			continue;
+		}
+
+		CURLMsg *msg;
+		int msgsLeft;
+		while ((msg = curl_multi_info_read(multi, &msgsLeft)) != nullptr)
+		{
+			if (msg->msg != CURLMSG_DONE)
+				continue;
+
+			// msg is freed by curl_multi_remove_handle.
+			CURL *handle = msg->easy_handle;
+			CURLcode result = msg->data.result;
+			curl_multi_remove_handle(multi, handle);
+			active.erase(handle);
+
+			if (onDone && onDone(handle, result))
+				queue.push_back(handle);
+		}
+
+		if (!active.empty() && curl_multi_wait(multi, nullptr, 0, 100, nullptr) != CURLM_OK)
+			ok = false;
+	}
+
+	for (auto iter = active.begin(); iter != active.end(); ++iter)
+		curl_multi_remove_handle(multi, *iter);
+	curl_multi_cleanup(multi);
+	return ok;
+}
@@ -16,6 +16,7 @@
 
 #pragma once
 #include <functional>
+#include <vector>
 #include <curl/curl.h>
 #include <curl/easy.h>
 
@@ -32,3 +33,12 @@ size_t CurlInStreamCallback(void* buffer, size_t size, size_t nmemb, void* userp
 
 // Returns a CURL handle initialized with the default things such as proxy settings.
 CURL* InitCurlHandle();
+
+// Called by CurlMultiPerform when a transfer finishes.
+// Return true to queue the handle again (for example to retry the transfer).
+typedef std::function<bool (CURL *handle, CURLcode result)> CurlMultiDoneFunction;
+
+// Runs all the given easy handles concurrently on a multi handle, with at most
+// maxConnections transfers active at once. Blocks until every transfer is done.
+// The easy handles are not cleaned up.
+bool CurlMultiPerform(const std::vector<CURL*> &handles, int maxConnections, CurlMultiDoneFunction onDone);
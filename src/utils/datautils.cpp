@@ -18,6 +18,7 @@
 #include "datautils.h"
 #include <wx/sstream.h>
 #include <wx/tokenzr.h>
+#include <wx/ffile.h>
 
 template <class T>
 bool VectorContains(const std::vector<T>& vec, const T& value)
@@ -55,3 +56,72 @@ void WriteAllText(wxOutputStream& output, wxString text)
 	wxStringInputStream input(text);
 	output.Write(input);
 }
+
+wxString ReadFileTail(const wxString &path, size_t maxBytes)
+{
+	wxFFile file;
+	if (!file.Open(path, "rb"))
+		return wxEmptyString;
+
+	wxFileOffset length = file.Length();
+	wxFileOffset start = length > (wxFileOffset)maxBytes ? length - maxBytes : 0;
+	if (length <= 0 || !file.Seek(start))
+		return wxEmptyString;
+
+	std::vector<char> buf(length - start);
+	size_t read = file.Read(&buf[0], buf.size());
+
+	// Don't start in the middle of a line, unless the tail is all one line.
+	size_t first = 0;
+	if (start > 0)
+	{
+		while (first < read && buf[first] != '\n')
+			first++;
+		if (first < read)
+			first++;
+		else
+			first = 0;
+	}
+	return wxString(&buf[0] + first, wxConvLibc, read - first);
+}
+
+wxString EscapeField(const wxString &str)
+{
+	wxString escaped;
+	for (size_t i = 0; i < str.Len(); i++)
+	{
+		wxUniChar c = str[i];
+		if (c == '\\')
+			escaped << "\\\\";
+		else if (c == '\t')
+			escaped << "\\t";
+		else if (c == '\n')
+			escaped << "\\n";
+		else if (c == '\r')
+			escaped << "\\r";
+		else
+			escaped << c;
+	}
+	return escaped;
+}
+
+wxString UnescapeField(const wxString &str)
+{
+	wxString unescaped;
+	for (size_t i = 0; i < str.Len(); i++)
+	{
+		wxUniChar c = str[i];
+		if (c == '\\' && i + 1 < str.Len())
+		{
+			c = str[++i];
+			if (c == 't')
+				c = '\t';
+			else if (c == 'n')
+				c = '\n';
+			else if (c == 'r')
+				c = '\r';
+		}
+		unescaped << c;
+	}
+	return unescaped;
+}
@@ -60,3 +60,11 @@ wxString ReadAllText(wxInputStream &input);
 wxArrayString ReadAllLines(wxInputStream &input);
 
 void WriteAllText(wxOutputStream &output, wxString text);
+
+// Reads at most the last maxBytes of a text file, starting at a line boundary
+// if there is one.
+wxString ReadFileTail(const wxString &path, size_t maxBytes);
+
+// Escapes backslashes, tabs and line breaks so the string fits in one field of a tab separated line.
+wxString EscapeField(const wxString &str);
+wxString UnescapeField(const wxString &str);
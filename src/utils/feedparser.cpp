@@ -0,0 +1,775 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+
+#include "feedparser.h"
+
+#include <cstring>
+
+static inline bool IsSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static int HexValue(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+static void AppendUTF8(std::string &str, unsigned long cp)
+{
+	if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+		cp = 0xFFFD;
+
+	if (cp < 0x80)
+	{
+		str += (char)cp;
+	}
+	else if (cp < 0x800)
+	{
+		str += (char)(0xC0 | (cp >> 6));
+		str += (char)(0x80 | (cp & 0x3F));
+	}
+	else if (cp < 0x10000)
+	{
+		str += (char)(0xE0 | (cp >> 12));
+		str += (char)(0x80 | ((cp >> 6) & 0x3F));
+		str += (char)(0x80 | (cp & 0x3F));
+	}
+	else
+	{
+		str += (char)(0xF0 | (cp >> 18));
+		str += (char)(0x80 | ((cp >> 12) & 0x3F));
+		str += (char)(0x80 | ((cp >> 6) & 0x3F));
+		str += (char)(0x80 | (cp & 0x3F));
+	}
+}
+
+// Counts the line breaks in [begin, end).
+static int CountLines(const char *begin, const char *end)
+{
+	int lines = 0;
+	while ((begin = (const char *)memchr(begin, '\n', end - begin)) != nullptr)
+	{
+		lines++;
+		begin++;
+	}
+	return lines;
+}
+
+FeedParser::FeedParser()
+	: m_line(1), m_stopped(false), m_failed(false)
+{
+	
+}
+
+bool FeedParser::Fail(const char *message)
+{
+	if (!m_failed)
+	{
+		m_failed = true;
+		m_error = message;
+	}
+	return false;
+}
+
+void FeedParser::PushPath(const std::string &name)
+{
+	m_pathLengths.push_back(m_path.size());
+	if (!m_path.empty())
+		m_path += '/';
+	m_path += name;
+}
+
+void FeedParser::PopPath()
+{
+	m_path.resize(m_pathLengths.back());
+	m_pathLengths.pop_back();
+}
+
+
+JsonStreamParser::JsonStreamParser()
+	: m_state(STATE_VALUE), m_inKey(false), m_unicode(0), m_unicodeDigits(0), m_highSurrogate(0)
+{
+	
+}
+
+bool JsonStreamParser::Feed(const char *data, std::size_t size)
+{
+	if (m_failed || m_stopped)
+		return false;
+
+	for (std::size_t i = 0; i < size; i++)
+	{
+		char c = data[i];
+		if (c == '\n')
+			m_line++;
+
+		switch (m_state)
+		{
+		case STATE_STRING:
+			if (c == '"')
+			{
+				if (!EndString())
+					return false;
+			}
+			else if (c == '\\')
+			{
+				m_state = STATE_ESCAPE;
+			}
+			else
+			{
+				// Copy everything up to the next quote or escape in one go.
+				std::size_t run = i + 1;
+				while (run < size && data[run] != '"' && data[run] != '\\')
+					run++;
+				if (m_highSurrogate)
+					AppendUnicode(0);
+				m_value.append(data + i, run - i);
+				m_line += CountLines(data + i + 1, data + run);
+				i = run - 1;
+			}
+			break;
+
+		case STATE_ESCAPE:
+			m_state = STATE_STRING;
+			switch (c)
+			{
+			case '"':
+			case '\\':
+			case '/':
+				break;
+			case 'b':
+				c = '\b';
+				break;
+			case 'f':
+				c = '\f';
+				break;
+			case 'n':
+				c = '\n';
+				break;
+			case 'r':
+				c = '\r';
+				break;
+			case 't':
+				c = '\t';
+				break;
+			case 'u':
+				m_unicode = 0;
+				m_unicodeDigits = 0;
+				m_state = STATE_UNICODE;
+				continue;
+			default:
+				return Fail("invalid escape sequence");
+			}
+			if (m_highSurrogate)
+				AppendUnicode(0);
+			m_value += c;
+			break;
+
+		case STATE_UNICODE:
+			{
+				int digit = HexValue(c);
+				if (digit < 0)
+					return Fail("invalid escape sequence");
+				m_unicode = m_unicode * 16 + digit;
+				if (++m_unicodeDigits == 4)
+				{
+					AppendUnicode(m_unicode);
+					m_state = STATE_STRING;
+				}
+			}
+			break;
+
+		case STATE_LITERAL:
+			if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || 
+				(c >= 'A' && c <= 'Z') || c == '.' || c == '+' || c == '-')
+			{
+				m_value += c;
+				break;
+			}
+			if (!EndLiteral())
+				return false;
+			// Look at this character again in the new state.
+			// If i is 0, this wraps around and the loop brings it back.
+			if (c == '\n')
+				m_line--;
+			i--;
+			break;
+
+		case STATE_VALUE:
+			if (!IsSpace(c) && !BeginValue(c))
+				return false;
+			break;
+
+		case STATE_FIRST_ITEM:
+			if (IsSpace(c))
+				break;
+			if (c == ']')
+			{
+				if (!CloseContainer(c))
+					return false;
+			}
+			else if (!BeginValue(c))
+			{
+				return false;
+			}
+			break;
+
+		case STATE_FIRST_KEY:
+		case STATE_KEY:
+			if (IsSpace(c))
+				break;
+			if (c == '"')
+			{
+				m_value.clear();
+				m_inKey = true;
+				m_state = STATE_STRING;
+			}
+			else if (c == '}' && m_state == STATE_FIRST_KEY)
+			{
+				if (!CloseContainer(c))
+					return false;
+			}
+			else
+			{
+				return Fail("expected a key");
+			}
+			break;
+
+		case STATE_COLON:
+			if (IsSpace(c))
+				break;
+			if (c != ':')
+				return Fail("expected ':'");
+			PushPath(m_key);
+			m_state = STATE_VALUE;
+			break;
+
+		case STATE_AFTER_VALUE:
+			if (IsSpace(c))
+				break;
+			if (c == ',')
+			{
+				m_state = m_containers.back() == '{' ? STATE_KEY : STATE_VALUE;
+			}
+			else if (c == '}' || c == ']')
+			{
+				if (!CloseContainer(c))
+					return false;
+			}
+			else
+			{
+				return Fail("expected ',' or the end of the object or array");
+			}
+			break;
+
+		case STATE_DONE:
+			if (!IsSpace(c))
+				return Fail("unexpected data after the end of the document");
+			break;
+		}
+	}
+	return true;
+}
+
+bool JsonStreamParser::Finish()
+{
+	if (m_stopped)
+		return true;
+	if (m_failed)
+		return false;
+	if (m_state == STATE_LITERAL && m_containers.empty() && !EndLiteral())
+		return m_stopped;
+	if (m_state != STATE_DONE)
+		return Fail("unexpected end of data");
+	return true;
+}
+
+bool JsonStreamParser::BeginValue(char c)
+{
+	if (!m_containers.empty() && m_containers.back() == '[')
+		PushPath("[]");
+
+	switch (c)
+	{
+	case '{':
+		m_containers.push_back('{');
+		m_state = STATE_FIRST_KEY;
+		if (onStartObject)
+			onStartObject(m_path);
+		return !m_stopped;
+
+	case '[':
+		m_containers.push_back('[');
+		m_state = STATE_FIRST_ITEM;
+		if (onStartArray)
+			onStartArray(m_path);
+		return !m_stopped;
+
+	case '"':
+		m_value.clear();
+		m_inKey = false;
+		m_state = STATE_STRING;
+		return true;
+
+	default:
+		if ((c >= '0' && c <= '9') || c == '-' || c == 't' || c == 'f' || c == 'n')
+		{
+			m_value.assign(1, c);
+			m_state = STATE_LITERAL;
+			return true;
+		}
+		return Fail("expected a value");
+	}
+}
+
+bool JsonStreamParser::EndValue()
+{
+	if (m_containers.empty())
+	{
+		m_state = STATE_DONE;
+	}
+	else
+	{
+		PopPath();
+		m_state = STATE_AFTER_VALUE;
+	}
+	return !m_stopped;
+}
+
+bool JsonStreamParser::EndString()
+{
+	if (m_highSurrogate)
+		AppendUnicode(0);
+
+	if (m_inKey)
+	{
+		m_key.swap(m_value);
+		m_state = STATE_COLON;
+		return true;
+	}
+
+	if (onValue)
+		onValue(m_path, m_value);
+	return EndValue();
+}
+
+static bool IsNumber(const std::string &str)
+{
+	const char *p = str.c_str();
+	if (*p == '-')
+		p++;
+	if (*p == '0')
+		p++;
+	else if (*p >= '1' && *p <= '9')
+		while (*p >= '0' && *p <= '9')
+			p++;
+	else
+		return false;
+
+	if (*p == '.')
+	{
+		p++;
+		if (*p < '0' || *p > '9')
+			return false;
+		while (*p >= '0' && *p <= '9')
+			p++;
+	}
+	if (*p == 'e' || *p == 'E')
+	{
+		p++;
+		if (*p == '+' || *p == '-')
+			p++;
+		if (*p < '0' || *p > '9')
+			return false;
+		while (*p >= '0' && *p <= '9')
+			p++;
+	}
+	return *p == 0;
+}
+
+bool JsonStreamParser::EndLiteral()
+{
+	if (m_value != "true" && m_value != "false" && m_value != "null" && !IsNumber(m_value))
+		return Fail("invalid literal");
+
+	if (onValue)
+		onValue(m_path, m_value);
+	return EndValue();
+}
+
+bool JsonStreamParser::CloseContainer(char c)
+{
+	char open = m_containers.back();
+	if ((open == '{') != (c == '}'))
+		return Fail("mismatched brackets");
+	m_containers.pop_back();
+
+	if (open == '{' && onEndObject)
+	{
+		// The object's path, the key or [] segment isn't popped yet.
+		onEndObject(m_path);
+	}
+	return EndValue();
+}
+
+void JsonStreamParser::AppendUnicode(unsigned long codeUnit)
+{
+	// codeUnit is 0 when something other than a low surrogate followed a high one.
+	if (m_highSurrogate)
+	{
+		if (codeUnit >= 0xDC00 && codeUnit <= 0xDFFF)
+		{
+			AppendUTF8(m_value, 0x10000 + ((m_highSurrogate - 0xD800) << 10) + (codeUnit - 0xDC00));
+			m_highSurrogate = 0;
+			return;
+		}
+		AppendUTF8(m_value, 0xFFFD);
+		m_highSurrogate = 0;
+	}
+
+	if (codeUnit >= 0xD800 && codeUnit <= 0xDBFF)
+		m_highSurrogate = codeUnit;
+	else if (codeUnit != 0)
+		AppendUTF8(m_value, codeUnit);
+}
+
+
+XmlStreamParser::XmlStreamParser()
+	: m_state(STATE_TEXT), m_quote(0), m_matched(0), m_doctypeDepth(0), m_rootDone(false)
+{
+	
+}
+
+static inline bool IsNameChar(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+		c == '_' || c == ':' || c == '-' || c == '.' || (unsigned char)c >= 0x80;
+}
+
+bool XmlStreamParser::Feed(const char *data, std::size_t size)
+{
+	if (m_failed || m_stopped)
+		return false;
+
+	const char *end = data + size;
+	for (const char *p = data; p < end; p++)
+	{
+		char c = *p;
+		if (c == '\n')
+			m_line++;
+
+		switch (m_state)
+		{
+		case STATE_TEXT:
+			if (c == '<')
+			{
+				m_state = STATE_TAG;
+			}
+			else if (c == '&')
+			{
+				m_entity.clear();
+				m_state = STATE_ENTITY;
+			}
+			else
+			{
+				// Copy everything up to the next tag or entity in one go.
+				const char *run = p + 1;
+				while (run < end && *run != '<' && *run != '&')
+					run++;
+				m_text.append(p, run);
+				m_line += CountLines(p + 1, run);
+				p = run - 1;
+			}
+			break;
+
+		case STATE_ENTITY:
+			if (c == ';')
+			{
+				if (!EndEntity())
+					return false;
+				m_state = STATE_TEXT;
+			}
+			else if (m_entity.size() < 10 && (IsNameChar(c) || c == '#'))
+			{
+				m_entity += c;
+			}
+			else
+			{
+				return Fail("invalid entity");
+			}
+			break;
+
+		case STATE_TAG:
+			if (c == '/')
+			{
+				m_name.clear();
+				m_state = STATE_END_NAME;
+			}
+			else if (c == '?')
+			{
+				m_matched = 0;
+				m_state = STATE_PI;
+			}
+			else if (c == '!')
+			{
+				m_name.clear();
+				m_state = STATE_BANG;
+			}
+			else if (IsNameChar(c))
+			{
+				if (m_rootDone)
+					return Fail("more than one root element");
+				m_name.assign(1, c);
+				m_state = STATE_START_NAME;
+			}
+			else
+			{
+				return Fail("invalid tag");
+			}
+			break;
+
+		case STATE_START_NAME:
+			if (IsNameChar(c))
+			{
+				m_name += c;
+			}
+			else if (IsSpace(c))
+			{
+				m_state = STATE_ATTRIBUTES;
+			}
+			else if (c == '/')
+			{
+				m_state = STATE_EMPTY_TAG;
+			}
+			else if (c == '>')
+			{
+				if (!StartElement())
+					return false;
+			}
+			else
+			{
+				return Fail("invalid tag");
+			}
+			break;
+
+		case STATE_ATTRIBUTES:
+			if (c == '"' || c == '\'')
+			{
+				m_quote = c;
+				m_state = STATE_ATTRIBUTE_VALUE;
+			}
+			else if (c == '/')
+			{
+				m_state = STATE_EMPTY_TAG;
+			}
+			else if (c == '>')
+			{
+				if (!StartElement())
+					return false;
+			}
+			else if (c == '<')
+			{
+				return Fail("invalid tag");
+			}
+			break;
+
+		case STATE_ATTRIBUTE_VALUE:
+			if (c == m_quote)
+				m_state = STATE_ATTRIBUTES;
+			break;
+
+		case STATE_EMPTY_TAG:
+			if (c != '>')
+				return Fail("expected '>'");
+			if (!StartElement() || !EndElement())
+				return false;
+			break;
+
+		case STATE_END_NAME:
+			if (IsNameChar(c))
+			{
+				m_name += c;
+				break;
+			}
+			m_state = STATE_END_TAG;
+			// fall through
+
+		case STATE_END_TAG:
+			if (c == '>')
+			{
+				if (!EndElement())
+					return false;
+			}
+			else if (!IsSpace(c))
+			{
+				return Fail("invalid end tag");
+			}
+			break;
+
+		case STATE_BANG:
+			// <!-- comment -->, <![CDATA[ text ]]> or <!DOCTYPE ...>
+			m_name += c;
+			if (m_name == "--")
+			{
+				m_matched = 0;
+				m_state = STATE_COMMENT;
+			}
+			else if (m_name == "[CDATA[")
+			{
+				m_matched = 0;
+				m_state = STATE_CDATA;
+			}
+			else if (m_name[0] != '-' && m_name[0] != '[')
+			{
+				m_doctypeDepth = 0;
+				m_state = STATE_DOCTYPE;
+			}
+			else if (m_name != std::string("[CDATA[", m_name.size()) && m_name != "-")
+			{
+				return Fail("invalid markup");
+			}
+			break;
+
+		case STATE_COMMENT:
+			if (c == '-')
+				m_matched++;
+			else if (c == '>' && m_matched >= 2)
+				m_state = STATE_TEXT;
+			else
+				m_matched = 0;
+			break;
+
+		case STATE_CDATA:
+			if (c == ']')
+			{
+				if (m_matched == 2)
+					m_text += ']';
+				else
+					m_matched++;
+			}
+			else if (c == '>' && m_matched == 2)
+			{
+				m_state = STATE_TEXT;
+			}
+			else
+			{
+				m_text.append(m_matched, ']');
+				m_text += c;
+				m_matched = 0;
+			}
+			break;
+
+		case STATE_DOCTYPE:
+			if (c == '[')
+				m_doctypeDepth++;
+			else if (c == ']')
+				m_doctypeDepth--;
+			else if (c == '>' && m_doctypeDepth <= 0)
+				m_state = STATE_TEXT;
+			break;
+
+		case STATE_PI:
+			if (c == '>' && m_matched)
+				m_state = STATE_TEXT;
+			m_matched = c == '?';
+			break;
+		}
+	}
+	return true;
+}
+
+bool XmlStreamParser::Finish()
+{
+	if (m_stopped)
+		return true;
+	if (m_failed)
+		return false;
+	if (!m_rootDone || m_state != STATE_TEXT)
+		return Fail("unexpected end of data");
+	return true;
+}
+
+bool XmlStreamParser::StartElement()
+{
+	PushPath(m_name);
+	m_text.clear();
+	m_state = STATE_TEXT;
+	if (onStartElement)
+		onStartElement(m_path);
+	return !m_stopped;
+}
+
+bool XmlStreamParser::EndElement()
+{
+	if (m_pathLengths.empty())
+		return Fail("unexpected end tag");
+
+	// For <name/>, m_name is still the start tag's name.
+	std::size_t nameStart = m_pathLengths.back() ? m_pathLengths.back() + 1 : 0;
+	if (m_path.compare(nameStart, std::string::npos, m_name) != 0)
+		return Fail("mismatched end tag");
+
+	if (onEndElement)
+		onEndElement(m_path, m_text);
+	PopPath();
+	m_text.clear();
+	m_state = STATE_TEXT;
+	if (m_pathLengths.empty())
+		m_rootDone = true;
+	return !m_stopped;
+}
+
+bool XmlStreamParser::EndEntity()
+{
+	if (m_entity == "amp")
+		m_text += '&';
+	else if (m_entity == "lt")
+		m_text += '<';
+	else if (m_entity == "gt")
+		m_text += '>';
+	else if (m_entity == "quot")
+		m_text += '"';
+	else if (m_entity == "apos")
+		m_text += '\'';
+	else if (m_entity.size() > 1 && m_entity[0] == '#')
+	{
+		unsigned long cp = 0;
+		bool hex = m_entity[1] == 'x';
+		for (std::size_t i = hex ? 2 : 1; i < m_entity.size(); i++)
+		{
+			int digit = HexValue(m_entity[i]);
+			if (digit < 0 || (!hex && digit > 9))
+				return Fail("invalid character reference");
+			cp = cp * (hex ? 16 : 10) + digit;
+			if (cp > 0x10FFFF)
+				return Fail("invalid character reference");
+		}
+		if ((hex && m_entity.size() == 2) || cp == 0)
+			return Fail("invalid character reference");
+		AppendUTF8(m_text, cp);
+	}
+	else
+		return Fail("unknown entity");
+	return true;
+}
@@ -0,0 +1,184 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstddef>
+
+// Event based parsers for the JSON and XML that MultiMC reads: version lists,
+// feeds, update info and config packs. Data can be fed in chunks of any size,
+// for example straight from a curl write callback, and the handlers see each
+// value along with its path as soon as it's complete. Nothing but the current
+// path and value is kept around.
+//
+// Paths are element names or object keys joined with '/', with "[]" for array
+// elements, like "rss/channel/item/title" or "versions/[]/md5". 
+// Text is passed on as UTF-8, the way it was in the input.
+class FeedParser
+{
+public:
+	FeedParser();
+	virtual ~FeedParser() {}
+
+	// Parses the next chunk of data. Returns false once there was an error or a
+	// handler called Stop(), after which the rest of the input should not be fed.
+	virtual bool Feed(const char *data, std::size_t size) = 0;
+
+	// Call after the last chunk. Returns true if the input was a complete document
+	// or if a handler stopped the parser.
+	virtual bool Finish() = 0;
+
+	// Handlers call this once they have what they need.
+	void Stop()
+	{
+		m_stopped = true;
+	}
+	bool IsStopped() const
+	{
+		return m_stopped;
+	}
+
+	bool HasError() const
+	{
+		return m_failed;
+	}
+	const std::string &GetError() const
+	{
+		return m_error;
+	}
+
+	// The line that's being parsed, or where the error was.
+	int GetLine() const
+	{
+		return m_line;
+	}
+
+	const std::string &GetPath() const
+	{
+		return m_path;
+	}
+
+protected:
+	bool Fail(const char *message);
+
+	void PushPath(const std::string &name);
+	void PopPath();
+
+	std::string m_path;
+	std::vector<std::size_t> m_pathLengths;
+	int m_line;
+	bool m_stopped;
+	bool m_failed;
+	std::string m_error;
+};
+
+class JsonStreamParser : public FeedParser
+{
+public:
+	JsonStreamParser();
+
+	virtual bool Feed(const char *data, std::size_t size);
+	virtual bool Finish();
+
+	std::function<void (const std::string &path)> onStartObject;
+	std::function<void (const std::string &path)> onEndObject;
+	std::function<void (const std::string &path)> onStartArray;
+
+	// Strings, numbers, true, false and null, all as text.
+	std::function<void (const std::string &path, const std::string &value)> onValue;
+
+protected:
+	enum State
+	{
+		STATE_VALUE,
+		STATE_FIRST_KEY,
+		STATE_KEY,
+		STATE_COLON,
+		STATE_FIRST_ITEM,
+		STATE_AFTER_VALUE,
+		STATE_STRING,
+		STATE_ESCAPE,
+		STATE_UNICODE,
+		STATE_LITERAL,
+		STATE_DONE,
+	};
+
+	bool BeginValue(char c);
+	bool EndValue();
+	bool EndString();
+	bool EndLiteral();
+	bool CloseContainer(char c);
+	void AppendUnicode(unsigned long codeUnit);
+
+	State m_state;
+	std::vector<char> m_containers;
+	std::string m_value;
+	std::string m_key;
+	bool m_inKey;
+	unsigned long m_unicode;
+	int m_unicodeDigits;
+	unsigned long m_highSurrogate;
+};
+
+class XmlStreamParser : public FeedParser
+{
+public:
+	XmlStreamParser();
+
+	virtual bool Feed(const char *data, std::size_t size);
+	virtual bool Finish();
+
+	std::function<void (const std::string &path)> onStartElement;
+
+	// text is the text and CDATA after the element's last child element, 
+	// which is all of it for elements without children. Attributes are skipped.
+	std::function<void (const std::string &path, const std::string &text)> onEndElement;
+
+protected:
+	enum State
+	{
+		STATE_TEXT,
+		STATE_ENTITY,
+		STATE_TAG,
+		STATE_START_NAME,
+		STATE_ATTRIBUTES,
+		STATE_ATTRIBUTE_VALUE,
+		STATE_EMPTY_TAG,
+		STATE_END_NAME,
+		STATE_END_TAG,
+		STATE_BANG,
+		STATE_COMMENT,
+		STATE_CDATA,
+		STATE_DOCTYPE,
+		STATE_PI,
+	};
+
+	bool StartElement();
+	bool EndElement();
+	bool EndEntity();
+
+	State m_state;
+	std::string m_name;
+	std::string m_text;
+	std::string m_entity;
+	char m_quote;
+	int m_matched;
+	int m_doctypeDepth;
+	bool m_rootDone;
+};
@@ -0,0 +1,163 @@
+/*
+ * feedbench [-n runs] [-c chunksize] <file>...
+ *     Parses each captured feed (JSON or XML, detected from the first
+ *     character) with the streaming parsers, fed in chunks the size curl
+ *     hands out, and with boost::property_tree, and reports the best time
+ *     and throughput of each.
+ *
+ * Save the feeds with curl (the S3 bucket listings, the MCRewind index, the
+ * RSS feeds, the Jenkins API) and pass them in.
+ */
+
+#include "feedparser.h"
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static double now()
+{
+	using namespace std::chrono;
+	return duration_cast<duration<double> >(steady_clock::now().time_since_epoch()).count();
+}
+
+static bool IsJson(const std::string &data)
+{
+	for (char c : data)
+	{
+		if (c == '{' || c == '[')
+			return true;
+		if (c != ' ' && c != '\t' && c != '\r' && c != '\n')
+			return false;
+	}
+	return false;
+}
+
+static bool StreamParse(const std::string &data, bool json, std::size_t chunk, long *events)
+{
+	JsonStreamParser jsonParser;
+	XmlStreamParser xmlParser;
+	FeedParser *parser;
+	long count = 0;
+
+	if (json)
+	{
+		jsonParser.onStartObject = [&] (const std::string &) { count++; };
+		jsonParser.onEndObject = [&] (const std::string &) { count++; };
+		jsonParser.onValue = [&] (const std::string &, const std::string &) { count++; };
+		parser = &jsonParser;
+	}
+	else
+	{
+		xmlParser.onStartElement = [&] (const std::string &) { count++; };
+		xmlParser.onEndElement = [&] (const std::string &, const std::string &) { count++; };
+		parser = &xmlParser;
+	}
+
+	for (std::size_t pos = 0; pos < data.size(); pos += chunk)
+	{
+		std::size_t len = std::min(chunk, data.size() - pos);
+		if (!parser->Feed(data.data() + pos, len))
+			break;
+	}
+	if (!parser->Finish())
+	{
+		fprintf(stderr, "stream parser: line %i: %s\n", parser->GetLine(), parser->GetError().c_str());
+		return false;
+	}
+	*events = count;
+	return true;
+}
+
+static bool TreeParse(const std::string &data, bool json)
+{
+	using namespace boost::property_tree;
+	std::istringstream in(data);
+	ptree pt;
+	try
+	{
+		if (json)
+			read_json(in, pt);
+		else
+			read_xml(in, pt);
+	}
+	catch (const file_parser_error &e)
+	{
+		fprintf(stderr, "property_tree: %s\n", e.what());
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	int runs = 20;
+	std::size_t chunk = 16 * 1024;
+	std::vector<const char *> files;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-n") && i + 1 < argc)
+			runs = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-c") && i + 1 < argc)
+			chunk = strtoul(argv[++i], nullptr, 10);
+		else
+			files.push_back(argv[i]);
+	}
+	if (files.empty() || runs < 1 || chunk < 1)
+	{
+		fprintf(stderr, "usage: %s [-n runs] [-c chunksize] <file>...\n", argv[0]);
+		return 1;
+	}
+
+	int status = 0;
+	for (const char *file : files)
+	{
+		std::ifstream in(file, std::ios::binary);
+		if (!in)
+		{
+			fprintf(stderr, "%s: can't open\n", file);
+			status = 1;
+			continue;
+		}
+		std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		bool json = IsJson(data);
+		double mb = data.size() / (1024.0 * 1024.0);
+
+		double bestStream = 1e9, bestTree = 1e9;
+		long events = 0;
+		bool ok = true;
+		for (int run = 0; run < runs && ok; run++)
+		{
+			double start = now();
+			ok = StreamParse(data, json, chunk, &events);
+			bestStream = std::min(bestStream, now() - start);
+
+			start = now();
+			ok = TreeParse(data, json) && ok;
+			bestTree = std::min(bestTree, now() - start);
+		}
+		if (!ok)
+		{
+			fprintf(stderr, "%s: parse failed\n", file);
+			status = 1;
+			continue;
+		}
+
+		printf("%s (%s, %zu bytes, %ld events)\n", file, json ? "json" : "xml", data.size(), events);
+		printf("  stream:        %8.3f ms  %8.1f MB/s\n", bestStream * 1000, mb / bestStream);
+		printf("  property_tree: %8.3f ms  %8.1f MB/s\n", bestTree * 1000, mb / bestTree);
+	}
+	return status;
+}
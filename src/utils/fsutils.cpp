@@ -16,6 +16,7 @@
 
 #include "fsutils.h"
 #include "apputils.h"
+#include "osutils.h"
 #include "appsettings.h"
 #include <wx/dir.h>
 #include <wx/filefn.h>
@@ -25,6 +26,21 @@
 
 #include <memory>
 
+#if WINDOWS
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <errno.h>
+#if LINUX
+#include <linux/fs.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
 namespace fsutils {
 
 // tests if 'a' is subset of 'b'
@@ -155,6 +171,157 @@ bool RecursiveDelete(const wxString &path)
 	return true;
 }
 
+// Creates dest as a copy-on-write clone of src. Only some filesystems support this.
+static bool CloneFile(const wxString &src, const wxString &dest)
+{
+#if LINUX && defined(FICLONE)
+	int srcFd = open(FNSTR(src), O_RDONLY);
+	if (srcFd < 0)
+		return false;
+
+	struct stat srcStat;
+	if (fstat(srcFd, &srcStat) != 0)
+	{
+		close(srcFd);
+		return false;
+	}
+
+	int destFd = open(FNSTR(dest), O_WRONLY | O_CREAT | O_EXCL, srcStat.st_mode & 0777);
+	if (destFd < 0)
+	{
+		close(srcFd);
+		return false;
+	}
+
+	bool cloned = ioctl(destFd, FICLONE, srcFd) == 0;
+	if (cloned)
+	{
+		struct timespec times[2] = { srcStat.st_atim, srcStat.st_mtim };
+		futimens(destFd, times);
+	}
+	close(destFd);
+	close(srcFd);
+
+	if (!cloned)
+		unlink(FNSTR(dest));
+	return cloned;
+#else
+	return false;
+#endif
+}
+
+#if LINUX
+// Copies size bytes from srcFd to destFd without the data passing through user space.
+// Returns false if not everything could be copied, so a normal copy can take over.
+static bool KernelCopy(int srcFd, int destFd, off_t size)
+{
+#ifdef SYS_copy_file_range
+	bool useCopyRange = true;
+#endif
+	off_t done = 0;
+	while (done < size)
+	{
+		ssize_t copied;
+#ifdef SYS_copy_file_range
+		if (useCopyRange)
+		{
+			copied = syscall(SYS_copy_file_range, srcFd, NULL, destFd, NULL, (size_t)(size - done), 0);
+			// Old kernels and some file system combinations can't do it, or stop
+			// early and return 0. Both file offsets are where they should be, so
+			// sendfile can take over.
+			if ((copied < 0 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)) ||
+				copied == 0)
+			{
+				useCopyRange = false;
+				continue;
+			}
+		}
+		else
+#endif
+			copied = sendfile(destFd, srcFd, NULL, (size_t)(size - done));
+
+		if (copied < 0 && errno == EINTR)
+			continue;
+		if (copied < 0)
+			return false;
+		if (copied == 0)
+		{
+			// Only fine if the file really got shorter since it was opened.
+			struct stat srcStat;
+			return fstat(srcFd, &srcStat) == 0 && srcStat.st_size <= done;
+		}
+		done += copied;
+	}
+	return true;
+}
+#endif
+
+bool CopySingleFile(const wxString &src, const wxString &dest)
+{
+	if (wxFileExists(dest) && !wxRemoveFile(dest))
+		return false;
+
+#if LINUX
+	int srcFd = open(FNSTR(src), O_RDONLY);
+	if (srcFd >= 0)
+	{
+		struct stat srcStat;
+		int destFd = -1;
+		if (fstat(srcFd, &srcStat) == 0)
+			destFd = open(FNSTR(dest), O_WRONLY | O_CREAT | O_EXCL, srcStat.st_mode & 0777);
+
+		if (destFd >= 0)
+		{
+			bool copied = KernelCopy(srcFd, destFd, srcStat.st_size);
+			if (copied)
+			{
+				struct timespec times[2] = { srcStat.st_atim, srcStat.st_mtim };
+				futimens(destFd, times);
+			}
+			copied = close(destFd) == 0 && copied;
+			close(srcFd);
+			if (copied)
+				return true;
+			unlink(FNSTR(dest));
+		}
+		else
+		{
+			close(srcFd);
+		}
+	}
+#endif
+
+	if (!wxCopyFile(src, dest))
+		return false;
+
+	wxDateTime accessTime, modTime;
+	wxFileName srcFile(src);
+	if (srcFile.GetTimes(&accessTime, &modTime, NULL))
+		wxFileName(dest).SetTimes(&accessTime, &modTime, NULL);
+	return true;
+}
+
+static bool HardLinkFile(const wxString &src, const wxString &dest)
+{
+#if WINDOWS
+	return CreateHardLinkW(dest.wc_str(), src.wc_str(), NULL) != 0;
+#else
+	return link(FNSTR(src), FNSTR(dest)) == 0;
+#endif
+}
+
+bool LinkFile(const wxString &src, const wxString &dest, bool allowHardLink)
+{
+	if (wxFileExists(dest) && !wxRemoveFile(dest))
+		return false;
+
+	if (CloneFile(src, dest))
+		return true;
+	if (allowHardLink && HardLinkFile(src, dest))
+		return true;
+	return CopySingleFile(src, dest);
+}
+
 void ExtractZipArchive(wxInputStream &stream, const wxString &dest)
 {
 	wxZipInputStream zipStream(stream);
@@ -28,6 +28,16 @@ namespace fsutils
 
 	bool RecursiveDelete(const wxString &path);
 
+	// Copies src to dest, keeping the data in the kernel where possible.
+	// The modification time is preserved and an existing dest is replaced.
+	bool CopySingleFile(const wxString &src, const wxString &dest);
+
+	// Makes dest a copy of src without duplicating the data where possible.
+	// Tries a reflink (copy-on-write clone) first, then a hard link if
+	// allowHardLink is set, and falls back to a normal copy.
+	// An existing dest is replaced.
+	bool LinkFile(const wxString &src, const wxString &dest, bool allowHardLink = true);
+
 	bool CreateAllDirs(const wxFileName &dir);
 
 	void ExtractZipArchive(wxInputStream &stream, const wxString &dest);
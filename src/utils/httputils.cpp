@@ -17,8 +17,10 @@
 #include "httputils.h"
 #include "apputils.h"
 #include "curlutils.h"
+#include "feedparser.h"
 
 #include <wx/sstream.h>
+#include <wx/wfstream.h>
 
 bool DownloadString(const wxString &url, wxString *output)
 {
@@ -43,4 +45,144 @@ bool DownloadString(const wxString &url, wxString *output)
 		return false;
 	
 	return true;
-}
\ No newline at end of file
+}
+
+static wxString GetHeaderValue(const wxString &headers, const wxString &name)
+{
+	wxString prefix = "\n" + name.Lower() + ":";
+	size_t start = ("\n" + headers).Lower().find(prefix);
+	if (start == wxString::npos)
+		return wxEmptyString;
+	start += prefix.Len() - 1;
+
+	size_t end = headers.find_first_of("\r\n", start);
+	if (end == wxString::npos)
+		end = headers.Len();
+	return headers.Mid(start, end - start).Trim(false).Trim(true);
+}
+
+static bool PerformParsed(const wxString &url, FeedParser &parser, 
+	HttpCacheInfo *cacheInfo, bool *notModified, wxOutputStream *copy)
+{
+	CURL *curl = InitCurlHandle();
+
+	curl_easy_setopt(curl, CURLOPT_URL, TOASCII(url));
+	curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1);
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlLambdaCallback);
+	curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, CurlLambdaCallback);
+
+	// Only keep the headers of the last response if there were redirects.
+	wxString headers;
+	long status = 0;
+	CurlLambdaCallbackFunction curlWriteHeaders = [&] (void *buffer, size_t size) -> size_t
+	{
+		wxString line((const char *)buffer, size);
+		if (line.StartsWith("HTTP/"))
+		{
+			headers.Clear();
+			line.AfterFirst(' ').BeforeFirst(' ').ToLong(&status);
+		}
+		headers << line;
+		return size;
+	};
+	curl_easy_setopt(curl, CURLOPT_HEADERDATA, &curlWriteHeaders);
+
+	// Parse while downloading. Returning less than size makes curl stop
+	// once the parser failed or has everything it wants.
+	CurlLambdaCallbackFunction curlWrite = [&] (void *buffer, size_t size) -> size_t
+	{
+		if (status < 200 || status >= 300)
+			return size;
+		if (copy)
+			copy->Write(buffer, size);
+		if (!parser.Feed((const char *)buffer, size))
+			return 0;
+		return size;
+	};
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, &curlWrite);
+
+	struct curl_slist *requestHeaders = nullptr;
+	if (cacheInfo && !cacheInfo->etag.IsEmpty())
+		requestHeaders = curl_slist_append(requestHeaders, stdStr("If-None-Match: \"" + cacheInfo->etag + "\"").c_str());
+	if (cacheInfo && !cacheInfo->lastModified.IsEmpty())
+		requestHeaders = curl_slist_append(requestHeaders, stdStr("If-Modified-Since: " + cacheInfo->lastModified).c_str());
+	curl_easy_setopt(curl, CURLOPT_HTTPHEADER, requestHeaders);
+
+	int curlErr = curl_easy_perform(curl);
+
+	long responseCode = 0;
+	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+
+	curl_easy_cleanup(curl);
+	curl_slist_free_all(requestHeaders);
+
+	if (curlErr != 0 && !(curlErr == CURLE_WRITE_ERROR && parser.IsStopped()))
+		return false;
+
+	if (responseCode == 304 && notModified)
+	{
+		*notModified = true;
+		return true;
+	}
+
+	if (responseCode < 200 || responseCode >= 300)
+		return false;
+
+	if (cacheInfo)
+	{
+		cacheInfo->etag = GetETagFromHeaders(headers);
+		cacheInfo->lastModified = GetHeaderValue(headers, "Last-Modified");
+	}
+	return parser.Finish();
+}
+
+bool DownloadParsed(const wxString &url, FeedParser &parser)
+{
+	return PerformParsed(url, parser, nullptr, nullptr, nullptr);
+}
+
+bool DownloadParsedIfModified(const wxString &url, FeedParser &parser, 
+	HttpCacheInfo &cacheInfo, const wxString &cacheFile, bool *notModified)
+{
+	*notModified = false;
+	// Without the old copy, a 304 would leave nothing to parse.
+	if (!wxFileExists(cacheFile))
+		cacheInfo = HttpCacheInfo();
+
+	// If the parser stopped early, the copy ends there too. That's all it needs next time.
+	wxTempFileOutputStream copy(cacheFile);
+	if (!PerformParsed(url, parser, &cacheInfo, notModified, &copy))
+		return false;
+	if (!*notModified)
+	{
+		copy.Commit();
+		return true;
+	}
+	copy.Discard();
+
+	wxFFileInputStream in(cacheFile);
+	if (!in.IsOk())
+		return false;
+	char buffer[64 * 1024];
+	while (in.Read(buffer, sizeof(buffer)).LastRead() > 0)
+	{
+		if (!parser.Feed(buffer, in.LastRead()))
+			break;
+	}
+	return parser.Finish();
+}
+
+wxString GetETagFromHeaders(const wxString &headers)
+{
+	const wxString etagHeader = "ETag: \"";
+
+	size_t etagStart = headers.find(etagHeader);
+	if (etagStart == wxString::npos)
+		return wxEmptyString;
+	etagStart += etagHeader.Len();
+
+	size_t etagEnd = headers.find("\"", etagStart);
+	if (etagEnd == wxString::npos)
+		return wxEmptyString;
+	return headers.Mid(etagStart, etagEnd - etagStart);
+}
@@ -18,4 +18,27 @@
 
 #include <wx/string.h>
 
+class FeedParser;
+
 bool DownloadString(const wxString &url, wxString *output);
+
+// What a server needs to tell whether something changed since it was last downloaded.
+struct HttpCacheInfo
+{
+	wxString etag;
+	wxString lastModified;
+};
+
+// Downloads url and feeds it to parser while it arrives. Returns true if the
+// whole response parsed, or if a handler stopped the parser early.
+bool DownloadParsed(const wxString &url, FeedParser &parser);
+
+// Like DownloadParsed, but sends If-None-Match and If-Modified-Since from cacheInfo
+// when it has them, and keeps what was parsed in cacheFile. If the server answers 
+// 304 Not Modified, notModified is set and cacheFile is parsed instead, so the parser
+// always sees the document. cacheInfo is updated from the response.
+bool DownloadParsedIfModified(const wxString &url, FeedParser &parser, 
+	HttpCacheInfo &cacheInfo, const wxString &cacheFile, bool *notModified);
+
+// Returns the ETag in a block of HTTP headers, without the quotes.
+wxString GetETagFromHeaders(const wxString &headers);
@@ -0,0 +1,173 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "literalmatcher.h"
+
+#include <algorithm>
+#include <map>
+#include <queue>
+
+LiteralMatcher::LiteralMatcher()
+	: m_classCount(1), m_generation(0)
+{
+	std::fill(m_asciiClasses, m_asciiClasses + 128, 0);
+	Compile();
+}
+
+int LiteralMatcher::Add(const std::wstring &literal)
+{
+	m_literals.push_back(literal);
+	return m_literals.size() - 1;
+}
+
+int LiteralMatcher::GetOtherClass(unsigned code) const
+{
+	auto found = std::lower_bound(m_otherClasses.begin(), m_otherClasses.end(),
+		std::make_pair(code, 0));
+	if (found == m_otherClasses.end() || found->first != code)
+		return 0;
+	return found->second;
+}
+
+void LiteralMatcher::Compile()
+{
+	// Give every character the literals use a class.
+	std::fill(m_asciiClasses, m_asciiClasses + 128, 0);
+	m_otherClasses.clear();
+	m_classCount = 1;
+	for (size_t i = 0; i < m_literals.size(); i++)
+	{
+		for (size_t j = 0; j < m_literals[i].size(); j++)
+		{
+			unsigned code = (unsigned)m_literals[i][j];
+			if (GetClass(m_literals[i][j]) != 0)
+				continue;
+			if (code < 128)
+			{
+				m_asciiClasses[code] = m_classCount++;
+			}
+			else
+			{
+				m_otherClasses.push_back(std::make_pair(code, m_classCount++));
+				std::sort(m_otherClasses.begin(), m_otherClasses.end());
+			}
+		}
+	}
+
+	// Build the trie. Maps are fine here, this only runs once.
+	struct Node
+	{
+		Node() : fail(0) {}
+
+		std::map<int, int> children;
+		int fail;
+		std::vector<int> literals;
+	};
+	std::vector<Node> nodes(1);
+	for (size_t i = 0; i < m_literals.size(); i++)
+	{
+		if (m_literals[i].empty())
+			continue;
+		int node = 0;
+		for (size_t j = 0; j < m_literals[i].size(); j++)
+		{
+			int cls = GetClass(m_literals[i][j]);
+			auto found = nodes[node].children.find(cls);
+			if (found != nodes[node].children.end())
+			{
+				node = found->second;
+				continue;
+			}
+			nodes.push_back(Node());
+			int child = nodes.size() - 1;
+			nodes[node].children[cls] = child;
+			node = child;
+		}
+		nodes[node].literals.push_back(i);
+	}
+
+	// Fill in the table breadth first, so the state a fail link points to is
+	// always done before the states that use it.
+	m_next.assign(nodes.size() * m_classCount, 0);
+	std::queue<int> todo;
+	for (auto iter = nodes[0].children.begin(); iter != nodes[0].children.end(); ++iter)
+	{
+		m_next[iter->first] = iter->second;
+		todo.push(iter->second);
+	}
+	while (!todo.empty())
+	{
+		int node = todo.front();
+		todo.pop();
+
+		const Node &failNode = nodes[nodes[node].fail];
+		nodes[node].literals.insert(nodes[node].literals.end(),
+			failNode.literals.begin(), failNode.literals.end());
+
+		for (int cls = 0; cls < m_classCount; cls++)
+		{
+			int failNext = m_next[nodes[node].fail * m_classCount + cls];
+			auto found = nodes[node].children.find(cls);
+			if (found == nodes[node].children.end())
+			{
+				m_next[node * m_classCount + cls] = failNext;
+				continue;
+			}
+			nodes[found->second].fail = failNext;
+			m_next[node * m_classCount + cls] = found->second;
+			todo.push(found->second);
+		}
+	}
+
+	m_outputBegin.clear();
+	m_outputs.clear();
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		m_outputBegin.push_back(m_outputs.size());
+		m_outputs.insert(m_outputs.end(), nodes[i].literals.begin(), nodes[i].literals.end());
+	}
+	m_outputBegin.push_back(m_outputs.size());
+
+	m_seen.assign(m_literals.size(), 0);
+	m_generation = 0;
+}
+
+void LiteralMatcher::Find(const wchar_t *text, std::vector<int> &found)
+{
+	if (++m_generation == 0)
+	{
+		// wrapped around, forget the old stamps
+		std::fill(m_seen.begin(), m_seen.end(), 0);
+		m_generation = 1;
+	}
+
+	const int *next = m_next.data();
+	const int *outputBegin = m_outputBegin.data();
+	int state = 0;
+	for (; *text; text++)
+	{
+		state = next[state * m_classCount + GetClass(*text)];
+		for (int i = outputBegin[state]; i < outputBegin[state + 1]; i++)
+		{
+			int literal = m_outputs[i];
+			if (m_seen[literal] != m_generation)
+			{
+				m_seen[literal] = m_generation;
+				found.push_back(literal);
+			}
+		}
+	}
+}
@@ -0,0 +1,72 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#pragma once
+#include <vector>
+#include <string>
+#include <utility>
+
+// Finds which of a fixed set of literals occur in a string, in a single pass no
+// matter how many literals there are (Aho-Corasick). The automaton is compiled
+// into a flat transition table over the characters the literals use, so matching
+// is one table lookup per character and doesn't allocate.
+// Find uses scratch space, so only one thread may use a matcher at a time.
+class LiteralMatcher
+{
+public:
+	LiteralMatcher();
+
+	// Adds a literal and returns its index. Empty literals never match.
+	// Call Compile after the last one.
+	int Add(const std::wstring &literal);
+	void Compile();
+
+	// Appends the index of every literal that occurs in the null terminated text
+	// to found, each one once, in the order they first occur.
+	void Find(const wchar_t *text, std::vector<int> &found);
+
+	size_t GetStateCount() const { return m_outputBegin.empty() ? 0 : m_outputBegin.size() - 1; }
+
+protected:
+	int GetClass(wchar_t c) const
+	{
+		unsigned code = (unsigned)c;
+		if (code < 128)
+			return m_asciiClasses[code];
+		return GetOtherClass(code);
+	}
+	int GetOtherClass(unsigned code) const;
+
+	std::vector<std::wstring> m_literals;
+
+	// Characters that appear in a literal get a class of their own, all others share class 0.
+	int m_asciiClasses[128];
+	// sorted by character
+	std::vector<std::pair<unsigned, int> > m_otherClasses;
+	int m_classCount;
+
+	// m_next[state * m_classCount + class] is the next state, with the fail links already
+	// followed. State 0 is the start.
+	std::vector<int> m_next;
+
+	// The literals that end in state s are m_outputs[m_outputBegin[s]] up to m_outputs[m_outputBegin[s + 1]].
+	std::vector<int> m_outputBegin;
+	std::vector<int> m_outputs;
+
+	// m_seen[literal] == m_generation if Find already reported it for the current text
+	std::vector<unsigned> m_seen;
+	unsigned m_generation;
+};
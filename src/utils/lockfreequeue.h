@@ -0,0 +1,81 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+
+#pragma once
+#include <atomic>
+
+// Unbounded queue that any number of threads can push to without locking, 
+// while a single thread pops. Push never blocks, so producers are never 
+// held up by a slow consumer.
+template <typename T>
+class LockFreeQueue
+{
+public:
+	LockFreeQueue()
+	{
+		Node *stub = new Node();
+		m_head.store(stub);
+		m_tail = stub;
+	}
+
+	~LockFreeQueue()
+	{
+		T value;
+		while (Pop(value));
+		delete m_tail;
+	}
+
+	void Push(const T &value)
+	{
+		Node *node = new Node();
+		node->value = value;
+		Node *prev = m_head.exchange(node, std::memory_order_acq_rel);
+		prev->next.store(node, std::memory_order_release);
+	}
+
+	// Only one thread may pop. Returns false if the queue is empty.
+	bool Pop(T &value)
+	{
+		Node *tail = m_tail;
+		Node *next = tail->next.load(std::memory_order_acquire);
+		if (next == nullptr)
+			return false;
+
+		// next becomes the new stub node.
+		value = next->value;
+		next->value = T();
+		m_tail = next;
+		delete tail;
+		return true;
+	}
+
+protected:
+	struct Node
+	{
+		Node() : next(nullptr) {}
+
+		std::atomic<Node *> next;
+		T value;
+	};
+
+	std::atomic<Node *> m_head;
+	Node *m_tail;
+
+private:
+	LockFreeQueue(const LockFreeQueue &);
+	LockFreeQueue &operator=(const LockFreeQueue &);
+};
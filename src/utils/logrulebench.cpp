@@ -0,0 +1,207 @@
+/*
+ * logrulebench [-n runs] [-l lines] [file]
+ *     Looks for the literals of the built-in log rules in every line of a
+ *     captured game log (or, without a file, in generated Forge/FML console
+ *     lines with the odd crash line mixed in) with LiteralMatcher, and with
+ *     one wcsstr per literal, checks both find the same rules and reports the
+ *     best time and lines per second of each.
+ *
+ * The console window runs the rules on every line the game prints, so the
+ * matcher has to keep up with at least 50000 lines/s.
+ */
+
+#include "literalmatcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Keep in sync with the built-in rules in data/loganalyzer.cpp.
+static const wchar_t *literals[] =
+{
+	L" is already occupied by ",
+	L"ClassNotFoundException: ",
+	L"NoClassDefFoundError: ",
+	L"java.lang.OutOfMemoryError",
+	L"Pixel format not accelerated",
+	L"GL ERROR",
+	L"WrongMinecraftVersionException",
+	L"MissingModsException",
+};
+static const int literalCount = sizeof(literals) / sizeof(literals[0]);
+
+static const double targetRate = 50000;
+
+static double now()
+{
+	using namespace std::chrono;
+	return duration_cast<duration<double> >(steady_clock::now().time_since_epoch()).count();
+}
+
+static std::vector<std::wstring> GenerateLines(int count)
+{
+	static const char *normal[] =
+	{
+		"2013-03-02 14:21:07 [INFO] [ForgeModLoader] Loading mod IC2 from file mods/industrialcraft-2_1.115.231-lf.jar",
+		"2013-03-02 14:21:08 [FINE] [ForgeModLoader] Registering block ID 250 for mod BuildCraft|Transport",
+		"2013-03-02 14:21:09 [INFO] [STDOUT] Starting up SoundSystem...",
+		"2013-03-02 14:21:09 [INFO] [STDERR] \tat cpw.mods.fml.common.Loader.loadMods(Loader.java:487)",
+		"2013-03-02 14:21:10 [INFO] [Minecraft-Client] Setting user: Player, 1a2b3c4d5e6f",
+		"2013-03-02 14:21:11 [WARNING] [ForgeModLoader] The mod redpower does not specify a version",
+	};
+	static const char *problems[] =
+	{
+		"java.lang.IllegalArgumentException: Slot 250 is already occupied by buildcraft.transport.BlockGenericPipe@4f3c6a when adding ic2.core.block.BlockMachine@7a1e2b",
+		"2013-03-02 14:21:12 [SEVERE] [STDERR] java.lang.NoClassDefFoundError: net/minecraft/src/BaseMod",
+		"Exception in thread \"main\" java.lang.OutOfMemoryError: Java heap space",
+		"########## GL ERROR ##########",
+	};
+	const int normalCount = sizeof(normal) / sizeof(normal[0]);
+	const int problemCount = sizeof(problems) / sizeof(problems[0]);
+
+	std::vector<std::wstring> lines;
+	for (int i = 0; i < count; i++)
+	{
+		// about one line in a hundred matches something
+		const char *line = i % 97 == 0 ? problems[(i / 97) % problemCount] : normal[i % normalCount];
+		lines.push_back(std::wstring(line, line + strlen(line)));
+	}
+	return lines;
+}
+
+static bool ReadLines(const char *file, std::vector<std::wstring> &lines)
+{
+	std::ifstream in(file, std::ios::binary);
+	if (!in)
+		return false;
+	// Latin-1 is close enough for the literals, they're all ASCII.
+	std::string line;
+	while (std::getline(in, line))
+	{
+		if (!line.empty() && line[line.size() - 1] == '\r')
+			line.erase(line.size() - 1);
+		std::wstring wide;
+		for (char c : line)
+			wide.push_back((wchar_t)(unsigned char)c);
+		lines.push_back(wide);
+	}
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	int runs = 20;
+	int generated = 200000;
+	const char *file = nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-n") && i + 1 < argc)
+			runs = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-l") && i + 1 < argc)
+			generated = atoi(argv[++i]);
+		else if (!file)
+			file = argv[i];
+		else
+			runs = 0;
+	}
+	if (runs < 1 || generated < 1)
+	{
+		fprintf(stderr, "usage: %s [-n runs] [-l lines] [file]\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<std::wstring> lines;
+	if (file)
+	{
+		if (!ReadLines(file, lines))
+		{
+			fprintf(stderr, "%s: can't open\n", file);
+			return 1;
+		}
+	}
+	else
+	{
+		lines = GenerateLines(generated);
+	}
+	if (lines.empty())
+	{
+		fprintf(stderr, "no lines\n");
+		return 1;
+	}
+
+	LiteralMatcher matcher;
+	for (int i = 0; i < literalCount; i++)
+		matcher.Add(literals[i]);
+	matcher.Compile();
+
+	std::vector<int> found, naive;
+	double bestMatcher = 1e9, bestNaive = 1e9;
+	long matches = 0, naiveMatches = 0;
+	for (int run = 0; run < runs; run++)
+	{
+		matches = 0;
+		double start = now();
+		for (size_t i = 0; i < lines.size(); i++)
+		{
+			found.clear();
+			matcher.Find(lines[i].c_str(), found);
+			matches += found.size();
+		}
+		bestMatcher = std::min(bestMatcher, now() - start);
+
+		naiveMatches = 0;
+		start = now();
+		for (size_t i = 0; i < lines.size(); i++)
+		{
+			for (int j = 0; j < literalCount; j++)
+			{
+				if (wcsstr(lines[i].c_str(), literals[j]))
+					naiveMatches++;
+			}
+		}
+		bestNaive = std::min(bestNaive, now() - start);
+	}
+
+	// Both have to agree on every line, not just on the total.
+	for (size_t i = 0; i < lines.size(); i++)
+	{
+		found.clear();
+		matcher.Find(lines[i].c_str(), found);
+		std::sort(found.begin(), found.end());
+		naive.clear();
+		for (int j = 0; j < literalCount; j++)
+		{
+			if (wcsstr(lines[i].c_str(), literals[j]))
+				naive.push_back(j);
+		}
+		if (found != naive)
+		{
+			fprintf(stderr, "line %zu: matcher and wcsstr disagree\n", i + 1);
+			return 1;
+		}
+	}
+
+	if (matches != naiveMatches)
+	{
+		fprintf(stderr, "matcher found %ld matches, wcsstr %ld\n", matches, naiveMatches);
+		return 1;
+	}
+
+	double rate = lines.size() / bestMatcher;
+	printf("%s (%zu lines, %ld matches, %zu states)\n", file ? file : "generated", lines.size(), matches, matcher.GetStateCount());
+	printf("  matcher: %8.3f ms  %12.0f lines/s\n", bestMatcher * 1000, rate);
+	printf("  wcsstr:  %8.3f ms  %12.0f lines/s\n", bestNaive * 1000, lines.size() / bestNaive);
+	if (rate < targetRate)
+	{
+		printf("below the target of %.0f lines/s\n", targetRate);
+		return 1;
+	}
+	return 0;
+}
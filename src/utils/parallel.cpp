@@ -0,0 +1,102 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "parallel.h"
+
+#include <wx/thread.h>
+
+#include <algorithm>
+#include <vector>
+
+// Hands out indices to the workers.
+class ParallelForState
+{
+public:
+	ParallelForState(std::size_t count, std::function<void (std::size_t)> func)
+		: m_next(0), m_count(count), m_func(func) {}
+
+	void Run()
+	{
+		std::size_t index;
+		while (Next(&index))
+			m_func(index);
+	}
+
+protected:
+	bool Next(std::size_t *index)
+	{
+		wxMutexLocker lock(m_mutex);
+		if (m_next >= m_count)
+			return false;
+		*index = m_next++;
+		return true;
+	}
+
+	wxMutex m_mutex;
+	std::size_t m_next;
+	std::size_t m_count;
+	std::function<void (std::size_t)> m_func;
+};
+
+class ParallelForThread : public wxThread
+{
+public:
+	ParallelForThread(ParallelForState *state)
+		: wxThread(wxTHREAD_JOINABLE), m_state(state) {}
+
+protected:
+	virtual ExitCode Entry()
+	{
+		m_state->Run();
+		return 0;
+	}
+
+	ParallelForState *m_state;
+};
+
+int GetIOThreadCount()
+{
+	// Disk and network file systems are latency bound, so use more threads than cores.
+	int cpus = wxThread::GetCPUCount();
+	return std::min(std::max(cpus * 2, 4), 16);
+}
+
+void ParallelFor(std::size_t count, int maxThreads, std::function<void (std::size_t)> func)
+{
+	ParallelForState state(count, func);
+
+	std::vector<ParallelForThread*> threads;
+	int threadCount = (int)std::min<std::size_t>(std::max(maxThreads, 1), count);
+	for (int i = 1; i < threadCount; i++)
+	{
+		ParallelForThread *thread = new ParallelForThread(&state);
+		if (thread->Run() != wxTHREAD_NO_ERROR)
+		{
+			// Whatever threads we got will do the work.
+			delete thread;
+			break;
+		}
+		threads.push_back(thread);
+	}
+
+	state.Run();
+
+	for (std::size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i]->Wait();
+		delete threads[i];
+	}
+}
@@ -0,0 +1,27 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#pragma once
+#include <functional>
+#include <cstddef>
+
+// Number of worker threads to use for disk bound work.
+int GetIOThreadCount();
+
+// Calls func(i) for every i in [0, count) using up to maxThreads threads, 
+// including the calling one, and returns once all calls are done.
+// The order of the calls is undefined and func has to be thread safe.
+void ParallelFor(std::size_t count, int maxThreads, std::function<void (std::size_t)> func);
@@ -0,0 +1,233 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "partialdownload.h"
+#include "apputils.h"
+#include "datautils.h"
+
+#include <wx/wfstream.h>
+
+// Save the state after this many bytes so little is lost if MultiMC dies.
+const wxFileOffset stateSaveInterval = 1024 * 1024;
+
+const wxString stateHeader = "MultiMC partial download 1";
+
+static wxString EncodeHex(const unsigned char *data, size_t len)
+{
+	wxString str;
+	for (size_t i = 0; i < len; i++)
+		str << wxString::Format("%02x", data[i]);
+	return str;
+}
+
+static bool DecodeHex(const wxString &str, unsigned char *data, size_t len)
+{
+	if (str.Len() != len * 2)
+		return false;
+	for (size_t i = 0; i < len; i++)
+	{
+		unsigned long value;
+		if (!str.Mid(i * 2, 2).ToULong(&value, 16))
+			return false;
+		data[i] = (unsigned char)value;
+	}
+	return true;
+}
+
+PartialDownload::PartialDownload(const wxFileName &dest)
+	: m_dest(dest), m_offset(0), m_savedOffset(0), m_checkedResponse(false), m_headers(nullptr)
+{
+	MD5Init(&m_md5ctx);
+}
+
+PartialDownload::~PartialDownload()
+{
+	if (m_file.IsOpened())
+	{
+		SaveState();
+		m_file.Close();
+	}
+	curl_slist_free_all(m_headers);
+}
+
+wxString PartialDownload::GetPartPath() const
+{
+	return m_dest.GetFullPath() + ".part";
+}
+
+wxString PartialDownload::GetStatePath() const
+{
+	return m_dest.GetFullPath() + ".part.state";
+}
+
+bool PartialDownload::Open(const wxString &etag)
+{
+	if (m_file.IsOpened())
+		m_file.Close();
+
+	m_etag = etag;
+	m_md5.Empty();
+	m_checkedResponse = false;
+	m_offset = 0;
+	MD5Init(&m_md5ctx);
+
+	// Try to pick up the last state. Without a strong ETag there's no telling 
+	// whether the file changed since then.
+	bool resume = false;
+	if (!etag.IsEmpty() && !etag.StartsWith("W/") && 
+		wxFileExists(GetStatePath()) && wxFileExists(GetPartPath()))
+	{
+		wxFFileInputStream inStream(GetStatePath());
+		wxArrayString lines = ReadAllLines(inStream);
+
+		wxLongLong_t offset;
+		if (lines.size() == 4 && lines[0] == stateHeader && lines[1].ToLongLong(&offset) &&
+			lines[2] == etag && DecodeHex(lines[3], (unsigned char*)&m_md5ctx, sizeof(m_md5ctx)))
+		{
+			// Anything written after the state was saved is overwritten.
+			m_offset = offset;
+			wxULongLong partSize = wxFileName::GetSize(GetPartPath());
+			resume = m_offset > 0 && partSize != wxInvalidSize && 
+				partSize >= wxULongLong((wxULongLong_t)m_offset);
+		}
+	}
+
+	if (resume && m_file.Open(GetPartPath(), wxFile::read_write) && 
+		m_file.Seek(m_offset) == m_offset)
+	{
+		m_savedOffset = m_offset;
+		return true;
+	}
+
+	// Start over.
+	if (m_file.IsOpened())
+		m_file.Close();
+	m_offset = 0;
+	m_savedOffset = 0;
+	MD5Init(&m_md5ctx);
+	wxRemoveFile(GetStatePath());
+	return m_file.Create(GetPartPath(), true);
+}
+
+void PartialDownload::SetupCurl(CURL *curl)
+{
+	m_checkedResponse = false;
+	curl_easy_setopt(curl, CURLOPT_RESUME_FROM_LARGE, (curl_off_t)m_offset);
+
+	// If the file changed, the server sends all of it instead of the range.
+	curl_slist_free_all(m_headers);
+	m_headers = nullptr;
+	if (m_offset > 0 && !m_etag.IsEmpty())
+		m_headers = curl_slist_append(m_headers, stdStr("If-Range: \"" + m_etag + "\"").c_str());
+	curl_easy_setopt(curl, CURLOPT_HTTPHEADER, m_headers);
+}
+
+size_t PartialDownload::Write(CURL *curl, void *buffer, size_t size)
+{
+	if (!m_file.IsOpened())
+		return 0;
+
+	if (!m_checkedResponse)
+	{
+		m_checkedResponse = true;
+
+		long response = 0;
+		curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response);
+		if (m_offset > 0 && response != 206)
+		{
+			// The server sent the whole file, or couldn't serve the range.
+			Reset();
+			if (response != 200)
+				return 0;
+		}
+	}
+
+	size_t written = m_file.Write(buffer, size);
+	MD5Update(&m_md5ctx, (unsigned char*)buffer, written);
+	m_offset += written;
+
+	if (m_offset - m_savedOffset >= stateSaveInterval)
+		SaveState();
+	return written;
+}
+
+bool PartialDownload::SaveState()
+{
+	if (!m_file.IsOpened() || !m_file.Flush())
+		return false;
+
+	wxString text;
+	text << stateHeader << "\n" << wxString::Format("%" wxLongLongFmtSpec "d", (wxLongLong_t)m_offset) << "\n"
+		<< m_etag << "\n" << EncodeHex((const unsigned char*)&m_md5ctx, sizeof(m_md5ctx)) << "\n";
+
+	wxTempFileOutputStream out(GetStatePath());
+	WriteAllText(out, text);
+	if (!out.Commit())
+		return false;
+
+	m_savedOffset = m_offset;
+	return true;
+}
+
+void PartialDownload::Reset()
+{
+	if (m_file.IsOpened())
+		m_file.Close();
+	wxRemoveFile(GetStatePath());
+
+	m_offset = 0;
+	m_savedOffset = 0;
+	MD5Init(&m_md5ctx);
+	m_file.Create(GetPartPath(), true);
+}
+
+void PartialDownload::Discard()
+{
+	if (m_file.IsOpened())
+		m_file.Close();
+	wxRemoveFile(GetStatePath());
+	wxRemoveFile(GetPartPath());
+
+	m_offset = 0;
+	m_savedOffset = 0;
+	MD5Init(&m_md5ctx);
+}
+
+bool PartialDownload::Finish()
+{
+	if (!m_file.IsOpened())
+		return false;
+	bool closed = m_file.Close();
+
+	unsigned char md5digest[16];
+	MD5Final(md5digest, &m_md5ctx);
+	m_md5 = Utils::BytesToString(md5digest);
+
+	wxRemoveFile(GetStatePath());
+	return closed;
+}
+
+bool PartialDownload::Commit()
+{
+	if (m_file.IsOpened() && !Finish())
+		return false;
+	if (!wxFileExists(GetPartPath()))
+		return false;
+
+	if (m_dest.FileExists())
+		wxRemoveFile(m_dest.GetFullPath());
+	return wxRenameFile(GetPartPath(), m_dest.GetFullPath(), true);
+}
@@ -0,0 +1,84 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#pragma once
+#include <wx/string.h>
+#include <wx/filename.h>
+#include <wx/file.h>
+
+#include <md5/md5.h>
+
+#include "curlutils.h"
+
+// A download that goes to <dest>.part and can be resumed with an HTTP Range
+// request after it fails. A later session only resumes it if the server gave
+// a strong ETag, which is sent in If-Range so a changed file comes back whole.
+// The MD5 context of the data written so far is saved in <dest>.part.state, 
+// so the checksum stays correct without reading the partial file again.
+class PartialDownload
+{
+public:
+	PartialDownload(const wxFileName &dest);
+	~PartialDownload();
+
+	// Opens the part file. Continues where the last attempt stopped if its
+	// state is valid and was saved for the same strong ETag. Otherwise starts over.
+	bool Open(const wxString &etag = wxEmptyString);
+
+	// Makes the curl handle request only the missing part of the file.
+	// Sets CURLOPT_HTTPHEADER. Call this before every attempt.
+	void SetupCurl(CURL *curl);
+
+	// Writes downloaded data. Call this from the curl write callback.
+	// If the server ignored the Range request, the download starts over.
+	size_t Write(CURL *curl, void *buffer, size_t size);
+
+	// Saves the state so the download can be resumed later.
+	bool SaveState();
+
+	// Throws away everything downloaded so far.
+	void Reset();
+
+	// Closes and deletes the part file and its state.
+	void Discard();
+
+	// Closes the part file and removes the state.
+	// The MD5 sum of the whole file is available after this.
+	bool Finish();
+
+	// Moves the finished file to its destination, replacing the old file.
+	bool Commit();
+
+	// Number of bytes already in the part file.
+	wxFileOffset GetOffset() const { return m_offset; }
+
+	// Lower case hex MD5 sum of the file. Only valid after Finish.
+	wxString GetMD5() const { return m_md5; }
+
+protected:
+	wxString GetPartPath() const;
+	wxString GetStatePath() const;
+
+	wxFileName m_dest;
+	wxString m_etag;
+	wxString m_md5;
+	wxFile m_file;
+	MD5Context m_md5ctx;
+	wxFileOffset m_offset;
+	wxFileOffset m_savedOffset;
+	bool m_checkedResponse;
+	struct curl_slist *m_headers;
+};
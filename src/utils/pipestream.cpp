@@ -0,0 +1,97 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "pipestream.h"
+
+#include <algorithm>
+#include <cstring>
+
+PipeInputStream::PipeInputStream(size_t bufferSize)
+	: m_buffer(bufferSize), m_readPos(0), m_fill(0), m_closed(false), m_aborted(false),
+	  m_changed(m_mutex)
+{
+	
+}
+
+bool PipeInputStream::Feed(const void *buffer, size_t size)
+{
+	const char *data = (const char *)buffer;
+
+	wxMutexLocker lock(m_mutex);
+	while (size > 0)
+	{
+		while (m_fill == m_buffer.size() && !m_aborted)
+			m_changed.Wait();
+		if (m_aborted || m_closed)
+			return false;
+
+		// Copy as much as fits behind the unread data, wrapping around the end.
+		size_t writePos = (m_readPos + m_fill) % m_buffer.size();
+		size_t count = std::min(size, std::min(m_buffer.size() - m_fill, m_buffer.size() - writePos));
+		memcpy(&m_buffer[writePos], data, count);
+
+		m_fill += count;
+		data += count;
+		size -= count;
+		m_changed.Broadcast();
+	}
+	return true;
+}
+
+void PipeInputStream::CloseWrite()
+{
+	wxMutexLocker lock(m_mutex);
+	m_closed = true;
+	m_changed.Broadcast();
+}
+
+void PipeInputStream::Abort()
+{
+	wxMutexLocker lock(m_mutex);
+	m_aborted = true;
+	m_changed.Broadcast();
+}
+
+bool PipeInputStream::IsAborted() const
+{
+	wxMutexLocker lock(m_mutex);
+	return m_aborted;
+}
+
+size_t PipeInputStream::OnSysRead(void *buffer, size_t size)
+{
+	wxMutexLocker lock(m_mutex);
+	while (m_fill == 0 && !m_closed && !m_aborted)
+		m_changed.Wait();
+
+	if (m_aborted)
+	{
+		m_lasterror = wxSTREAM_READ_ERROR;
+		return 0;
+	}
+	if (m_fill == 0)
+	{
+		m_lasterror = wxSTREAM_EOF;
+		return 0;
+	}
+
+	size_t count = std::min(size, std::min(m_fill, m_buffer.size() - m_readPos));
+	memcpy(buffer, &m_buffer[m_readPos], count);
+	m_readPos = (m_readPos + count) % m_buffer.size();
+	m_fill -= count;
+	m_changed.Broadcast();
+	return count;
+}
@@ -0,0 +1,55 @@
+// 
+//  Copyright 2012 MultiMC Contributors
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//        http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#pragma once
+#include <wx/stream.h>
+#include <wx/thread.h>
+
+#include <vector>
+
+// An input stream that is fed from another thread.
+// Reads block until data is written, the writer closes the pipe or the pipe is aborted.
+// Writes block while the buffer is full, so memory use stays bounded.
+class PipeInputStream : public wxInputStream
+{
+public:
+	PipeInputStream(size_t bufferSize = 1024 * 1024);
+
+	// Called by the writer. Returns false if the pipe was aborted.
+	bool Feed(const void *buffer, size_t size);
+
+	// Called by the writer after the last write. The reader gets EOF once the buffer is empty.
+	void CloseWrite();
+
+	// Makes both sides fail. Can be called from either thread.
+	void Abort();
+
+	bool IsAborted() const;
+
+	virtual bool IsSeekable() const { return false; }
+
+protected:
+	virtual size_t OnSysRead(void *buffer, size_t size);
+
+	std::vector<char> m_buffer;
+	size_t m_readPos;
+	size_t m_fill;
+	bool m_closed;
+	bool m_aborted;
+
+	mutable wxMutex m_mutex;
+	wxCondition m_changed;
+};
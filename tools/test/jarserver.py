@@ -0,0 +1,293 @@
+#!/usr/bin/env python3
+#
+#  Copyright 2012 MultiMC Contributors
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+#
+
+"""
+jarserver.py [options] <dir>
+    Stands in for the S3 bucket GameUpdateTask downloads the game jars from.
+    Serves the files in <dir> with MD5 ETags, If-None-Match and byte ranges
+    like S3 does. It can break transfers on purpose and checks what the
+    downloader did once it goes idle.
+
+    -p, --port N          port to listen on (default 8080)
+    -c, --connections N   the MaxDownloadConnections setting the client uses;
+                          more concurrent GETs than this is a failure
+    -f, --fail N          cut the first N GETs of each file off halfway
+    -m, --corrupt N       flip a byte in the next N GETs of each file that
+                          aren't cut off, so the MD5 sum doesn't match
+    -d, --delay MS        delay per request and per 64 KiB sent, so transfers
+                          overlap (default 50)
+    -i, --idle S          print the report and exit after S seconds without
+                          requests (default 10)
+    -g, --generate        create the jars GameUpdateTask asks for in <dir>
+                          (zips of random data) if they don't exist
+
+To run it against MultiMC, start it with -c set to MaxDownloadConnections:
+
+    python3 jarserver.py -g -c 4 -f 1 -m 1 /tmp/jars
+
+and pass its URL as the jarBaseURL argument of GameUpdateTask in a local
+build, e.g. "http://localhost:8080/" where MainWindow creates the task. Then
+launch an instance with "Force update" checked. See README.md.
+
+The report checks that:
+  - the HEAD requests were in flight at the same time,
+  - the GETs were in flight at the same time, but never more than -c,
+  - every file that was cut off or corrupted was requested again (a cut
+    off file with a Range header), and
+  - every file was finally sent in full.
+The exit status is 0 if all checks passed.
+"""
+
+import argparse
+import hashlib
+import os
+import random
+import sys
+import threading
+import time
+import zipfile
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+JARS = ["minecraft.jar", "lwjgl_util.jar", "jinput.jar", "lwjgl.jar",
+        "windows_natives.jar", "macosx_natives.jar", "linux_natives.jar"]
+CHUNK = 64 * 1024
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.active = {"HEAD": 0, "GET": 0}
+        self.peak = {"HEAD": 0, "GET": 0}
+        self.heads = {}
+        self.gets = {}
+        self.ranged = {}
+        self.cut = {}
+        self.corrupted = {}
+        self.complete = {}
+        self.last_request = time.time()
+
+    def begin(self, method):
+        with self.lock:
+            self.active[method] += 1
+            self.peak[method] = max(self.peak[method], self.active[method])
+            self.last_request = time.time()
+
+    def end(self, method):
+        with self.lock:
+            self.active[method] -= 1
+            self.last_request = time.time()
+
+    def count(self, table, name):
+        with self.lock:
+            table[name] = table.get(name, 0) + 1
+            return table[name]
+
+
+def generate(directory):
+    os.makedirs(directory, exist_ok=True)
+    for name in JARS:
+        path = os.path.join(directory, name)
+        if os.path.exists(path):
+            continue
+        with zipfile.ZipFile(path, "w", zipfile.ZIP_STORED) as jar:
+            for i in range(4):
+                jar.writestr("file%i.bin" % i, os.urandom(random.randint(128, 512) * 1024))
+
+
+def make_handler(args, stats, files):
+    class Handler(BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"
+
+        def log_message(self, fmt, *fmtargs):
+            sys.stderr.write("%s %s\n" % (self.command, fmt % fmtargs))
+
+        def lookup(self):
+            name = os.path.basename(self.path.split("?")[0])
+            if name not in files:
+                self.send_error(404)
+                return None, None
+            return name, files[name]
+
+        def send_head(self, name, info, start):
+            etag = '"%s"' % info["md5"]
+            if self.headers.get("If-None-Match") in (etag, info["md5"]):
+                self.send_response(304)
+                self.send_header("ETag", etag)
+                self.send_header("Content-Length", "0")
+                self.end_headers()
+                return False
+            size = len(info["data"])
+            if start > 0:
+                self.send_response(206)
+                self.send_header("Content-Range", "bytes %i-%i/%i" % (start, size - 1, size))
+            else:
+                self.send_response(200)
+            self.send_header("ETag", etag)
+            self.send_header("Content-Type", "application/java-archive")
+            self.send_header("Content-Length", str(size - start))
+            self.end_headers()
+            return True
+
+        def do_HEAD(self):
+            stats.begin("HEAD")
+            try:
+                time.sleep(args.delay / 1000.0)
+                name, info = self.lookup()
+                if name:
+                    stats.count(stats.heads, name)
+                    self.send_head(name, info, 0)
+            finally:
+                stats.end("HEAD")
+
+        def do_GET(self):
+            stats.begin("GET")
+            active = True
+            try:
+                time.sleep(args.delay / 1000.0)
+                name, info = self.lookup()
+                if not name:
+                    return
+                stats.count(stats.gets, name)
+
+                start = 0
+                ranges = self.headers.get("Range", "")
+                if ranges.startswith("bytes=") and ranges.endswith("-"):
+                    start = int(ranges[6:-1])
+                    stats.count(stats.ranged, name)
+                data = info["data"]
+                if start >= len(data):
+                    self.send_error(416)
+                    return
+                if not self.send_head(name, info, start):
+                    return
+
+                body = data[start:]
+                end = len(body)
+                corrupt = False
+                if stats.cut.get(name, 0) < args.fail:
+                    stats.count(stats.cut, name)
+                    end = len(body) // 2
+                elif stats.corrupted.get(name, 0) < args.corrupt:
+                    stats.count(stats.corrupted, name)
+                    corrupt = True
+                    flipped = bytearray(body)
+                    flipped[len(flipped) // 2] ^= 0xff
+                    body = bytes(flipped)
+
+                for pos in range(0, end, CHUNK):
+                    if pos > 0:
+                        time.sleep(args.delay / 1000.0)
+                    if pos + CHUNK >= len(body):
+                        # The client may start its next request as soon as it has the
+                        # last byte, so this one is over for the connection limit.
+                        stats.end("GET")
+                        active = False
+                    self.wfile.write(body[pos:min(pos + CHUNK, end)])
+                    self.wfile.flush()
+
+                if end < len(body):
+                    # Let the client see a transfer that ended early.
+                    self.close_connection = True
+                    return
+                if not corrupt:
+                    stats.count(stats.complete, name)
+            except (BrokenPipeError, ConnectionResetError):
+                pass
+            finally:
+                if active:
+                    stats.end("GET")
+
+    return Handler
+
+
+def report(args, stats, files):
+    ok = True
+
+    def check(cond, msg):
+        nonlocal ok
+        print("%s %s" % ("ok  " if cond else "FAIL", msg))
+        ok = ok and cond
+
+    print("peak concurrent HEADs: %i, peak concurrent GETs: %i" % (stats.peak["HEAD"], stats.peak["GET"]))
+    for name in sorted(stats.gets):
+        print("  %-20s HEAD %i  GET %i  ranged %i  cut %i  corrupted %i  complete %i" % (
+            name, stats.heads.get(name, 0), stats.gets[name], stats.ranged.get(name, 0),
+            stats.cut.get(name, 0), stats.corrupted.get(name, 0), stats.complete.get(name, 0)))
+
+    requested = [name for name in files if name in stats.heads]
+    check(len(requested) > 1, "more than one file was requested")
+    check(stats.peak["HEAD"] > 1, "HEAD requests overlapped")
+    check(stats.peak["GET"] > 1 or len(stats.gets) < 2, "GET requests overlapped")
+    if args.connections:
+        check(stats.peak["GET"] <= args.connections,
+              "at most %i GETs at a time" % args.connections)
+    for name in stats.gets:
+        if stats.cut.get(name, 0):
+            check(stats.ranged.get(name, 0) > 0, "%s was resumed after being cut off" % name)
+        if stats.corrupted.get(name, 0):
+            check(stats.gets[name] > stats.corrupted[name] + stats.cut.get(name, 0),
+                  "%s was requested again after the MD5 mismatch" % name)
+        check(stats.complete.get(name, 0) > 0, "%s was sent in full" % name)
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(usage=__doc__)
+    parser.add_argument("dir")
+    parser.add_argument("-p", "--port", type=int, default=8080)
+    parser.add_argument("-c", "--connections", type=int, default=0)
+    parser.add_argument("-f", "--fail", type=int, default=0)
+    parser.add_argument("-m", "--corrupt", type=int, default=0)
+    parser.add_argument("-d", "--delay", type=int, default=50)
+    parser.add_argument("-i", "--idle", type=float, default=10)
+    parser.add_argument("-g", "--generate", action="store_true")
+    args = parser.parse_args()
+
+    if args.generate:
+        generate(args.dir)
+
+    files = {}
+    for name in os.listdir(args.dir):
+        path = os.path.join(args.dir, name)
+        if os.path.isfile(path):
+            with open(path, "rb") as f:
+                data = f.read()
+            files[name] = {"data": data, "md5": hashlib.md5(data).hexdigest()}
+
+    stats = Stats()
+    server = ThreadingHTTPServer(("127.0.0.1", args.port), make_handler(args, stats, files))
+    server.daemon_threads = True
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    print("serving %i files from %s on http://127.0.0.1:%i/" % (len(files), args.dir, server.server_port))
+    sys.stdout.flush()
+
+    try:
+        while True:
+            time.sleep(0.5)
+            with stats.lock:
+                idle = time.time() - stats.last_request
+                busy = stats.active["HEAD"] + stats.active["GET"]
+            if stats.heads and not busy and idle >= args.idle:
+                break
+    except KeyboardInterrupt:
+        pass
+    server.shutdown()
+    sys.exit(0 if report(args, stats, files) else 1)
+
+
+if __name__ == "__main__":
+    main()